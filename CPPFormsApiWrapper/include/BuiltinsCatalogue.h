@@ -0,0 +1,86 @@
+#ifndef BUILTINSCATALOGUE_H
+#define BUILTINSCATALOGUE_H
+
+#include "dllmain.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+namespace CPPFAPIWrapper {
+	/** OracleForms built-ins program units of a given Forms API version, with fast case insensitive lookup of
+	* built-in names. Catalogue can be saved to a file, so built-ins don't have to be enumerated by
+	* d2fctxbi_BuiltIns (slow, leaks memory) in every process.
+	*/
+	class BuiltinsCatalogue
+	{
+	public:
+		/** Creates empty catalogue */
+		CPPFAPIWRAPPER BuiltinsCatalogue();
+
+		/** Fills catalogue with built-ins
+		*
+		* \param _version Forms API version (d2fctxbv_BuilderVersion)
+		* \param _packages Built-ins program units sorted by package names
+		*/
+		CPPFAPIWRAPPER void build(const uint32_t _version, const std::unordered_map<std::string, std::vector<std::string>> & _packages);
+
+		/** Loads catalogue from a file
+		*
+		* \param _filepath Path to catalogue file
+		* \param _version Expected Forms API version
+		* \return False if file doesn't exist, is invalid or incomplete, or was made by another Forms API version
+		*/
+		CPPFAPIWRAPPER bool load(const std::string & _filepath, const uint32_t _version);
+
+		/** Saves catalogue to a file. File ends with number of packages and their hash, checked by load, and replaces
+		* old file only when it was written completely.
+		*
+		* \param _filepath Path to catalogue file
+		*/
+		CPPFAPIWRAPPER void save(const std::string & _filepath) const;
+
+		/** Checks if identifier is a built-in program unit (case insensitive). Both unqualified (SET_ITEM_PROPERTY)
+		* and qualified by package (WEB.SHOW_DOCUMENT) names are recognised.
+		*
+		* \param _name Identifier
+		* \return True if identifier is a built-in
+		*/
+		CPPFAPIWRAPPER bool contains(std::string_view _name) const;
+
+		/** Checks if catalogue was filled
+		*
+		* \return True if catalogue has no built-ins
+		*/
+		CPPFAPIWRAPPER bool isEmpty() const;
+
+		/** Gets Forms API version of built-ins
+		*
+		* \return Forms API version, 0 for empty catalogue
+		*/
+		CPPFAPIWRAPPER uint32_t getVersion() const;
+
+		/** Gets built-ins program units
+		*
+		* \return Built-ins program units sorted by package names
+		*/
+		CPPFAPIWRAPPER const std::unordered_map<std::string, std::vector<std::string>> & getPackages() const;
+
+		/** Gets path of catalogue file for a given Forms API version
+		*
+		* \param _directory Directory with catalogue files
+		* \param _version Forms API version
+		* \return Path to catalogue file
+		*/
+		CPPFAPIWRAPPER static std::string cataloguePath(const std::string & _directory, const uint32_t _version);
+
+	private:
+		uint32_t version;
+		std::unordered_map<std::string, std::vector<std::string>> packages;
+		std::vector<std::string> names;		// upper case, sorted
+	};
+}
+
+#endif // BUILTINSCATALOGUE_H
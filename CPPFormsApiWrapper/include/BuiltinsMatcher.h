@@ -0,0 +1,93 @@
+#ifndef BUILTINSMATCHER_H
+#define BUILTINSMATCHER_H
+
+#include "dllmain.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <array>
+#include <cstdint>
+
+namespace CPPFAPIWrapper {
+	class BuiltinsCatalogue;
+	class FAPIModule;
+
+	struct BuiltinsUnitUsage {
+		int type_id;							// D2FFO_TRIGGER, D2FFO_PROG_UNIT or D2FFO_LIB_PROG_UNIT
+		std::string object;						// full name of trigger/program unit
+		std::map<std::string, size_t> builtins;	// uppercase built-in name as written (qualified or not), number of uses
+	};
+
+	struct BuiltinsReport {
+		std::string module;						// path to module
+		std::vector<BuiltinsUnitUsage> units;	// units using any built-in
+		std::map<std::string, size_t> totals;	// uses of built-ins in whole module
+	};
+
+	/** Finds uses of all built-ins of a catalogue in PLSQL code in a single pass. Catalogue names (unqualified and
+	* qualified by package) are compiled into Aho-Corasick automaton, so matching time doesn't depend on number of
+	* built-ins. Names are matched case-insensitively, only as whole identifiers; comments, string literals and quoted
+	* identifiers are skipped. Matcher is immutable once built and can be shared by threads.
+	*/
+	class BuiltinsMatcher
+	{
+	public:
+		/** Compiles automaton of built-ins names
+		*
+		* \param _catalogue Built-ins catalogue
+		*/
+		CPPFAPIWRAPPER explicit BuiltinsMatcher(const BuiltinsCatalogue & _catalogue);
+
+		/** Finds built-ins used in code
+		*
+		* \param _code PLSQL code
+		* \param _matches Collection ids of found built-ins (see getName) are appended to, in order of occurrence
+		*/
+		CPPFAPIWRAPPER void match(std::string_view _code, std::vector<uint32_t> & _matches) const;
+
+		/** Counts uses of built-ins in code
+		*
+		* \param _code PLSQL code
+		* \return Uppercase built-in names and their number of uses
+		*/
+		CPPFAPIWRAPPER std::map<std::string, size_t> countBuiltins(std::string_view _code) const;
+
+		/** Counts uses of built-ins in triggers and program units of a module
+		*
+		* \param _module Traversed module or library
+		* \return Report with uses per unit and in whole module
+		*/
+		CPPFAPIWRAPPER BuiltinsReport analyseModule(const FAPIModule & _module) const;
+
+		/** Gets name of found built-in
+		*
+		* \param _id Id passed to match
+		* \return Uppercase name, qualified by package if it was written so
+		*/
+		CPPFAPIWRAPPER const std::string & getName(const uint32_t _id) const;
+
+		/** Gets number of matched names
+		*
+		* \return Number of unqualified and qualified names of built-ins
+		*/
+		CPPFAPIWRAPPER size_t size() const;
+
+		BuiltinsMatcher(const BuiltinsMatcher & _matcher) = delete;
+		BuiltinsMatcher & operator=(const BuiltinsMatcher & _matcher) = delete;
+
+	private:
+		void addName(const std::string & _name);
+		void link();
+
+		std::array<uint8_t, 256> symbols;		// symbol of character (case folded), 0 if no name contains it
+		size_t alphabet;						// number of symbols, including 0
+		std::vector<uint32_t> transitions;		// state * alphabet + symbol, next state (complete, failures resolved)
+		std::vector<uint32_t> outputs;			// name ending in state, NO_MATCH if none
+		std::vector<uint32_t> suffixes;			// nearest state on failure chain with output, 0 if none
+		std::vector<std::string> names;
+	};
+}
+
+#endif // BUILTINSMATCHER_H
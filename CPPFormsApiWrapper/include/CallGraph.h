@@ -0,0 +1,151 @@
+#ifndef CALLGRAPH_H
+#define CALLGRAPH_H
+
+#include "dllmain.h"
+#include "FAPIUtil.h"
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+namespace CPPFAPIWrapper {
+	class FAPIContext;
+	class FAPIModule;
+
+	struct CallGraphUnit {
+		std::string module;		// path to module
+		int type_id;			// D2FFO_TRIGGER, D2FFO_PROG_UNIT or D2FFO_LIB_PROG_UNIT
+		std::string object;		// full name of trigger/program unit
+	};
+
+	/** Call graph of triggers and program units of forms and libraries. Edges are identifier references found in
+	* tokens of units (see FormsObject::getTokens): every unit references names it uses, qualified names (PKG.PROC)
+	* are referenced together with their package. References inside a package body belong to its subprogram
+	* (PKG.PROC), unqualified calls of other subprograms of the package are qualified. Units are kept as adjacency
+	* arrays of interned names, callers of a name are kept in reverse lists updated per module. Modules are replaced
+	* as a whole, only when fingerprint of their file changes.
+	*/
+	class CallGraph
+	{
+	public:
+		/** Creates empty graph */
+		CPPFAPIWRAPPER CallGraph();
+
+		/** Adds traversed modules and libraries of a context, which changed since they were added
+		*
+		* \param _ctx Context
+		* \return Number of added modules
+		*/
+		CPPFAPIWRAPPER size_t update(FAPIContext & _ctx);
+
+		/** Adds modules (.fmb) and libraries (.pll) which changed since they were added. Modules which are not loaded
+		* in context are loaded and removed afterwards.
+		*
+		* \param _ctx Context
+		* \param _filepaths Paths to modules and libraries
+		* \param _ignore_missing_libs If True, modules will be loaded regardless of missing PLSQL libraries (.pll)
+		* \param _ignore_missing_sub If True, modules will be loaded regardless of missing subobjects
+		* \return Number of added modules
+		*/
+		CPPFAPIWRAPPER size_t update(FAPIContext & _ctx, const std::vector<std::string> & _filepaths, const bool _ignore_missing_libs = true, const bool _ignore_missing_sub = true);
+
+		/** Adds module regardless of its fingerprint, replacing its previous units. Call after module is reloaded.
+		*
+		* \param _module Traversed module or library
+		*/
+		CPPFAPIWRAPPER void updateModule(const FAPIModule & _module);
+
+		/** Removes module from graph
+		*
+		* \param _filepath Path to module
+		*/
+		CPPFAPIWRAPPER void removeModule(const std::string & _filepath);
+
+		/** Checks if module is in graph
+		*
+		* \param _filepath Path to module
+		* \return True if module was added
+		*/
+		CPPFAPIWRAPPER bool hasModule(const std::string & _filepath) const;
+
+		/** Checks if module changed since it was added
+		*
+		* \param _filepath Path to module
+		* \return True if module wasn't added or content of its file changed
+		*/
+		CPPFAPIWRAPPER bool isOutdated(const std::string & _filepath);
+
+		/** Finds units calling a program unit (or using any other name), ignoring case. Transitive search continues
+		* from a caller inside a package body through its subprogram (PKG.PROC), from code outside of subprograms
+		* (declarations, initialization) through the whole package.
+		*
+		* \param _name Name of program unit, ex. MY_PROC, PKG or PKG.PROC
+		* \param _transitive If True, units calling callers which are program units are found as well
+		* \return Calling units, ordered by module and unit
+		*/
+		CPPFAPIWRAPPER std::vector<CallGraphUnit> getCallers(const std::string & _name, const bool _transitive = false) const;
+
+		/** Gets program units defined in graph which are called by a unit
+		*
+		* \param _filepath Path to module
+		* \param _object Full name of trigger/program unit
+		* \return Uppercase names of called program units (PKG.PROC for packaged subprograms), sorted
+		*/
+		CPPFAPIWRAPPER std::vector<std::string> getCallees(const std::string & _filepath, const std::string & _object) const;
+
+		/** Finds program units with a name
+		*
+		* \param _name Name of program unit, ignoring case
+		* \return Program units of all modules defining name
+		*/
+		CPPFAPIWRAPPER std::vector<CallGraphUnit> getDefinitions(const std::string & _name) const;
+
+		/** Gets number of modules in graph
+		*
+		* \return Number of modules
+		*/
+		CPPFAPIWRAPPER size_t getModuleCount() const;
+
+		/** Gets number of units in graph
+		*
+		* \return Number of triggers and program units
+		*/
+		CPPFAPIWRAPPER size_t getUnitCount() const;
+
+	private:
+		struct GraphModule {
+			FileFingerprint fingerprint;
+			std::vector<uint32_t> units;
+		};
+
+		struct GraphUnit {
+			std::string module;
+			int type_id;
+			std::string object;
+			uint32_t name;			// interned name of program unit, NO_IDENTIFIER for triggers
+			uint32_t refs_begin;	// range of referenced names in refs
+			uint32_t refs_end;
+			bool removed;
+		};
+
+		struct GraphCaller {
+			uint32_t unit;			// id of calling unit
+			uint32_t name;			// name transitive search continues from: program unit, PKG.PROC or NO_IDENTIFIER
+		};
+
+		void addModule(const FAPIModule & _module);
+		void eraseModule(const std::string & _filepath);
+		void compact();
+		std::vector<CallGraphUnit> toUnits(std::vector<uint32_t> _ids) const;
+
+		std::unordered_map<std::string, GraphModule> modules;
+		std::vector<GraphUnit> units;
+		std::vector<uint32_t> refs;					// referenced names of all units, sorted per unit
+		std::unordered_map<uint32_t, std::vector<GraphCaller>> callers;		// referenced name, its callers in order of unit ids, removed units are dropped by compact
+		std::unordered_map<uint32_t, std::vector<uint32_t>> definitions;	// name of program unit, ids of units
+		size_t removed_units;
+	};
+}
+
+#endif // CALLGRAPH_H
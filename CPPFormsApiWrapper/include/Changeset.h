@@ -0,0 +1,123 @@
+#ifndef CHANGESET_H
+#define CHANGESET_H
+
+#include "dllmain.h"
+
+#include <string>
+#include <vector>
+#include <utility>
+
+namespace CPPFAPIWrapper {
+	class FAPIModule;
+	class FormsObject;
+	class Property;
+
+	struct PropertyChange {
+		FAPIModule * module;	// module change was recorded on, nullptr if loaded from file
+		FormsObject * object;	// object in that module
+		int type_id;			// object type id
+		std::string fullname;	// object full name, empty for module object
+		int prop_id;
+		std::string old_value;
+		std::string new_value;
+	};
+
+	/** Staged property edits. Edits are recorded without touching the module, then applied all at once by commit
+	* (or not at all, if any of them can't be applied) and can be reverted by rollback. Objects are identified by
+	* type and full name too, so changeset can be saved, loaded and replayed against the same module in another
+	* context or process. Changesets prepared in parallel (reading modules only) can be joined by append.
+	*/
+	class Changeset
+	{
+	public:
+		/** Creates empty changeset */
+		CPPFAPIWRAPPER Changeset();
+
+		/** Records new value of object's property, current value is recorded as old value. Throws an exception if
+		* object has no such property.
+		*
+		* \param _object Object
+		* \param _prop_id OracleForms property id
+		* \param _value New value
+		*/
+		CPPFAPIWRAPPER void set(FormsObject * _object, const int _prop_id, const std::string & _value);
+
+		/** Appends changes of another changeset
+		*
+		* \param _changeset Uncommitted changeset
+		*/
+		CPPFAPIWRAPPER void append(const Changeset & _changeset);
+
+		/** Applies changes with Property::setValue (so properties are set in .fmb by saveModule). Nothing is applied
+		* and an exception is thrown if any object or property is missing, or (if _check_old is true) current value of
+		* any property differs from recorded old value.
+		*
+		* \param _module Module to change, objects are found by full names if it isn't the recorded one
+		* \param _check_old If True, conflicting current values fail the commit
+		*/
+		CPPFAPIWRAPPER void commit(FAPIModule * _module, const bool _check_old = true);
+
+		/** Restores values properties had before commit (which may differ from recorded old values, if commit didn't
+		* check them). Uncommitted changes are discarded.
+		*/
+		CPPFAPIWRAPPER void rollback();
+
+		/** Discards changes, committed changes stay applied */
+		CPPFAPIWRAPPER void clear();
+
+		/** Gets recorded changes
+		*
+		* \return Changes in order of recording
+		*/
+		CPPFAPIWRAPPER const std::vector<PropertyChange> & getChanges() const;
+
+		/** Gets number of changes
+		*
+		* \return Number of changes
+		*/
+		CPPFAPIWRAPPER size_t size() const;
+
+		/** Checks if changeset is empty
+		*
+		* \return True if there are no changes
+		*/
+		CPPFAPIWRAPPER bool isEmpty() const;
+
+		/** Checks if changes are applied
+		*
+		* \return True after commit, until rollback or clear
+		*/
+		CPPFAPIWRAPPER bool isCommitted() const;
+
+		/** Serialises changes as text, one change per line
+		*
+		* \return Serialised changes
+		*/
+		CPPFAPIWRAPPER std::string serialise() const;
+
+		/** Replaces changes with serialised ones. Throws an exception if text is malformed.
+		*
+		* \param _text Changes serialised by serialise
+		*/
+		CPPFAPIWRAPPER void deserialise(const std::string & _text);
+
+		/** Saves serialised changes to a file
+		*
+		* \param _filepath Path to changeset file
+		*/
+		CPPFAPIWRAPPER void save(const std::string & _filepath) const;
+
+		/** Loads changes from a file saved by save
+		*
+		* \param _filepath Path to changeset file
+		*/
+		CPPFAPIWRAPPER void load(const std::string & _filepath);
+
+	private:
+		std::vector<PropertyChange> changes;
+		std::vector<std::pair<Property *, std::string>> applied;	// properties changed by commit with values they had, in order of changes
+		bool committed;
+	};
+}
+
+#endif // CHANGESET_H
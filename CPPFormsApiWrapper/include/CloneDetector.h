@@ -0,0 +1,95 @@
+#ifndef CLONEDETECTOR_H
+#define CLONEDETECTOR_H
+
+#include "dllmain.h"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
+
+namespace CPPFAPIWrapper {
+	class FAPIContext;
+	class FAPIModule;
+
+	struct CloneLocation {
+		std::string module;		// path to module
+		int type_id;			// D2FFO_TRIGGER, D2FFO_PROG_UNIT or D2FFO_LIB_PROG_UNIT
+		std::string object;		// full name of trigger/program unit
+		size_t first_line;		// lines of duplicated code, starting from 1
+		size_t last_line;
+	};
+
+	struct CloneCluster {
+		size_t tokens;			// length of duplicated code in tokens
+		bool whole_unit;		// True if whole units are duplicates, False for fragments
+		std::vector<CloneLocation> locations;
+	};
+
+	/** Finds duplicated PLSQL code of triggers and program units across modules and libraries. Units are compared
+	* as normalised token streams (see FormsObject::getTokens), so case, whitespace and comments don't matter;
+	* optionally names and literals are ignored as well, so copies with renamed variables are found. Windows of
+	* minimal clone length are fingerprinted with a rolling hash, equal windows are verified and extended to whole
+	* duplicated fragments. If some copies of a fragment are longer than others, they are reported once more as a
+	* cluster of that longer length. Units which are duplicates as a whole are reported once as a whole-unit cluster
+	* and represented by their first unit in fragment clusters.
+	*/
+	class CloneDetector
+	{
+	public:
+		/** Creates empty detector
+		*
+		* \param _min_tokens Minimal length of reported duplicates, in tokens
+		* \param _ignore_names If True, identifiers, numbers and string literals are compared by kind only
+		*/
+		CPPFAPIWRAPPER explicit CloneDetector(const size_t _min_tokens = 50, const bool _ignore_names = false);
+
+		/** Adds triggers and program units of a module, replacing units added before for the same module
+		*
+		* \param _module Traversed module or library
+		*/
+		CPPFAPIWRAPPER void addModule(const FAPIModule & _module);
+
+		/** Adds traversed modules and libraries of a context
+		*
+		* \param _ctx Context
+		* \return Number of added modules
+		*/
+		CPPFAPIWRAPPER size_t addModules(FAPIContext & _ctx);
+
+		/** Removes units of a module
+		*
+		* \param _filepath Path to module
+		*/
+		CPPFAPIWRAPPER void removeModule(const std::string & _filepath);
+
+		/** Finds duplicated code among added units
+		*
+		* \return Whole-unit clusters followed by fragment clusters, both ordered from longest
+		*/
+		CPPFAPIWRAPPER std::vector<CloneCluster> findClones() const;
+
+		/** Gets number of added units
+		*
+		* \return Number of triggers and program units
+		*/
+		CPPFAPIWRAPPER size_t getUnitCount() const;
+
+	private:
+		struct CloneUnit {
+			std::string module;
+			int type_id;
+			std::string object;
+			std::vector<uint64_t> values;	// normalised tokens
+			std::vector<uint32_t> lines;	// line of every token
+		};
+
+		CloneLocation locate(const CloneUnit & _unit, const size_t _first, const size_t _length) const;
+
+		size_t min_tokens;
+		bool ignore_names;
+		std::map<std::string, std::vector<CloneUnit>> modules;
+	};
+}
+
+#endif // CLONEDETECTOR_H
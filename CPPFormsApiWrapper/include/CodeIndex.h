@@ -0,0 +1,147 @@
+#ifndef CODEINDEX_H
+#define CODEINDEX_H
+
+#include "dllmain.h"
+#include "FAPIUtil.h"
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <functional>
+
+namespace CPPFAPIWrapper {
+	class FAPIContext;
+	class FAPIModule;
+
+	struct CodeHit {
+		std::string module;		// path to module
+		int type_id;			// D2FFO_TRIGGER, D2FFO_PROG_UNIT or D2FFO_LIB_PROG_UNIT
+		std::string object;		// full name of trigger/program unit
+		size_t line;			// line of match, starting from 1
+		std::string text;		// whole line
+	};
+
+	/** Full-text index over PLSQL code (triggers and program units) of forms and libraries. Every unit is indexed by
+	* case-insensitive trigrams of its text, so queries check only units containing all trigrams of searched text.
+	* Modules are reindexed only when fingerprint of their file changes. Index can be saved to a file and loaded in
+	* later sessions; saved are code and fingerprints, trigrams are rebuilt while loading.
+	*/
+	class CodeIndex
+	{
+	public:
+		/** Creates empty index */
+		CPPFAPIWRAPPER CodeIndex();
+
+		/** Indexes traversed modules and libraries of a context, which changed since they were indexed
+		*
+		* \param _ctx Context
+		* \return Number of indexed modules
+		*/
+		CPPFAPIWRAPPER size_t update(FAPIContext & _ctx);
+
+		/** Indexes modules (.fmb) and libraries (.pll) which changed since they were indexed. Modules which are not
+		* loaded in context are loaded for indexing and removed afterwards.
+		*
+		* \param _ctx Context
+		* \param _filepaths Paths to modules and libraries
+		* \param _ignore_missing_libs If True, modules will be loaded regardless of missing PLSQL libraries (.pll)
+		* \param _ignore_missing_sub If True, modules will be loaded regardless of missing subobjects
+		* \return Number of indexed modules
+		*/
+		CPPFAPIWRAPPER size_t update(FAPIContext & _ctx, const std::vector<std::string> & _filepaths, const bool _ignore_missing_libs = true, const bool _ignore_missing_sub = true);
+
+		/** Indexes module regardless of its fingerprint, replacing its previous code
+		*
+		* \param _module Traversed module or library
+		*/
+		CPPFAPIWRAPPER void indexModule(const FAPIModule & _module);
+
+		/** Removes module from index
+		*
+		* \param _filepath Path to module
+		*/
+		CPPFAPIWRAPPER void removeModule(const std::string & _filepath);
+
+		/** Checks if module is indexed
+		*
+		* \param _filepath Path to module
+		* \return True if module is indexed
+		*/
+		CPPFAPIWRAPPER bool hasModule(const std::string & _filepath) const;
+
+		/** Checks if module changed since it was indexed
+		*
+		* \param _filepath Path to module
+		* \return True if module isn't indexed or content of its file changed
+		*/
+		CPPFAPIWRAPPER bool isOutdated(const std::string & _filepath);
+
+		/** Finds lines containing text, ignoring case
+		*
+		* \param _text Searched text
+		* \return Hits, one per line, ordered by module and unit
+		*/
+		CPPFAPIWRAPPER std::vector<CodeHit> find(const std::string & _text) const;
+
+		/** Finds lines matching ECMAScript regular expression. Expression is matched against every line separately, so
+		* ^ and $ anchor at line boundaries. Literal parts of expression are used to narrow searched units, expressions
+		* with alternatives are matched against all units.
+		*
+		* \param _pattern Regular expression
+		* \param _icase If True, case is ignored
+		* \return Hits, one per line, ordered by module and unit
+		*/
+		CPPFAPIWRAPPER std::vector<CodeHit> findRegex(const std::string & _pattern, const bool _icase = true) const;
+
+		/** Gets number of indexed modules
+		*
+		* \return Number of modules
+		*/
+		CPPFAPIWRAPPER size_t getModuleCount() const;
+
+		/** Gets number of indexed units
+		*
+		* \return Number of triggers and program units
+		*/
+		CPPFAPIWRAPPER size_t getUnitCount() const;
+
+		/** Saves index to a file
+		*
+		* \param _filepath Path to index file
+		*/
+		CPPFAPIWRAPPER void save(const std::string & _filepath) const;
+
+		/** Replaces index with one saved by save. Throws an exception if file is malformed.
+		*
+		* \param _filepath Path to index file
+		*/
+		CPPFAPIWRAPPER void load(const std::string & _filepath);
+
+	private:
+		struct IndexedModule {
+			FileFingerprint fingerprint;
+			std::vector<uint32_t> units;
+		};
+
+		struct IndexedUnit {
+			std::string module;
+			int type_id;
+			std::string object;
+			std::string code;
+			bool removed;
+		};
+
+		void addModule(const std::string & _filepath, const FileFingerprint & _fingerprint, std::vector<IndexedUnit> _units);
+		void addTrigrams(const uint32_t _unit);
+		void compact();
+		std::vector<uint32_t> findCandidates(const std::vector<std::string> & _literals) const;
+		std::vector<CodeHit> collectHits(const std::vector<uint32_t> & _candidates, std::function<void(const std::string &, std::vector<size_t> &)> _match) const;
+
+		std::unordered_map<std::string, IndexedModule> modules;
+		std::vector<IndexedUnit> units;
+		std::unordered_map<uint32_t, std::vector<uint32_t>> trigrams;	// trigram of uppercase code, ids of units in ascending order
+		size_t removed_units;
+	};
+}
+
+#endif // CODEINDEX_H
@@ -0,0 +1,129 @@
+#ifndef CONTEXTPOOL_H
+#define CONTEXTPOOL_H
+
+#include "dllmain.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+namespace CPPFAPIWrapper {
+	class FAPIContext;
+	class ContextPool;
+
+	/** Exclusive access to a context from ContextPool. Context is reset and returned to the pool when lease is
+	* destroyed (or released), so it must not be used afterwards.
+	*/
+	class ContextLease
+	{
+	public:
+		CPPFAPIWRAPPER ContextLease(ContextLease && _lease);
+		CPPFAPIWRAPPER ContextLease & operator=(ContextLease && _lease);
+		CPPFAPIWRAPPER ~ContextLease();
+
+		/** Gets leased context
+		*
+		* \return Pointer to FAPIContext, throws an exception if lease is not valid
+		*/
+		CPPFAPIWRAPPER FAPIContext * get() const;
+
+		CPPFAPIWRAPPER FAPIContext * operator->() const;
+		CPPFAPIWRAPPER FAPIContext & operator*() const;
+
+		/** Checks if lease holds a context
+		*
+		* \return False if lease was released or pool didn't have free context in time
+		*/
+		CPPFAPIWRAPPER bool isValid() const;
+
+		/** Returns context to the pool before lease is destroyed */
+		CPPFAPIWRAPPER void release();
+
+		/** Destroys leased context instead of returning it to the pool (ex. after OracleForms error left context
+		* in unknown state). Pool creates a new context in its place.
+		*/
+		CPPFAPIWRAPPER void discard();
+
+		ContextLease() = delete;
+		ContextLease(const ContextLease & _lease) = delete;
+		ContextLease & operator=(const ContextLease & _lease) = delete;
+
+	private:
+		friend class ContextPool;
+
+		ContextLease(ContextPool * _pool, std::unique_ptr<FAPIContext> _ctx);
+
+		ContextPool * pool;
+		std::unique_ptr<FAPIContext> ctx;
+	};
+
+	/** Pool of initialised (and optionally connected) contexts, which are reused between jobs. Contexts are handed
+	* out as ContextLease objects; on return all modules and libraries are removed from a context (see
+	* FAPIContext::reset), while database connection and settings are kept. Pool is thread safe and must outlive
+	* all its leases.
+	*/
+	class ContextPool
+	{
+	public:
+		/** Creates all contexts of the pool
+		*
+		* \param _size Number of contexts
+		* \param _connstring Database connection string (eg. scott/tiger@db), contexts are not connected if empty
+		* \param _init Function called once for every new context (eg. to set snapshot directory)
+		*/
+		CPPFAPIWRAPPER ContextPool(const size_t _size, const std::string & _connstring = "", std::function<void(FAPIContext &)> _init = nullptr);
+		CPPFAPIWRAPPER ~ContextPool();
+
+		/** Leases a context, waiting until one is returned if all are in use
+		*
+		* \return Lease of a context
+		*/
+		CPPFAPIWRAPPER ContextLease acquire();
+
+		/** Leases a context, waiting at most given time if all are in use
+		*
+		* \param _timeout Maximum waiting time
+		* \return Lease of a context, not valid if no context was returned in time
+		*/
+		CPPFAPIWRAPPER ContextLease tryAcquire(const std::chrono::milliseconds _timeout = std::chrono::milliseconds{ 0 });
+
+		/** Gets number of contexts managed by the pool
+		*
+		* \return Pool size
+		*/
+		CPPFAPIWRAPPER size_t size() const;
+
+		/** Gets number of contexts which are not leased at the moment
+		*
+		* \return Number of free contexts
+		*/
+		CPPFAPIWRAPPER size_t available() const;
+
+		ContextPool() = delete;
+		ContextPool(ContextPool && _pool) = delete;
+		ContextPool & operator=(ContextPool && _pool) = delete;
+		ContextPool(const ContextPool & _pool) = delete;
+		ContextPool & operator=(const ContextPool & _pool) = delete;
+
+	private:
+		friend class ContextLease;
+
+		std::unique_ptr<FAPIContext> createPooledContext() const;
+		ContextLease take(std::unique_lock<std::mutex> & _lock);
+		void release(std::unique_ptr<FAPIContext> _ctx, bool _discard);
+
+		std::string connstring;
+		std::function<void(FAPIContext &)> init;
+		std::vector<std::unique_ptr<FAPIContext>> idle;
+		size_t pool_size;
+		size_t missing;
+		mutable std::mutex pool_mutex;
+		std::condition_variable returned;
+	};
+}
+
+#endif // CONTEXTPOOL_H
@@ -3,16 +3,25 @@
 
 #include "D2FCTX.H"
 #include "dllmain.h"
+#include "ModuleGraph.h"
+#include "BuiltinsMatcher.h"
 
 #include <string>
 #include <vector>
 #include <memory>
 #include <functional>
 #include <unordered_map>
+#include <future>
+#include <mutex>
+#include <cstdint>
 
 namespace CPPFAPIWrapper {
+	class FAPIModule;
 	class FAPIForm;
 	class FAPILibrary;
+	class InheritanceSink;
+	class ModuleImage;
+	class TaskExecutor;
 
 	class FAPIContext
 	{
@@ -21,12 +30,38 @@ namespace CPPFAPIWrapper {
 		CPPFAPIWRAPPER FAPIContext();
 		CPPFAPIWRAPPER ~FAPIContext();
 
-		/** Gets Oracle Forms built-ins program units
+		/** Gets Oracle Forms built-ins program units (see getBuiltinsCatalogue)
 		*
 		* \return Builtins program units sorted by package names
 		*/
 		CPPFAPIWRAPPER std::unordered_map<std::string, std::vector<std::string>> getBuiltins();
 
+		/** Checks if identifier is an Oracle Forms built-in program unit (see getBuiltinsCatalogue)
+		*
+		* \param _name Identifier, unqualified or qualified by package name
+		* \return True if identifier is a built-in
+		*/
+		CPPFAPIWRAPPER bool isBuiltin(const std::string & _name);
+
+		/** Gets matcher of built-ins of the catalogue (see getBuiltinsCatalogue), compiled at first use
+		*
+		* \return Built-ins matcher
+		*/
+		CPPFAPIWRAPPER const BuiltinsMatcher & getBuiltinsMatcher();
+
+		/** Gets version of Forms API (d2fctxbv_BuilderVersion)
+		*
+		* \return Version number, ex. 60052902 for 6.0.5.29.2
+		*/
+		CPPFAPIWRAPPER uint32_t getBuilderVersion() const;
+
+		/** Enumerates built-ins program units by OracleForms API. Leaks memory, so it is called only by
+		* getBuiltinsCatalogue, when there is no catalogue file for current Forms API version.
+		*
+		* \return Builtins program units sorted by package names
+		*/
+		CPPFAPIWRAPPER std::unordered_map<std::string, std::vector<std::string>> enumerateBuiltins();
+
 		/** Loads OracleForms .pll library and binds it with current context.
 		*
 		* \param _filepath Path to .pll file
@@ -44,11 +79,101 @@ namespace CPPFAPIWrapper {
 		*/
 		CPPFAPIWRAPPER void loadModule(const std::string & _filepath, const bool _ignore_missing_libs = false, const bool _ignore_missing_sub = false, const bool _traverse = true);
 
-		/** Recurrently loads all sources for given module.
+		/** Loads OracleForms module asynchronously (see loadModule). Asynchronous operations of a context are executed
+		* one after another on its own worker thread, since OracleForms API can't be used by many threads at once.
+		* While they are pending, context shouldn't be used directly from other threads.
+		*
+		* \param _filepath Path to .fmb file
+		* \param _ignore_missing_libs If True, module will be loaded regardless of missing PLSQL libraries (.pll)
+		* \param _ignore_missing_sub If True, module will be loaded regardless of missing subobjects
+		* \return Future with pointer to loaded module, or exception thrown by loadModule
+		*/
+		CPPFAPIWRAPPER std::future<FAPIForm *> loadModuleAsync(const std::string & _filepath, const bool _ignore_missing_libs = false, const bool _ignore_missing_sub = false, const bool _traverse = true);
+
+		/** Loads OracleForms .pll library asynchronously (see loadModuleAsync)
+		*
+		* \param _filepath Path to .pll file
+		* \return Future with pointer to loaded library, or exception thrown by loadLibrary
+		*/
+		CPPFAPIWRAPPER std::future<FAPILibrary *> loadLibraryAsync(const std::string & _filepath);
+
+		/** Runs function on worker thread of the context, after all previously queued asynchronous operations
+		*
+		* \param _task Function to run
+		* \return Future which is ready when function returns
+		*/
+		CPPFAPIWRAPPER std::future<void> runAsync(std::function<void(FAPIContext &)> _task);
+
+		/** Loads and traverses modules one after another on worker thread of the context and hands every module to
+		* analysis function running on other threads, so loading of next module overlaps analysis of previous ones.
+		* Analysis must treat module as read-only: it can't modify module, use OracleForms objects or context
+		* (ex. findSources, getFormsObj). Modules which weren't loaded before are removed after their analysis.
+		* Module listed more than once (paths are compared case-insensitively) is analysed once.
+		* Stops at first exception thrown by loading or analysis and rethrows it.
+		*
+		* \param _filepaths Paths to .fmb files
+		* \param _analyse Analysis function, called concurrently for different modules
+		* \param _threads Number of analysis threads
+		* \param _ignore_missing_libs If True, all modules will be loaded regardless of missing PLSQL libraries (.pll)
+		* \param _ignore_missing_sub If True, all modules will be loaded regardless of missing subobjects
+		* \return Number of analysed modules
+		*/
+		CPPFAPIWRAPPER size_t analyseModules(const std::vector<std::string> & _filepaths, std::function<void(const FAPIForm &)> _analyse, const size_t _threads = 1, const bool _ignore_missing_libs = false, const bool _ignore_missing_sub = false);
+
+		/** Same as analyseModules above, analysis function gets index of module path in _filepaths as well (first
+		* one for module listed more than once), so results can be ordered as paths regardless of module path case.
+		*
+		* \param _filepaths Paths to .fmb files
+		* \param _analyse Analysis function called with module and index of its path, concurrently for different modules
+		* \param _threads Number of analysis threads
+		* \param _ignore_missing_libs If True, all modules will be loaded regardless of missing PLSQL libraries (.pll)
+		* \param _ignore_missing_sub If True, all modules will be loaded regardless of missing subobjects
+		* \return Number of analysed modules
+		*/
+		CPPFAPIWRAPPER size_t analyseModules(const std::vector<std::string> & _filepaths, std::function<void(const FAPIForm &, const size_t)> _analyse, const size_t _threads = 1, const bool _ignore_missing_libs = false, const bool _ignore_missing_sub = false);
+
+		/** Creates object reports of many modules (see ObjectReportWriter) with analyseModules, so reports are written
+		* concurrently while next modules are loaded.
+		*
+		* \param _filepaths Paths to .fmb files
+		* \param _directory Directory of report files, if empty every report resides in same folder as its module
+		* \param _threads Number of threads writing reports
+		* \param _ignore_missing_libs If True, all modules will be loaded regardless of missing PLSQL libraries (.pll)
+		* \param _ignore_missing_sub If True, all modules will be loaded regardless of missing subobjects
+		* \return Number of written reports
+		*/
+		CPPFAPIWRAPPER size_t createObjectReports(const std::vector<std::string> & _filepaths, const std::string & _directory = "", const size_t _threads = 1, const bool _ignore_missing_libs = false, const bool _ignore_missing_sub = false);
+
+		/** Counts uses of built-ins in triggers and program units of many modules (see BuiltinsMatcher) with
+		* analyseModules.
+		*
+		* \param _filepaths Paths to .fmb files
+		* \param _threads Number of analysis threads
+		* \param _ignore_missing_libs If True, all modules will be loaded regardless of missing PLSQL libraries (.pll)
+		* \param _ignore_missing_sub If True, all modules will be loaded regardless of missing subobjects
+		* \return Reports of analysed modules, in order of paths
+		*/
+		CPPFAPIWRAPPER std::vector<BuiltinsReport> reportBuiltins(const std::vector<std::string> & _filepaths, const size_t _threads = 1, const bool _ignore_missing_libs = false, const bool _ignore_missing_sub = false);
+
+		/** Builds dependency graph of a module: its source modules (recurrently) and attached PLSQL libraries.
+		* Form modules which are not loaded yet are loaded without traversing and only scanned for dependencies,
+		* so graph can be used for planning work before any expensive operation. Throws an exception if module
+		* name can't be resolved to a path and ignore parameter is set to false.
+		*
+		* \param _filepath Path to .fmb file
+		* \param _ignore_missing_libs If True, unresolvable PLSQL libraries are added to graph without path
+		* \param _ignore_missing_sub If True, unresolvable source modules are added to graph without path
+		* \return Module dependency graph
+		*/
+		CPPFAPIWRAPPER ModuleGraph buildModuleGraph(const std::string & _filepath, const bool _ignore_missing_libs = false, const bool _ignore_missing_sub = false);
+
+		/** Loads all sources for given module. Modules are loaded and traversed in topological order of
+		* module dependency graph, exactly once per module. Throws an exception if graph has a cycle.
 		*
 		* \param _module Pointer to FAPIModule object, which sources needs to be loaded for
 		* \param _ignore_missing_libs If True, all modules will be loaded regardless of missing PLSQL libraries (.pll)
 		* \param _ignore_missing_sub If True, all modules will be loaded regardless of missing subobjects
+		* \param _traverse If False, source modules are loaded without traversing their objects
 		*/
 		CPPFAPIWRAPPER void loadSourceModules(const FAPIForm * _module, const bool _ignore_missing_libs = false, const bool _ignore_missing_sub = false, const bool _traverse = true);
 
@@ -58,9 +183,32 @@ namespace CPPFAPIWrapper {
 		* \param _filepath Path to .fmb file
 		* \param _ignore_missing_libs If True, all modules will be loaded regardless of missing PLSQL libraries (.pll)
 		* \param _ignore_missing_sub If True, all modules will be loaded regardless of missing subobjects
+		* \param _traverse If False, modules are loaded without traversing their objects and inheritance isn't checked
 		*/
 		CPPFAPIWRAPPER void loadModuleWithSources(const std::string & _filepath, const bool _ignore_missing_libs = false, const bool _ignore_missing_sub = false, const bool _traverse = true);
 
+		/** Writes read-only inheritance report (see FAPIForm::reportOverriden) for many modules. Every module which
+		* wasn't loaded before is removed from context right after its report is written, so memory usage doesn't
+		* grow with number of modules. Source modules stay loaded, since they are shared between modules.
+		*
+		* \param _filepaths Paths to .fmb files
+		* \param _sink Destination of records
+		* \param _ignore_missing_libs If True, all modules will be loaded regardless of missing PLSQL libraries (.pll)
+		* \param _ignore_missing_sub If True, all modules will be loaded regardless of missing subobjects
+		* \return Number of written records
+		*/
+		CPPFAPIWRAPPER size_t reportInheritance(const std::vector<std::string> & _filepaths, InheritanceSink & _sink, const bool _ignore_missing_libs = false, const bool _ignore_missing_sub = false);
+
+		/** Hands traversed module or PL/SQL library to a function. Module which wasn't loaded before is loaded for the
+		* call only and removed afterwards, also when function throws an exception.
+		*
+		* \param _filepath Path to a module or .pll file
+		* \param _visit Function called with the module
+		* \param _ignore_missing_libs If True, module will be loaded regardless of missing PLSQL libraries (.pll)
+		* \param _ignore_missing_sub If True, module will be loaded regardless of missing subobjects
+		*/
+		CPPFAPIWRAPPER void visitModule(const std::string & _filepath, std::function<void(const FAPIModule &)> _visit, const bool _ignore_missing_libs = false, const bool _ignore_missing_sub = false);
+
 		/** Creates new FAPIModule object in location pointed by _filepath param. The file is not generated
 		* althought, until saveModule function wont be called.
 		*
@@ -102,12 +250,40 @@ namespace CPPFAPIWrapper {
 		*/
 		CPPFAPIWRAPPER bool hasLibrary(const std::string & _filepath);
 
-		/** Removes library from context
+		/** Removes library from context. Library still shared by modules (see acquireLibrary) is removed when
+		* last of them releases it.
 		*
 		* \param _filepath Path to .pll file
 		*/
 		CPPFAPIWRAPPER void removeLibrary(const std::string & _filepath);
 
+		/** Gets library shared by modules of the context, loading and traversing it at first call. Every call must be
+		* paired with releaseLibrary; library loaded this way is removed when it is released by everyone.
+		*
+		* \param _filepath Path to .pll file
+		* \return Pointer to FAPILibrary object
+		*/
+		CPPFAPIWRAPPER FAPILibrary * acquireLibrary(const std::string & _filepath);
+
+		/** Releases library got by acquireLibrary
+		*
+		* \param _filepath Path to .pll file
+		*/
+		CPPFAPIWRAPPER void releaseLibrary(const std::string & _filepath);
+
+		/** Gets number of unreleased acquireLibrary calls for a library
+		*
+		* \param _filepath Path to .pll file
+		* \return Number of references
+		*/
+		CPPFAPIWRAPPER size_t getLibraryReferences(const std::string & _filepath) const;
+
+		/** Removes all modules and libraries from context, so it can be reused for another job. Waits for pending
+		* asynchronous operations first. Built-ins matcher is dropped and module path index is listed again at next
+		* use (see ModulePathResolver::invalidate). Database connection and snapshot directory are kept.
+		*/
+		CPPFAPIWRAPPER void reset();
+
 		/** Connects context with a database.
 		*
 		* \param _connstring Connection string for a database, ex. scott/tiger@db
@@ -145,18 +321,60 @@ namespace CPPFAPIWrapper {
 		*/
 		CPPFAPIWRAPPER std::unordered_map<std::string, std::unique_ptr<FAPILibrary>> & getLibraries();
 
+		/** Sets directory for snapshots of traversed modules. When set, every traversed module is saved as a snapshot
+		* and next loading of unchanged module restores its object tree from snapshot instead of OracleForms API.
+		* Source modules (see buildModuleGraph, loadSourceModules) are restored and saved the same way. Snapshot keeps
+		* status of loading module, so restored module is accepted or rejected by ignore parameters as if it was loaded.
+		*
+		* \param _directory Existing directory for snapshot files, empty string disables snapshots
+		*/
+		CPPFAPIWRAPPER void setSnapshotDirectory(const std::string & _directory);
+
+		/** Gets directory for snapshots of traversed modules
+		*
+		* \return Directory for snapshot files, empty if snapshots are disabled
+		*/
+		CPPFAPIWRAPPER std::string getSnapshotDirectory() const;
+
+		/** Opens read-only, memory mapped image of a module (see ModuleImage). Snapshot directory must be set.
+		* If there is no up to date snapshot of a module, module is loaded and traversed once to create it; module
+		* which wasn't loaded before is removed from context afterwards. Throws an exception if outdated snapshot
+		* couldn't be replaced (on Windows while another image of the same module is open).
+		*
+		* \param _filepath Path to .fmb/.pll file
+		* \param _ignore_missing_libs If True, module will be loaded regardless of missing PLSQL libraries (.pll)
+		* \param _ignore_missing_sub If True, module will be loaded regardless of missing subobjects
+		* \return Module image
+		*/
+		CPPFAPIWRAPPER std::unique_ptr<ModuleImage> openModuleImage(const std::string & _filepath, const bool _ignore_missing_libs = false, const bool _ignore_missing_sub = false);
+
 		/** Gets string which were used for connecting to database
 		*
 		* \return Connection string which were used for connecting to database
 		*/
 		CPPFAPIWRAPPER std::string getConnstring() const;
 	private:
+		struct LibraryShare {
+			size_t references;
+			bool unload;	// library is removed when last reference is released
+		};
+
+		bool restoreModule(const std::string & _filepath, const bool _ignore_missing_libs, const bool _ignore_missing_sub);
+		void saveSnapshot(const FAPIModule * _module);
+		TaskExecutor & getWorker();
+
 		std::unique_ptr<d2fctx, std::function<void(d2fctx *)>> ctx;
 		std::unordered_map<std::string, std::unique_ptr<FAPIForm>> modules;
 		std::unordered_map<std::string, std::unique_ptr<FAPILibrary>> libs;
+		std::unordered_map<std::string, LibraryShare> lib_shares;
 		std::string connstring;
+		std::string snapshot_dir;
 		d2fctxa attr;
 		bool is_connected;
+		std::mutex worker_mutex;
+		std::unique_ptr<TaskExecutor> worker;
+		std::mutex matcher_mutex;
+		std::unique_ptr<BuiltinsMatcher> builtins_matcher;
 	};
 }
 
@@ -4,7 +4,20 @@
 #include "dllmain.h"
 #include "FAPIModule.h"
 
+#include <unordered_map>
+
 namespace CPPFAPIWrapper {
+	class InheritanceCache;
+	class InheritanceSink;
+
+	struct UnitCompileResult {
+		int type_id;			// D2FFO_TRIGGER or D2FFO_PROG_UNIT
+		std::string fullname;	// full name of trigger/program unit
+		int status;				// OracleForms status of compilation, D2FS_SUCCESS for skipped unit
+		std::string message;	// status description, empty on success
+		bool compiled;			// false if unit was skipped, because its text didn't change since last successful compilation
+	};
+
 	class FAPIForm : public FAPIModule
 	{
 	public:
@@ -13,8 +26,9 @@ namespace CPPFAPIWrapper {
 		* \param _ctx Pointer to FAPIContext.
 		* \param _mod Pointer to OracleForms form object
 		* \param _filepath Path to .fmb module
+		* \param _load_status OracleForms status of loading form object (see getLoadStatus)
 		*/
-		CPPFAPIWRAPPER FAPIForm(FAPIContext * _ctx, void * _mod, const std::string & _filepath);
+		CPPFAPIWRAPPER FAPIForm(FAPIContext * _ctx, void * _mod, const std::string & _filepath, const int _load_status = D2FS_SUCCESS);
 		CPPFAPIWRAPPER ~FAPIForm();
 
 		FAPIForm() = delete;
@@ -53,16 +67,29 @@ namespace CPPFAPIWrapper {
 		*/
 		CPPFAPIWRAPPER void detachLib(const std::string & _lib_name);
 
-		/** Saves .fmb module to a disk.
+		/** Saves .fmb module to a disk. Saving to module's own file is skipped if module wasn't modified (see isModified).
+		* Module is no longer modified only after its own file was written; temporary file is removed if saving fails.
 		*
 		* \param _path If not provided, module will be saved to a location pointed by filepath object member
+		* \param _keep_identical If True, module is saved to a temporary file first and existing file is replaced only
+		* if content differs, so modification time of unchanged file is kept
+		* \return True if file was written
 		*/
-		CPPFAPIWRAPPER void saveModule(const std::string & _path = "");
+		CPPFAPIWRAPPER bool saveModule(const std::string & _path = "", const bool _keep_identical = false);
 
-		/** Compiles all PLSQL objects in .fmb module*/
+		/** Compiles all PLSQL objects in .fmb module. Module is modified afterwards, so saveModule keeps compiled code. */
 		CPPFAPIWRAPPER void compileModule();
 
-		/** Check if module is compiling correctly */
+		/** Compiles triggers and program units one by one, skipping units whose text hash didn't change since their last
+		* successful compilation (by compileUnits or compileModule). Program units are compiled first; if any of them
+		* changed, all units are compiled, because callers may be affected. Successful compilation modifies the module.
+		*
+		* \param _force If True, all units are compiled
+		* \return Result of every unit, failed compilations don't throw an exception
+		*/
+		CPPFAPIWRAPPER std::vector<UnitCompileResult> compileUnits(const bool _force = false);
+
+		/** Check if module is compiling correctly. Only units changed since last check are compiled (see compileUnits). */
 		CPPFAPIWRAPPER bool isCompiling() noexcept;
 
 		/** Generates .fmx file in same folder as module */
@@ -71,10 +98,33 @@ namespace CPPFAPIWrapper {
 		/** Checks properties for broken inheritance. Search for and loads source modules if needed */
 		CPPFAPIWRAPPER void checkOverriden();
 
+		/** Checks properties for broken inheritance, reusing results recorded in cache. Only objects whose source
+		* chain passes through a source module changed since last check are checked again. If module itself changed,
+		* all objects are checked. Results are recorded back to the cache. Call InheritanceCache::refreshModule after
+		* the module is saved.
+		*
+		* \param _cache Cache with results of previous checks
+		* \return Number of objects which were checked again
+		*/
+		CPPFAPIWRAPPER size_t checkOverriden(InheritanceCache & _cache);
+
+		/** Read-only counterpart of checkOverriden. Compares local properties of subclassed objects with their
+		* sources and writes one record per property to a sink, without modifying module or keeping results.
+		*
+		* \param _sink Destination of records
+		* \return Number of written records
+		*/
+		CPPFAPIWRAPPER size_t reportOverriden(InheritanceSink & _sink);
+
 		void * getModule() const override;
-		std::string createObjectReportFile(const std::string & _filepath = "") override;
 		std::vector<FormsObject *> getAllObjects() const override;
 		void findGlobals() override;
+
+	protected:
+		void * loadNative() const override;
+
+	private:
+		std::unordered_map<std::string, uint64_t> compiled_units;	// key: unit type and full name, value: text hash of last successful compilation
 	};
 }
 #endif // FAPIMODULE_H
@@ -25,9 +25,11 @@ namespace CPPFAPIWrapper {
 		FAPILibrary & operator=(const FAPILibrary & _Library) = delete;
 
 		void * getModule() const override;
-		std::string createObjectReportFile(const std::string & _filepath = "") override;
 		std::vector<FormsObject *> getAllObjects() const override;
 		void findGlobals() override;
+
+	protected:
+		void * loadNative() const override;
 	};
 }
 #endif // FAPILIBRARY_H
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "dllmain.h"
 #include <string>
 #include <fstream>
+#include <mutex>
 #include "easylogger.h"
 
 namespace CPPFAPIWrapper {
@@ -27,6 +28,21 @@ namespace CPPFAPIWrapper {
 		CPPFAPIWRAPPER static std::string getFilepath();
 		CPPFAPIWRAPPER static bool isEnabled();
 		CPPFAPIWRAPPER static easylogger::LogLevel getLogLevel();
+
+		/** Checks if trace messages are written, so callers can skip building them
+		*
+		* \return True if logger is enabled and its level is LEVEL_TRACE
+		*/
+		CPPFAPIWRAPPER static bool isTracing();
+
+		/** Formats location prefix of trace messages (see TRACE_FNC)
+		*
+		* \param _file Source file path
+		* \param _function Function name
+		* \param _line Line number
+		* \return Prefix, ex. \\Property.cpp (getValue 120):
+		*/
+		CPPFAPIWRAPPER static std::string traceLocation(const char * _file, const char * _function, const int _line);
 	private:
 		CPPFAPIWRAPPER static std::string getTimestamp();
 
@@ -35,9 +51,16 @@ namespace CPPFAPIWrapper {
 		static bool is_enabled;
 		static easylogger::LogLevel level;
 		static easylogger::Logger logger;
+		static std::recursive_mutex log_mutex;	// loggers are shared by all threads
 	};
 }
 
-#define TRACE_FNC(_msg) FAPILogger::trace(std::string(__FILE__).substr(std::string(__FILE__).rfind('\\')) + " (" + std::string(__FUNCTION__) + " " + std::to_string(__LINE__) + "): " + _msg);
+// Traces function call. Message is built only when tracing is on (see FAPILogger::isTracing), defining
+// CPPFAPIWRAPPER_NO_TRACE removes tracing from build.
+#ifdef CPPFAPIWRAPPER_NO_TRACE
+#define TRACE_FNC(_msg)
+#else
+#define TRACE_FNC(_msg) do { if (FAPILogger::isTracing()) FAPILogger::trace(FAPILogger::traceLocation(__FILE__, __FUNCTION__, __LINE__) + _msg); } while (false);
+#endif
 
 #endif // FAPILOGGER_H
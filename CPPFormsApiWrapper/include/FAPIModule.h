@@ -2,17 +2,30 @@
 
 #include <memory>
 #include <unordered_set>
+#include <unordered_map>
 #include <functional>
 
 #include "Expected.h"
+#include "GlobalScanner.h"
 #include "dllmain.h"
 #include "D2FOB.H"
 
 
 namespace CPPFAPIWrapper {
 	class FAPIContext;
+	class FAPILibrary;
 	class FormsObject;
 
+	struct BulkUpdateResult {
+		size_t matched;		// objects of given type, having the property and accepted by predicate
+		size_t changed;		// properties which got a different value
+	};
+
+	struct GlobalUsage {
+		FormsObject * unit;			// trigger or program unit
+		GlobalReference reference;	// location in unit's code
+	};
+
 	class FAPIModule
 	{
 		public:
@@ -27,6 +40,50 @@ namespace CPPFAPIWrapper {
 			*/
 			CPPFAPIWRAPPER int traverseObjects(d2fob * _obj = nullptr, int _level = 0, FormsObject * _forms_object = nullptr);
 
+			/** Walks .fmb/.pll object tree looking only for source modules and attached libraries. Much cheaper than
+			* traverseObjects, because object properties are not loaded. Does nothing if dependencies are already known.
+			*
+			* \param _obj Pointer to OracleForms object
+			* \return OracleForms status of operation
+			*/
+			CPPFAPIWRAPPER int scanDependencies(d2fob * _obj = nullptr);
+
+			/** Checks if object tree was traversed
+			*
+			* \return True if traverseObjects was called for a module
+			*/
+			CPPFAPIWRAPPER bool isTraversed() const;
+
+			/** Loads OracleForms module and binds its objects with already existing object tree. Used when module
+			* was restored from snapshot and native OracleForms objects are needed (ex. to modify or save module).
+			* Does nothing if module is already loaded. Throws an exception if any restored object has no OracleForms
+			* counterpart, module stays not loaded then.
+			*/
+			CPPFAPIWRAPPER void attachNative() const;
+
+			/** Checks if module was changed since it was loaded or saved: properties marked for setting their values,
+			* inherited properties, attached or detached libraries
+			*
+			* \return True if saving module would change it
+			*/
+			CPPFAPIWRAPPER bool isModified() const;
+
+			/** Records change made directly on OracleForms objects, so module is not skipped by saveModule */
+			CPPFAPIWRAPPER void markModified();
+
+			/** Checks if OracleForms module is loaded
+			*
+			* \return False if module was restored from snapshot and attachNative wasn't called yet
+			*/
+			CPPFAPIWRAPPER bool isNative() const;
+
+			/** Gets OracleForms status of loading module, kept in module snapshots as well
+			*
+			* \return D2FS_SUCCESS, or D2FS_MISSINGLIBMOD/D2FS_MISSINGSUBCLMOD if module was loaded regardless of missing
+			* libraries or subobjects
+			*/
+			CPPFAPIWRAPPER int getLoadStatus() const;
+
 			/** Gets filepath to module
 			*
 			* \return Filepath to module
@@ -57,6 +114,12 @@ namespace CPPFAPIWrapper {
 			*/
 			CPPFAPIWRAPPER std::unordered_set<std::string> getSourceModules() const;
 
+			/** Gets names of PLSQL libraries attached to current module
+			*
+			* \return Set of attached library names.
+			*/
+			CPPFAPIWRAPPER std::unordered_set<std::string> getLibraryModules() const;
+
 			/** Checks if contains internal object
 			* \param _type_id OracleForms object type id
 			* \param _fullname Full name of object (eg. BLOCK.ITEM.TRIGGER, PRG_UNIT ...)
@@ -94,6 +157,24 @@ namespace CPPFAPIWrapper {
 			*/
 			CPPFAPIWRAPPER std::vector<FormsObject *> getAttachedLibraries() const;
 
+			/** Gets PLSQL libraries attached to module. Libraries are shared by all modules of the context (see
+			* FAPIContext::acquireLibrary), so each library is loaded and traversed once. Libraries are resolved at first
+			* call, missing ones are skipped.
+			*
+			* \return Collection of FAPILibrary pointers, in order of attachment
+			*/
+			CPPFAPIWRAPPER std::vector<FAPILibrary *> getLibraries();
+
+			/** Gets library attached by AttachedLibrary object
+			*
+			* \param _att_lib AttachedLibrary object of current module
+			* \return Pointer to FAPILibrary if library was found, otherwise throws exception.
+			*/
+			CPPFAPIWRAPPER Expected<FAPILibrary> getLibrary(FormsObject * _att_lib);
+
+			/** Releases libraries got by getLibraries, they are removed from context when no other module uses them */
+			CPPFAPIWRAPPER void releaseLibraries();
+
 			/** Gets all Block objects
 			*
 			* \return Collection of FormsObject pointers to Block
@@ -130,28 +211,68 @@ namespace CPPFAPIWrapper {
 			*/
 			CPPFAPIWRAPPER std::vector<FormsObject *> getParameters() const;
 
-			/** Mark object for setting its properties' values
+			/** Sets property of all matching objects in one pass over object tree. New values are computed first and
+			* then set (and marked for saveModule) together, so predicate and transform see unchanged module.
+			*
+			* \param _type_id OracleForms object type id, D2FFO_ANY for objects of all types
+			* \param _prop_id OracleForms property id, objects without the property don't match
+			* \param _predicate Function selecting objects, nullptr selects all objects of given type
+			* \param _transform Function computing new value from object and current value
+			* \return Numbers of matched objects and changed properties
+			*/
+			CPPFAPIWRAPPER BulkUpdateResult updateProperty(const int _type_id, const int _prop_id, std::function<bool(FormsObject *)> _predicate, std::function<std::string(FormsObject *, const std::string &)> _transform);
+
+			/** Sets property of all matching objects to the same value (see updateProperty with transform)
+			*
+			* \param _type_id OracleForms object type id, D2FFO_ANY for objects of all types
+			* \param _prop_id OracleForms property id, objects without the property don't match
+			* \param _predicate Function selecting objects, nullptr selects all objects of given type
+			* \param _value New value
+			* \return Numbers of matched objects and changed properties
+			*/
+			CPPFAPIWRAPPER BulkUpdateResult updateProperty(const int _type_id, const int _prop_id, std::function<bool(FormsObject *)> _predicate, const std::string & _value);
+
+			/** Mark object for setting its properties' values. Constant time.
 			*
 			* \param _forms_object Object to mark
 			*/
 			CPPFAPIWRAPPER void markObject(FormsObject * _forms_object);
 
-			/** Unmark object for setting its properties' values
+			/** Unmark object for setting its properties' values. Constant time, last marked object takes its place.
 			*
 			* \param _forms_object Object to unmark
 			*/
 			CPPFAPIWRAPPER void unmarkObject(FormsObject * _forms_object);
 
-			/** Creates object report file for a given Library
+			/** Creates object report file of a module, written from loaded objects (see ObjectReportWriter)
 			*
-			* \param _filepath Location of output file. If not provided, will reside in same folder as Library
+			* \param _filepath Location of output file, its extension is replaced with .txt. If not provided, will reside in same folder as module
 			* \return Returns output filepath.
 			*/
-			CPPFAPIWRAPPER virtual std::string createObjectReportFile(const std::string & _filepath = "") = 0;
+			CPPFAPIWRAPPER virtual std::string createObjectReportFile(const std::string & _filepath = "");
 
-			/** Finds all global variables from all program units */
+			/** Finds all global variables from all program units (see scanGlobals) */
 			CPPFAPIWRAPPER virtual void findGlobals() = 0;
 
+			/** Gets global variables found by findGlobals
+			*
+			* \return Set of uppercase global variables names
+			*/
+			CPPFAPIWRAPPER const std::unordered_set<std::string> & getGlobals() const;
+
+			/** Gets every reference to global variables found by findGlobals
+			*
+			* \return References with their units, in order of units and occurrence
+			*/
+			CPPFAPIWRAPPER const std::vector<GlobalUsage> & getGlobalReferences() const;
+
+			/** Gets global variables used by attached libraries. Globals of a shared library are searched once, no
+			* matter how many modules attach it.
+			*
+			* \return Set of global variables names
+			*/
+			CPPFAPIWRAPPER std::unordered_set<std::string> getLibraryGlobals();
+
 			/** Gets pointer to OracleForms object
 			*
 			* \return Pointer to OracleForms object
@@ -165,7 +286,41 @@ namespace CPPFAPIWrapper {
 			CPPFAPIWRAPPER virtual std::vector<FormsObject *> getAllObjects() const = 0;
 
 		protected:
+			friend class ModuleSnapshot;
+
 			CPPFAPIWRAPPER FAPIModule(FAPIContext * _ctx, const std::string & _filepath);
+
+			/** Loads OracleForms module from filepath
+			*
+			* \return Pointer to OracleForms module object
+			*/
+			virtual void * loadNative() const = 0;
+
+			/** Binds native OracleForms objects with FormsObject tree, matching them by type and name.
+			*
+			* \param _obj Pointer to OracleForms object
+			* \param _forms_object Object matching _obj
+			* \return Number of bound objects, including _forms_object
+			*/
+			size_t bindObjects(d2fob * _obj, FormsObject * _forms_object) const;
+
+			/** Sets internal OracleForms values of marked properties, object by object, and unmarks them. Module stays
+			* modified (see isModified) until it is saved. If setting fails, objects not set yet stay marked.
+			*/
+			void applyMarkedObjects();
+
+			/** Scans code of PLSQL units for global variables, replacing globals and global_references
+			*
+			* \param _units Triggers and program units
+			*/
+			void collectGlobals(const std::vector<FormsObject *> & _units);
+
+			/** Adds attached library to library_modules, keeping order in which libraries are attached
+			*
+			* \param _name Library name
+			*/
+			void addLibraryModule(const std::string & _name);
+
 			FAPIModule() = delete;
 			FAPIModule(FAPIModule && _Library) = delete;
 			FAPIModule & operator=(FAPIModule && _Library) = delete;
@@ -176,9 +331,19 @@ namespace CPPFAPIWrapper {
 			std::string filepath;
 			std::unique_ptr<FormsObject> root;
 			std::unordered_set<std::string> globals;
-			std::unique_ptr<void, std::function<void(const void*)>> mod;
+			std::vector<GlobalUsage> global_references;
+			mutable std::unique_ptr<void, std::function<void(const void*)>> mod;
 			std::unordered_set<std::string> source_modules;
+			std::unordered_set<std::string> library_modules;
+			std::vector<std::string> library_order;	// library_modules in order of attachment
+			bool dependencies_known;
+			bool globals_found;
+			bool modified;	// OracleForms objects were changed, marked properties are not included
+			int load_status;	// status accepted when module was loaded, loadNative accepts it again
 			std::vector<FormsObject *> marked_objects;
+			bool libraries_resolved;
+			std::vector<std::pair<std::string, FAPILibrary *>> attached_libs;	// library name, nullptr if missing
+			std::vector<std::string> acquired_libs;	// paths of libraries acquired from context
 		};
 }
 
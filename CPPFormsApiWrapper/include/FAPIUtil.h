@@ -3,16 +3,22 @@
 
 #include <string>
 #include <vector>
+#include <cstdint>
 #include "ORATYPES.H"
 #include "dllmain.h"
 
 #include "D2FCTX.H"
+#include "ModuleGraph.h"
 
 #include "easylogger.h"
 
 namespace CPPFAPIWrapper {
 
-	CPPFAPIWRAPPER constexpr int GLOBAL_OFFSET = 7;
+	struct FileFingerprint {
+		int64_t size;	// -1 if file doesn't exist
+		int64_t mtime;	// last modification time, in highest resolution provided by file system
+		uint64_t hash;	// FNV-1a hash of file content, 0 if not computed
+	};
 
 	/** Returns uppercase string
 	*
@@ -35,7 +41,8 @@ namespace CPPFAPIWrapper {
 	*/
 	CPPFAPIWRAPPER text * stringToText(const std::string & _str);
 
-	/** Gets filepath for a module with a given name. It searches nearest path depending on registry value from key SOFTWARE/ORACLE/FORMS60_PATH.
+	/** Gets filepath for a module with a given name. It searches first directory containing the module, directories are given
+	* by getModulePathResolver (by default FORMS60_PATH environment variable or registry value SOFTWARE/ORACLE/FORMS60_PATH).
 	* If there's no module in specified paths, throws an exception.
 	*
 	* \param _str Name of a module
@@ -43,6 +50,14 @@ namespace CPPFAPIWrapper {
 	*/
 	CPPFAPIWRAPPER std::string modulePathFromName(const std::string & _str);
 
+	/** Gets filepath for a PLSQL library with a given name. Searches same paths as modulePathFromName.
+	* If there's no library in specified paths, throws an exception.
+	*
+	* \param _str Name of a library
+	* \return Path to .pll with a given library name
+	*/
+	CPPFAPIWRAPPER std::string libraryPathFromName(const std::string & _str);
+
 	/** Removes folder path and extension from a given path and returns pure file(module) name
 	*
 	* \param _str Path to .fmb
@@ -67,7 +82,7 @@ namespace CPPFAPIWrapper {
 
 	/** Gets folders paths where .fmb should be searched.
 	*
-	* \return Collection of folders paths, basing on registry key SOFTWARE/ORACLE/FORMS60_PATH
+	* \return Collection of folders paths, given by path source of getModulePathResolver
 	*/
 	CPPFAPIWRAPPER std::vector<std::string> getFMBPaths();
 
@@ -78,6 +93,74 @@ namespace CPPFAPIWrapper {
 	*/
 	CPPFAPIWRAPPER bool fileExists(const std::string & _filepath);
 
+	/** Hashes bytes with 64-bit FNV-1a algorithm.
+	*
+	* \param _data Pointer to data
+	* \param _size Number of bytes
+	* \param _seed Previous hash value, allows to hash data in chunks
+	* \return Hash value
+	*/
+	CPPFAPIWRAPPER uint64_t hashBytes(const char * _data, const size_t _size, uint64_t _seed = 14695981039346656037ULL);
+
+	/** Gets fingerprint of a file: its size, modification time and optionally a content hash.
+	*
+	* \param _filepath Path to a file.
+	* \param _with_hash If True, whole file is read and content hash is computed
+	* \return Fingerprint of a file, with size equal -1 if file doesn't exist
+	*/
+	CPPFAPIWRAPPER FileFingerprint fileFingerprint(const std::string & _filepath, const bool _with_hash = true);
+
+	/** Checks if file has changed since fingerprint was taken. Content is hashed only if size or
+	* modification time differ, so touched but unmodified files are not reported as changed.
+	*
+	* \param _fingerprint Previously taken fingerprint
+	* \param _filepath Path to a file.
+	* \return True if file content differs from fingerprinted one
+	*/
+	CPPFAPIWRAPPER bool fileChanged(const FileFingerprint & _fingerprint, const std::string & _filepath);
+
+	/** Moves file over another one in a single step, so target is either replaced or left untouched (ex. when
+	* writing a file through a temporary file).
+	*
+	* \param _source Path to a new file
+	* \param _target Path to a replaced file, it doesn't have to exist
+	* \return True if target was replaced
+	*/
+	CPPFAPIWRAPPER bool replaceFile(const std::string & _source, const std::string & _target);
+
+	/** Gets path for a temporary file written next to a file and moved over it by replaceFile. Path is unique
+	* among processes and threads, so concurrent writers of the same file don't write the same temporary file.
+	*
+	* \param _filepath Path to a file
+	* \return Path to a temporary file in the same directory
+	*/
+	CPPFAPIWRAPPER std::string temporaryPath(const std::string & _filepath);
+
+	/** Escapes backslash, tab and line separators of a field of tab-separated text files (changesets, build
+	* journal, code index), as values can be PLSQL code.
+	*
+	* \param _field Field value
+	* \return Escaped value, without tabs and line separators
+	*/
+	CPPFAPIWRAPPER std::string escapeField(const std::string & _field);
+
+	/** Splits line of tab-separated text file into fields, unescaping them (see escapeField).
+	* If line ends with unfinished escape sequence, throws an exception.
+	*
+	* \param _line Line without line separator
+	* \return Collection of unescaped fields
+	*/
+	CPPFAPIWRAPPER std::vector<std::string> splitEscapedFields(const std::string & _line);
+
+	/** Gets filepath of a module or library with a given name (see modulePathFromName and libraryPathFromName).
+	*
+	* \param _name Name of a module or library
+	* \param _kind Kind of module
+	* \param _ignore_missing If True, missing module is logged as warning instead of throwing an exception
+	* \return Path to module, empty if module is missing and ignored
+	*/
+	CPPFAPIWRAPPER std::string resolveModulePath(const std::string & _name, const ModuleKind _kind, const bool _ignore_missing);
+
 	/** Returns logging level from a given string.
 	*
 	* \param _str String describing the logging level. It should be: TRACE/DEBUG/INFO/WARN/ERROR/FATAL or it's first letters.
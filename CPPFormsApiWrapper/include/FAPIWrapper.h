@@ -10,8 +10,9 @@
 
 namespace CPPFAPIWrapper {
 	class FAPIContext;
+	class BuiltinsCatalogue;
 
-	/// OracleForms built-ins program units
+	/// OracleForms built-ins program units, filled when built-ins catalogue is loaded (see getBuiltinsCatalogue)
 	CPPFAPIWRAPPER extern std::unordered_map<std::string, std::vector<std::string>> builtins;
 
 	/// OracleForms type hierarchy
@@ -29,13 +30,36 @@ namespace CPPFAPIWrapper {
 	/// OracleForms property names
 	CPPFAPIWRAPPER extern const std::vector<std::string> prop_names;
 
-	/** Creates OracleForms context and connect it to database if proper string provided.
+	/** Creates OracleForms context and connect it to database if proper string provided. Built-ins aren't loaded
+	* until they are used (see getBuiltinsCatalogue).
 	*
 	* \param _connstring Database connection string, eg. scott/tiger@db
 	* \return Unique pointer to FAPIContext object
 	*/
 	CPPFAPIWRAPPER std::unique_ptr<FAPIContext> createContext(const std::string & _connstring = "");
 
+	/** Sets directory of built-ins catalogue files (see getBuiltinsCatalogue). By default it is temporary
+	* directory (TEMP, TMP or TMPDIR environment variable).
+	*
+	* \param _directory Existing directory
+	*/
+	CPPFAPIWRAPPER void setBuiltinsDirectory(const std::string & _directory);
+
+	/** Gets directory of built-ins catalogue files
+	*
+	* \return Directory of built-ins catalogue files
+	*/
+	CPPFAPIWRAPPER std::string getBuiltinsDirectory();
+
+	/** Gets catalogue of built-ins for Forms API version used by a context. Catalogue is loaded at first use from
+	* built-ins directory; built-ins are enumerated by OracleForms API (and catalogue file is written) only when
+	* there is no catalogue for current Forms API version yet. Enumeration is done at most once per process.
+	*
+	* \param _ctx Pointer to FAPIContext
+	* \return Built-ins catalogue
+	*/
+	CPPFAPIWRAPPER const BuiltinsCatalogue & getBuiltinsCatalogue(FAPIContext * _ctx);
+
 	/** Gets current library version
 	*
 	* \return Library version
@@ -0,0 +1,120 @@
+#ifndef FARMPROTOCOL_H
+#define FARMPROTOCOL_H
+
+#include "dllmain.h"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace CPPFAPIWrapper {
+	/*
+	** Wire protocol between WorkerFarm and its workers. Every message is a frame:
+	**   uint32_t length     - number of bytes after this field (little endian)
+	**   uint8_t type        - FarmMessageType
+	**   uint32_t task_id    - little endian
+	**   char[]              - payload (module path for TASK, handler result for RESULT, error for FAILURE)
+	*/
+	enum class FarmMessageType : uint8_t {
+		TASK = 1,		// coordinator -> worker
+		RESULT = 2,		// worker -> coordinator
+		FAILURE = 3,	// worker -> coordinator, handler threw an exception
+		SHUTDOWN = 4	// coordinator -> worker
+	};
+
+	struct FarmMessage {
+		FarmMessageType type;
+		uint32_t task_id;
+		std::string payload;
+	};
+
+	/** Encodes message as a frame
+	*
+	* \param _message Message
+	* \return Frame bytes
+	*/
+	CPPFAPIWRAPPER std::string encodeFarmMessage(const FarmMessage & _message);
+
+	/** Splits stream of bytes into messages, regardless of how bytes were chunked by reads */
+	class FarmDecoder
+	{
+	public:
+		CPPFAPIWRAPPER FarmDecoder();
+
+		/** Appends received bytes
+		*
+		* \param _data Received bytes
+		* \param _size Number of bytes
+		*/
+		CPPFAPIWRAPPER void feed(const char * _data, const size_t _size);
+
+		/** Takes next complete message. Throws an exception if stream is malformed.
+		*
+		* \param _message Decoded message
+		* \return False if there is no complete message yet
+		*/
+		CPPFAPIWRAPPER bool next(FarmMessage & _message);
+
+	private:
+		std::vector<char> buffer;
+		size_t offset;
+	};
+
+	/** Pair of OS pipe ends (file descriptors or HANDLEs) used to exchange messages. Owns the ends. */
+	class FarmPipe
+	{
+	public:
+		/** Creates pipe from OS handles
+		*
+		* \param _read_end Handle to read from, -1 if none
+		* \param _write_end Handle to write to, -1 if none
+		*/
+		CPPFAPIWRAPPER FarmPipe(intptr_t _read_end = -1, intptr_t _write_end = -1);
+		CPPFAPIWRAPPER FarmPipe(FarmPipe && _pipe);
+		CPPFAPIWRAPPER FarmPipe & operator=(FarmPipe && _pipe);
+		CPPFAPIWRAPPER ~FarmPipe();
+
+		/** Creates pipe from standard input and output of current process. Standard output is redirected to
+		* standard error afterwards, so nothing printed by a worker corrupts the protocol.
+		*
+		* \return Pipe
+		*/
+		CPPFAPIWRAPPER static FarmPipe standardIO();
+
+		/** Creates unidirectional OS pipe (socket pair on POSIX, so writing to closed pipe doesn't raise SIGPIPE)
+		*
+		* \param _read_end Handle to read from
+		* \param _write_end Handle to write to
+		*/
+		CPPFAPIWRAPPER static void createOSPipe(intptr_t & _read_end, intptr_t & _write_end);
+
+		/** Reads next message, blocking until it is complete
+		*
+		* \param _message Received message
+		* \return False if other side closed the pipe
+		*/
+		CPPFAPIWRAPPER bool read(FarmMessage & _message);
+
+		/** Writes message
+		*
+		* \param _message Message
+		* \return False if other side closed the pipe
+		*/
+		CPPFAPIWRAPPER bool write(const FarmMessage & _message);
+
+		/** Closes write end, so other side reads end of stream */
+		CPPFAPIWRAPPER void closeWrite();
+
+		FarmPipe(const FarmPipe & _pipe) = delete;
+		FarmPipe & operator=(const FarmPipe & _pipe) = delete;
+
+	private:
+		void close();
+
+		intptr_t read_end;
+		intptr_t write_end;
+		FarmDecoder decoder;
+	};
+}
+
+#endif // FARMPROTOCOL_H
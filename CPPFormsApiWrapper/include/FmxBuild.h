@@ -0,0 +1,172 @@
+#ifndef FMXBUILD_H
+#define FMXBUILD_H
+
+#include "dllmain.h"
+#include "FAPIUtil.h"
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include <fstream>
+
+namespace CPPFAPIWrapper {
+	class FAPIContext;
+	class WorkerLauncher;
+
+	struct JournalModule {
+		FileFingerprint fingerprint;			// fingerprint of .fmb/.pll, with content hash
+		std::vector<std::string> dependencies;	// direct dependencies of a module: "F:NAME" for source modules, "L:NAME" for libraries
+	};
+
+	struct JournalOutput {
+		uint64_t key;				// hash of module and all its dependencies at generation time
+		FileFingerprint output;		// fingerprint of generated file, without content hash
+	};
+
+	/** Persistent state of incremental builds: fingerprints and dependencies of scanned modules and inputs of
+	* generated files. Records are appended and flushed one by one, so build interrupted at any point keeps all work
+	* done before; later records override earlier ones. File is rewritten without overridden records by compact.
+	*/
+	class BuildJournal
+	{
+	public:
+		/** Opens journal, loading records of existing file. Unreadable records (ex. truncated by a crash) are skipped.
+		*
+		* \param _filepath Path to journal file, created if it doesn't exist
+		*/
+		CPPFAPIWRAPPER BuildJournal(const std::string & _filepath);
+
+		/** Gets recorded module
+		*
+		* \param _filepath Path to module
+		* \param _module Recorded fingerprint and dependencies
+		* \return False if module is not recorded
+		*/
+		CPPFAPIWRAPPER bool findModule(const std::string & _filepath, JournalModule & _module) const;
+
+		/** Records module
+		*
+		* \param _filepath Path to module
+		* \param _module Fingerprint and dependencies
+		*/
+		CPPFAPIWRAPPER void recordModule(const std::string & _filepath, const JournalModule & _module);
+
+		/** Gets recorded output of a module
+		*
+		* \param _filepath Path to module
+		* \param _output Inputs key and fingerprint of generated file
+		* \return False if module wasn't generated
+		*/
+		CPPFAPIWRAPPER bool findOutput(const std::string & _filepath, JournalOutput & _output) const;
+
+		/** Records output of a module
+		*
+		* \param _filepath Path to module
+		* \param _output Inputs key and fingerprint of generated file
+		*/
+		CPPFAPIWRAPPER void recordOutput(const std::string & _filepath, const JournalOutput & _output);
+
+		/** Removes recorded output, so module is generated by next build
+		*
+		* \param _filepath Path to module
+		*/
+		CPPFAPIWRAPPER void forgetOutput(const std::string & _filepath);
+
+		/** Rewrites journal file with current records only */
+		CPPFAPIWRAPPER void compact();
+
+		BuildJournal() = delete;
+		BuildJournal(const BuildJournal & _journal) = delete;
+		BuildJournal & operator=(const BuildJournal & _journal) = delete;
+
+	private:
+		void load();
+		void append(const std::string & _line);
+
+		std::string filepath;
+		std::ofstream file;
+		std::unordered_map<std::string, JournalModule> modules;
+		std::unordered_map<std::string, JournalOutput> outputs;
+	};
+
+	enum class CPPFAPIWRAPPER FmxBuildStatus {
+		UP_TO_DATE,		// .fmx generated from current module and dependencies exists
+		GENERATED,
+		FAILED,
+		SKIPPED			// source module of a form failed
+	};
+
+	struct FmxBuildResult {
+		std::string path;		// path to .fmb
+		FmxBuildStatus status;
+		std::string message;	// error message of failed module, path of failed source module of skipped one
+	};
+
+	/** Generates .fmx files of many forms, regenerating only forms whose .fmb, source modules (recurrently) or attached
+	* libraries changed since their .fmx was generated, or whose .fmx is missing or was replaced. Dependencies are
+	* scanned in the coordinator's context (only for modules changed since previous build) and forms are generated
+	* by a WorkerFarm in waves, every form after its source modules; dependents of a failed form are skipped.
+	* Progress is kept in a BuildJournal, so interrupted build continues where it stopped.
+	*/
+	class FmxBuilder
+	{
+	public:
+		/** Creates builder
+		*
+		* \param _ctx Context used for scanning dependencies
+		* \param _launcher Starts workers generating forms (see generateForm), must outlive the builder
+		* \param _workers Number of workers
+		* \param _journal_path Path to build journal
+		*/
+		CPPFAPIWRAPPER FmxBuilder(FAPIContext & _ctx, WorkerLauncher & _launcher, const size_t _workers, const std::string & _journal_path);
+
+		/** Generates forms which are not up to date. Throws an exception if a dependency can't be scanned or
+		* resolved (and ignore parameter is set to false), or if source modules form a cycle.
+		*
+		* \param _filepaths Paths to .fmb files
+		* \param _on_result Function called as soon as result of a form is known
+		* \param _force If True, all forms are generated
+		* \param _ignore_missing_libs If True, unresolvable PLSQL libraries are ignored when computing fingerprints
+		* \param _ignore_missing_sub If True, unresolvable source modules are ignored when computing fingerprints
+		* \return Results in order of _filepaths
+		*/
+		CPPFAPIWRAPPER std::vector<FmxBuildResult> build(const std::vector<std::string> & _filepaths, std::function<void(const FmxBuildResult &)> _on_result = nullptr,
+			const bool _force = false, const bool _ignore_missing_libs = false, const bool _ignore_missing_sub = false);
+
+		/** Gets journal of the builder
+		*
+		* \return Reference to journal
+		*/
+		CPPFAPIWRAPPER BuildJournal & getJournal();
+
+		/** Worker handler generating a form, to be passed to runFarmWorkerProcess
+		*
+		* \param _ctx Context of worker
+		* \param _filepath Path to .fmb
+		* \return Empty string
+		*/
+		CPPFAPIWRAPPER static std::string generateForm(FAPIContext & _ctx, const std::string & _filepath);
+
+		/** Gets path of .fmx generated from a given .fmb (same directory and name)
+		*
+		* \param _filepath Path to .fmb
+		* \return Path to .fmx
+		*/
+		CPPFAPIWRAPPER static std::string fmxPath(const std::string & _filepath);
+
+		FmxBuilder() = delete;
+		FmxBuilder(const FmxBuilder & _builder) = delete;
+		FmxBuilder & operator=(const FmxBuilder & _builder) = delete;
+
+	private:
+		JournalModule fingerprintModule(const std::string & _filepath, const bool _form, const bool _ignore_missing_libs, const bool _ignore_missing_sub);
+
+		FAPIContext & ctx;
+		WorkerLauncher & launcher;
+		size_t workers;
+		BuildJournal journal;
+	};
+}
+
+#endif // FMXBUILD_H
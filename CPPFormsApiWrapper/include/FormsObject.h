@@ -10,6 +10,7 @@
 #include <functional>
 
 #include "Expected.h"
+#include "PlsqlLexer.h"
 
 namespace CPPFAPIWrapper {
 	class FAPIModule;
@@ -26,16 +27,26 @@ namespace CPPFAPIWrapper {
 		* \param _level Hierarchy level of object
 		*/
 		CPPFAPIWRAPPER FormsObject(FAPIModule * _module, int _type_id, void * _forms_obj, int _level);
+
+		/** Creates FormsObject object without OracleForms object. Used when restoring module from snapshot;
+		* OracleForms object is bound later, when needed (see FAPIModule::attachNative).
+		*
+		* \param _module Pointer to FAPIModule.
+		* \param _type_id OracleForms object type id
+		* \param _level Hierarchy level of object
+		* \param _subclassed True if object is subclassed from another object
+		*/
+		CPPFAPIWRAPPER FormsObject(FAPIModule * _module, int _type_id, int _level, bool _subclassed);
 		CPPFAPIWRAPPER ~FormsObject();
 
-		/** Marks property for setting its value
+		/** Marks property for setting its value. Constant time, property keeps its position in marked properties.
 		*
 		* \param _property Pointer to property
 		*/
 		CPPFAPIWRAPPER void markProperty(Property * _property);
 
-		/** Unmarks property from setting its value. In addition, unmarks current FormsObject
-		* from FAPIModule if last property is unmarked.
+		/** Unmarks property from setting its value (constant time, last marked property takes its place). In addition,
+		* unmarks current FormsObject from FAPIModule if last property is unmarked.
 		*
 		* \param _property Pointer to property
 		*/
@@ -47,6 +58,11 @@ namespace CPPFAPIWrapper {
 		*/
 		CPPFAPIWRAPPER void setProperty(Property * _property);
 
+		/** Sets internal OracleForms values of all marked properties and unmarks them. If setting fails, properties
+		* not set yet stay marked.
+		*/
+		CPPFAPIWRAPPER void applyMarkedProperties();
+
 		/** Inherits all properties for current object from source object */
 		CPPFAPIWRAPPER void inheritAllProp();
 
@@ -153,6 +169,12 @@ namespace CPPFAPIWrapper {
 		*/
 		CPPFAPIWRAPPER void * getFormsObj() const;
 
+		/** Binds OracleForms object with current object. Used by FAPIModule, shouldn't be called directly.
+		*
+		* \param _forms_obj OracleForms object pointer
+		*/
+		CPPFAPIWRAPPER void attachFormsObj(void * _forms_obj);
+
 		/** Gets FAPIContext which module is assigned to.
 		*
 		* \return FAPIContext pointer
@@ -171,6 +193,12 @@ namespace CPPFAPIWrapper {
 		*/
 		CPPFAPIWRAPPER std::string getName();
 
+		/** Gets full name of an object, made of names of all its parents (excluding module) separated by dot
+		*
+		* \return Full name of an object (ex. MY_BLOCK.MY_ITEM.WHEN-VALIDATE-ITEM).
+		*/
+		CPPFAPIWRAPPER std::string getFullName();
+
 		/** Gets map of children (all children) as a reference
 		*
 		* \return Map of children
@@ -187,16 +215,32 @@ namespace CPPFAPIWrapper {
 		*
 		* \return Collection of Property pointers
 		*/
-		CPPFAPIWRAPPER std::vector<Property *> & getMarkedProperties();
+		CPPFAPIWRAPPER const std::vector<Property *> & getMarkedProperties() const;
+
+		/** Gets PLSQL tokens of trigger or program unit text. Text is tokenized on first call and cached until it
+		* changes, so analyses of the same unit share one token stream.
+		*
+		* \return Tokens of code, empty for objects without PLSQL code
+		*/
+		CPPFAPIWRAPPER const std::vector<PlsqlToken> & getTokens();
+
+		/** Drops cached tokens, so code is tokenized again on next getTokens call. Called by Property when text changes.
+		*/
+		CPPFAPIWRAPPER void invalidateTokens();
 	private:
+		friend class FAPIModule;
+
 		FAPIModule * module;
 		FormsObject * parent;
 		int type_id;		 // internal forms api obj type id
 		std::unique_ptr<void, std::function<void(const void*)>> forms_obj;  // internal forms api obj
 		int level;
+		bool subclassed;
 		std::unordered_map<int, std::vector<std::unique_ptr<FormsObject>>> children;
 		std::unordered_map<int, std::unique_ptr<Property>> properties;
 		std::vector<Property *> marked_properties;
+		size_t mark_index;	// position in module's marked objects, Property::NOT_MARKED if not marked
+		std::unique_ptr<std::vector<PlsqlToken>> tokens;	// cached tokens of PLSQL text, null until requested
 	};
 }
 
@@ -0,0 +1,47 @@
+#ifndef GLOBALSCANNER_H
+#define GLOBALSCANNER_H
+
+#include "dllmain.h"
+#include "PlsqlLexer.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace CPPFAPIWrapper {
+
+	struct GlobalReference {
+		std::string name;	// uppercase variable name, without GLOBAL. prefix
+		size_t offset;		// offset of reference in code
+		size_t line;		// line of reference, starting from 1
+		size_t column;		// column of reference, starting from 1
+		bool quoted;		// referenced by name in a string literal, ex. NAME_IN('GLOBAL.NAME')
+	};
+
+	/** Finds all references to global variables in PLSQL code in a single pass: :GLOBAL.NAME references and string
+	* literals containing only a global variable name (as passed to NAME_IN, COPY, DEFAULT_VALUE, ERASE). Prefix is
+	* matched case-insensitively; comments, quoted identifiers and other string literals are skipped.
+	*
+	* \param _code PLSQL code
+	* \param _references Collection found references are appended to
+	*/
+	CPPFAPIWRAPPER void scanGlobals(std::string_view _code, std::vector<GlobalReference> & _references);
+
+	/** Finds all references to global variables in PLSQL code (see scanGlobals above)
+	*
+	* \param _code PLSQL code
+	* \return References in order of occurrence
+	*/
+	CPPFAPIWRAPPER std::vector<GlobalReference> scanGlobals(std::string_view _code);
+
+	/** Finds all references to global variables (see scanGlobals above) in already tokenized code, ex. tokens cached
+	* by FormsObject::getTokens. Only bind and string literal tokens are checked.
+	*
+	* \param _code PLSQL code
+	* \param _tokens Tokens of code returned by tokenizePlsql
+	* \param _references Collection found references are appended to
+	*/
+	CPPFAPIWRAPPER void scanGlobals(std::string_view _code, const std::vector<PlsqlToken> & _tokens, std::vector<GlobalReference> & _references);
+}
+
+#endif // GLOBALSCANNER_H
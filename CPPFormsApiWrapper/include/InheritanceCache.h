@@ -0,0 +1,96 @@
+#ifndef INHERITANCECACHE_H
+#define INHERITANCECACHE_H
+
+#include "dllmain.h"
+#include "Property.h"
+#include "FAPIUtil.h"
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace CPPFAPIWrapper {
+
+	struct SourceCheck {
+		std::string path;	// path to source module file
+		FileFingerprint fingerprint;	// fingerprint of source module at the time of check
+	};
+
+	struct ObjectCheck {
+		std::vector<std::string> source_modules;	// names of external modules in object's source chain
+		std::vector<std::pair<int, PropState>> results;	// properties for which check changed something (OVERRIDEN or INHERITED)
+	};
+
+	struct ModuleCheck {
+		FileFingerprint fingerprint;	// fingerprint of checked module
+		std::unordered_map<std::string, SourceCheck> sources;	// key is source module name
+		std::unordered_map<std::string, ObjectCheck> objects;	// key is "type_id:FULL.NAME" of checked object
+	};
+
+	class InheritanceCache
+	{
+	public:
+		/** Creates empty InheritanceCache object */
+		CPPFAPIWRAPPER InheritanceCache();
+
+		/** Loads cache from a file. Missing file results in empty cache.
+		*
+		* \param _filepath Path to cache file
+		*/
+		CPPFAPIWRAPPER void load(const std::string & _filepath);
+
+		/** Saves cache to a file.
+		*
+		* \param _filepath Path to cache file
+		*/
+		CPPFAPIWRAPPER void save(const std::string & _filepath) const;
+
+		/** Checks if cache has results for a module, and module's file didn't change since then.
+		*
+		* \param _filepath Path to .fmb file
+		* \return True if recorded results can be reused
+		*/
+		CPPFAPIWRAPPER bool isValid(const std::string & _filepath) const;
+
+		/** Gets names of source modules, which changed since module was checked.
+		*
+		* \param _filepath Path to .fmb file
+		* \return Set of changed source module names
+		*/
+		CPPFAPIWRAPPER std::unordered_set<std::string> getChangedSources(const std::string & _filepath) const;
+
+		/** Checks if cache has results for a module
+		*
+		* \param _filepath Path to .fmb file
+		* \return True if module was recorded
+		*/
+		CPPFAPIWRAPPER bool hasModule(const std::string & _filepath) const;
+
+		/** Gets recorded results for a module, creates empty ones if module wasn't recorded.
+		*
+		* \param _filepath Path to .fmb file
+		* \return Reference to module results
+		*/
+		CPPFAPIWRAPPER ModuleCheck & getModule(const std::string & _filepath);
+
+		/** Records that a checked module was saved: its current file becomes the checked one, and INHERITED results,
+		* which saving wrote to the file, are not replayed anymore. Call after saving a module checked with
+		* FAPIForm::checkOverriden(InheritanceCache &), otherwise next check sees changed module and checks it all.
+		*
+		* \param _filepath Path to .fmb file
+		*/
+		CPPFAPIWRAPPER void refreshModule(const std::string & _filepath);
+
+		/** Removes module results from cache
+		*
+		* \param _filepath Path to .fmb file
+		*/
+		CPPFAPIWRAPPER void removeModule(const std::string & _filepath);
+
+	private:
+		std::unordered_map<std::string, ModuleCheck> modules;
+	};
+}
+
+#endif // INHERITANCECACHE_H
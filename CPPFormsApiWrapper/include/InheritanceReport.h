@@ -0,0 +1,78 @@
+#ifndef INHERITANCEREPORT_H
+#define INHERITANCEREPORT_H
+
+#include "dllmain.h"
+#include "Property.h"
+
+#include <string>
+#include <ostream>
+
+namespace CPPFAPIWrapper {
+
+	struct InheritanceRecord {
+		std::string module;			// path to module
+		int object_type;			// OracleForms object type id
+		std::string object;			// full name of object
+		int prop_id;				// OracleForms property id
+		std::string local_value;	// value in checked module
+		std::string source_value;	// value of nearest source object property, empty if not found
+		PropState state;			// OVERRIDEN if values differ, INHERITED if equal (inheritance can be restored), LOCAL if no source defines it
+	};
+
+	class InheritanceSink
+	{
+	public:
+		CPPFAPIWRAPPER virtual ~InheritanceSink();
+
+		/** Writes single record of inheritance report
+		*
+		* \param _record Record to write
+		*/
+		CPPFAPIWRAPPER virtual void write(const InheritanceRecord & _record) = 0;
+
+		/** Flushes written records */
+		CPPFAPIWRAPPER virtual void flush();
+	};
+
+	class JsonLinesSink : public InheritanceSink
+	{
+	public:
+		/** Creates sink writing one JSON object per line
+		*
+		* \param _stream Output stream, must outlive the sink
+		*/
+		CPPFAPIWRAPPER JsonLinesSink(std::ostream & _stream);
+
+		CPPFAPIWRAPPER void write(const InheritanceRecord & _record) override;
+		CPPFAPIWRAPPER void flush() override;
+
+	private:
+		std::ostream & stream;
+	};
+
+	class CsvSink : public InheritanceSink
+	{
+	public:
+		/** Creates sink writing comma separated values, with header line
+		*
+		* \param _stream Output stream, must outlive the sink
+		*/
+		CPPFAPIWRAPPER CsvSink(std::ostream & _stream);
+
+		CPPFAPIWRAPPER void write(const InheritanceRecord & _record) override;
+		CPPFAPIWRAPPER void flush() override;
+
+	private:
+		std::ostream & stream;
+		bool header_written;
+	};
+
+	/** Returns name of a property state
+	*
+	* \param _state Property state
+	* \return State name (DEFAULT/LOCAL/INHERITED/OVERRIDEN)
+	*/
+	CPPFAPIWRAPPER std::string propStateToString(const PropState _state);
+}
+
+#endif // INHERITANCEREPORT_H
@@ -0,0 +1,91 @@
+#ifndef MODULEGRAPH_H
+#define MODULEGRAPH_H
+
+#include "dllmain.h"
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace CPPFAPIWrapper {
+
+	enum class CPPFAPIWRAPPER ModuleKind {
+		FORM,
+		LIBRARY
+	};
+
+	struct ModuleNode {
+		std::string name;	// uppercase module name, without extension
+		std::string path;	// resolved path to .fmb/.pll, empty if couldn't be resolved
+		ModuleKind kind;
+		std::unordered_set<std::string> dependencies;	// names of source modules and attached libraries
+		std::unordered_set<std::string> dependents;	// names of modules which depends on this one
+	};
+
+	class ModuleGraph
+	{
+	public:
+		/** Creates empty ModuleGraph object */
+		CPPFAPIWRAPPER ModuleGraph();
+
+		/** Adds module to the graph. If module already exists, only empty path is updated.
+		*
+		* \param _name Module name
+		* \param _path Path to module file, may be empty
+		* \param _kind Kind of module (form or PLSQL library)
+		*/
+		CPPFAPIWRAPPER void addModule(const std::string & _name, const std::string & _path, const ModuleKind _kind);
+
+		/** Adds dependency edge between two modules. Modules have to be added earlier.
+		*
+		* \param _name Name of dependent module
+		* \param _dependency Name of module which _name module depends on
+		*/
+		CPPFAPIWRAPPER void addDependency(const std::string & _name, const std::string & _dependency);
+
+		/** Checks if graph contains module
+		*
+		* \param _name Module name
+		* \return True if module is a node of the graph
+		*/
+		CPPFAPIWRAPPER bool hasModule(const std::string & _name) const;
+
+		/** Gets graph node of a given module. Throws an exception if module doesn't exist.
+		*
+		* \param _name Module name
+		* \return Reference to graph node
+		*/
+		CPPFAPIWRAPPER const ModuleNode & getModule(const std::string & _name) const;
+
+		/** Gets all graph nodes
+		*
+		* \return Map of nodes, where key is uppercase module name
+		*/
+		CPPFAPIWRAPPER const std::unordered_map<std::string, ModuleNode> & getModules() const;
+
+		/** Searches for dependency cycle in the graph.
+		*
+		* \return Names of modules forming a cycle (first module repeated at the end), empty if graph is acyclic
+		*/
+		CPPFAPIWRAPPER std::vector<std::string> findCycle() const;
+
+		/** Checks if graph has dependency cycle
+		*
+		* \return True if cycle exists
+		*/
+		CPPFAPIWRAPPER bool hasCycle() const;
+
+		/** Gets modules sorted in topological order, so every module is placed after all its dependencies.
+		* Throws an exception if graph has a cycle.
+		*
+		* \return Collection of module names
+		*/
+		CPPFAPIWRAPPER std::vector<std::string> topologicalOrder() const;
+
+	private:
+		std::unordered_map<std::string, ModuleNode> nodes;
+	};
+}
+
+#endif // MODULEGRAPH_H
@@ -0,0 +1,337 @@
+#ifndef MODULEIMAGE_H
+#define MODULEIMAGE_H
+
+#include "dllmain.h"
+#include "ModuleSnapshot.h"
+#include "Property.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <iterator>
+#include <cstddef>
+
+namespace CPPFAPIWrapper {
+	class ModuleImage;
+
+	/** Range of consecutive records of a module image. Items are created on the fly, nothing is allocated. */
+	template<class T>
+	class ImageRange
+	{
+	public:
+		class iterator
+		{
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = T;
+			using difference_type = std::ptrdiff_t;
+			using pointer = const T *;
+			using reference = T;
+
+			iterator(const ModuleImage * _image, uint32_t _index) : image(_image), index(_index) {}
+
+			T operator*() const { return T{ image, index }; }
+			iterator & operator++() { ++index; return *this; }
+			iterator operator++(int) { iterator prev{ *this }; ++index; return prev; }
+			bool operator==(const iterator & _other) const { return index == _other.index; }
+			bool operator!=(const iterator & _other) const { return index != _other.index; }
+
+		private:
+			const ModuleImage * image;
+			uint32_t index;
+		};
+
+		ImageRange(const ModuleImage * _image, uint32_t _first, uint32_t _count) : image(_image), first(_first), count(_count) {}
+
+		iterator begin() const { return iterator{ image, first }; }
+		iterator end() const { return iterator{ image, first + count }; }
+		size_t size() const { return count; }
+		bool empty() const { return count == 0; }
+		T operator[](size_t _pos) const { return T{ image, first + static_cast<uint32_t>(_pos) }; }
+
+	private:
+		const ModuleImage * image;
+		uint32_t first;
+		uint32_t count;
+	};
+
+	/** Read-only view of a property stored in module image */
+	class ImageProperty
+	{
+	public:
+		/** Creates view of a property. Used by ModuleImage, shouldn't be called directly.
+		*
+		* \param _image Module image, nullptr for not existing property
+		* \param _index Index of property record
+		*/
+		CPPFAPIWRAPPER ImageProperty(const ModuleImage * _image, uint32_t _index);
+
+		/** Checks if property exists
+		*
+		* \return False if property wasn't found
+		*/
+		CPPFAPIWRAPPER bool isValid() const;
+
+		/** Gets OracleForms property id
+		*
+		* \return Property id
+		*/
+		CPPFAPIWRAPPER int getId() const;
+
+		/** Gets OracleForms property type (D2FP_TYP_*)
+		*
+		* \return Property type
+		*/
+		CPPFAPIWRAPPER int getType() const;
+
+		/** Gets property value, pointing directly into mapped file
+		*
+		* \return Property value, valid as long as ModuleImage exists
+		*/
+		CPPFAPIWRAPPER std::string_view getValue() const;
+
+		/** Gets property state, as it was when module was traversed
+		*
+		* \return Property state
+		*/
+		CPPFAPIWRAPPER PropState getState() const;
+
+		/** Allows writing same code for ImageProperty and Property * */
+		const ImageProperty * operator->() const { return this; }
+
+	private:
+		const SnapshotProperty & record() const;
+
+		const ModuleImage * image;
+		uint32_t index;
+	};
+
+	using ImagePropertyRange = ImageRange<ImageProperty>;
+
+	/** Read-only view of an object stored in module image */
+	class ImageObject
+	{
+	public:
+		/** Creates view of an object. Used by ModuleImage, shouldn't be called directly.
+		*
+		* \param _image Module image, nullptr for not existing object
+		* \param _index Index of object record
+		*/
+		CPPFAPIWRAPPER ImageObject(const ModuleImage * _image, uint32_t _index);
+
+		/** Checks if object exists
+		*
+		* \return False if object wasn't found
+		*/
+		CPPFAPIWRAPPER bool isValid() const;
+
+		/** Gets object's type id
+		*
+		* \return OracleForms object's type id
+		*/
+		CPPFAPIWRAPPER int getId() const;
+
+		/** Gets hierarchy level
+		*
+		* \return Hierarchy level of an object
+		*/
+		CPPFAPIWRAPPER int getLevel() const;
+
+		/** Gets name of an object, pointing directly into mapped file
+		*
+		* \return Name of an object, valid as long as ModuleImage exists
+		*/
+		CPPFAPIWRAPPER std::string_view getName() const;
+
+		/** Gets full name of an object, made of names of all its parents (excluding module) separated by dot
+		*
+		* \return Full name of an object (ex. MY_BLOCK.MY_ITEM.WHEN-VALIDATE-ITEM).
+		*/
+		CPPFAPIWRAPPER std::string getFullName() const;
+
+		/** Checks if object is subclassed from another object.
+		*
+		* \return True if subclassed.
+		*/
+		CPPFAPIWRAPPER bool isSubclassed() const;
+
+		/** Gets parent object
+		*
+		* \return Parent object, not valid for module root
+		*/
+		CPPFAPIWRAPPER ImageObject getParent() const;
+
+		/** Gets all children of an object, ordered by type id
+		*
+		* \return Range of children
+		*/
+		CPPFAPIWRAPPER ImageRange<ImageObject> getChildren() const;
+
+		/** Gets all children by a given type
+		*
+		* \param _type_id OracleForms object type id
+		* \return Range of children
+		*/
+		CPPFAPIWRAPPER ImageRange<ImageObject> getObjects(const int _type_id) const;
+
+		/** Gets child object given by a parameters (case insensitive).
+		*
+		* \param _type_id OracleForms object type id
+		* \param _name Object's name
+		* \return Child object, not valid if not found
+		*/
+		CPPFAPIWRAPPER ImageObject getObject(const int _type_id, std::string_view _name) const;
+
+		/** Checks if has child object given by a parameters.
+		*
+		* \param _type_id OracleForms object type id
+		* \param _name Object's name
+		* \return True if current object has child.
+		*/
+		CPPFAPIWRAPPER bool hasObject(const int _type_id, std::string_view _name) const;
+
+		/** Gets all properties of an object, ordered by property id
+		*
+		* \return Range of properties
+		*/
+		CPPFAPIWRAPPER ImagePropertyRange getProperties() const;
+
+		/** Gets property by its id (binary search)
+		*
+		* \param _prop_id OracleForms property id
+		* \return Property, not valid if object doesn't have it
+		*/
+		CPPFAPIWRAPPER ImageProperty getProperty(const int _prop_id) const;
+
+		/** Checks if object has a property
+		*
+		* \param _prop_id OracleForms property id
+		* \return True if object has property
+		*/
+		CPPFAPIWRAPPER bool hasProperty(const int _prop_id) const;
+
+		/** Allows writing same code for ImageObject and FormsObject * / Expected<FormsObject> */
+		const ImageObject * operator->() const { return this; }
+
+	private:
+		const SnapshotNode & record() const;
+
+		const ModuleImage * image;
+		uint32_t index;
+	};
+
+	using ImageObjectRange = ImageRange<ImageObject>;
+
+	/** Read-only module, memory mapped from a snapshot file (see ModuleSnapshot). Opening doesn't depend on size
+	* of a module: only header is checked, records are read (and bounds checked) when accessed. Strings are
+	* returned as views into mapped file, so nothing is copied or allocated per object. Query functions mirror
+	* FAPIModule and FormsObject, so analysis code can be written for both live and mapped modules.
+	*
+	* On Windows mapped file can't be replaced, so snapshot of a module can't be refreshed (see ModuleSnapshot::save)
+	* as long as any image of that snapshot exists. Other platforms replace the file and existing images keep
+	* mapping the old one.
+	*/
+	class ModuleImage
+	{
+	public:
+		/** Maps snapshot file into memory. Throws an exception if file can't be mapped or isn't a valid snapshot.
+		*
+		* \param _snapshot_path Path to snapshot file
+		*/
+		CPPFAPIWRAPPER ModuleImage(const std::string & _snapshot_path);
+		CPPFAPIWRAPPER ~ModuleImage();
+
+		/** Checks if module file didn't change since snapshot was taken
+		*
+		* \param _filepath Path to .fmb/.pll file
+		* \return True if image reflects current module file
+		*/
+		CPPFAPIWRAPPER bool isValid(const std::string & _filepath) const;
+
+		/** Gets path of module, which image was made from (upper case)
+		*
+		* \return Path to .fmb/.pll file
+		*/
+		CPPFAPIWRAPPER std::string_view getFilepath() const;
+
+		/** Gets name of a module
+		*
+		* \return Name of module.
+		*/
+		CPPFAPIWRAPPER std::string getName() const;
+
+		/** Gets root object of module
+		*
+		* \return Root object
+		*/
+		CPPFAPIWRAPPER ImageObject getRoot() const;
+
+		/** Gets number of objects in module, including root
+		*
+		* \return Number of objects
+		*/
+		CPPFAPIWRAPPER size_t getObjectCount() const;
+
+		/** Gets names of source modules, which module inherits from
+		*
+		* \return Collection of source module names
+		*/
+		CPPFAPIWRAPPER std::vector<std::string_view> getSourceModules() const;
+
+		/** Gets names of PLSQL libraries attached to module
+		*
+		* \return Collection of attached library names
+		*/
+		CPPFAPIWRAPPER std::vector<std::string_view> getLibraryModules() const;
+
+		/** Checks if contains a given object.
+		*
+		* \param _type_id OracleForms object type id
+		* \param _name Name of object
+		* \return True if module has object, false otherwise.
+		*/
+		CPPFAPIWRAPPER bool hasObject(const int _type_id, std::string_view _name) const;
+
+		/** Gets given object from module
+		*
+		* \param _type_id OracleForms object type id
+		* \param _fullname Full name of object (ex. for item object you could try to find "MY_BLOCK.MY_ITEM")
+		* \return Object, not valid if not found
+		*/
+		CPPFAPIWRAPPER ImageObject getObject(const int _type_id, const std::string & _fullname) const;
+
+		/** Gets objects which lies directly under root object in hierarchy
+		*
+		* \param _type_id OracleForms object type id
+		* \return Range of objects
+		*/
+		CPPFAPIWRAPPER ImageObjectRange getObjects(const int _type_id) const;
+
+		ModuleImage() = delete;
+		ModuleImage(ModuleImage && _image) = delete;
+		ModuleImage & operator=(ModuleImage && _image) = delete;
+		ModuleImage(const ModuleImage & _image) = delete;
+		ModuleImage & operator=(const ModuleImage & _image) = delete;
+
+	private:
+		friend class ImageObject;
+		friend class ImageProperty;
+
+		const SnapshotNode & node(const uint32_t _index) const;
+		const SnapshotProperty & property(const uint32_t _index) const;
+		std::string_view text(const uint32_t _id) const;
+		void unmap();
+
+		std::string snapshot_path;
+		const char * data;
+		size_t size;
+		const SnapshotHeader * header;
+		const SnapshotNode * nodes;
+		const SnapshotProperty * props;
+		const uint32_t * sources;
+		const uint32_t * libraries;
+		const SnapshotString * strings;
+	};
+}
+
+#endif // MODULEIMAGE_H
@@ -0,0 +1,173 @@
+#ifndef MODULEPATHRESOLVER_H
+#define MODULEPATHRESOLVER_H
+
+#include "dllmain.h"
+#include "FAPIUtil.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace CPPFAPIWrapper {
+	/** Provides directories searched for modules, in search order */
+	class PathSource
+	{
+	public:
+		CPPFAPIWRAPPER virtual ~PathSource();
+
+		/** Gets directories, each ending with a path separator
+		*
+		* \return Collection of directories paths
+		*/
+		CPPFAPIWRAPPER virtual std::vector<std::string> getDirectories() const = 0;
+	};
+
+	/** Directories from environment variable, separated by ';' (or ':' on systems other than Windows) */
+	class EnvironmentPathSource : public PathSource
+	{
+	public:
+		/** Creates path source
+		*
+		* \param _variable Name of environment variable
+		*/
+		CPPFAPIWRAPPER EnvironmentPathSource(const std::string & _variable = "FORMS60_PATH");
+
+		CPPFAPIWRAPPER std::vector<std::string> getDirectories() const override;
+
+	private:
+		std::string variable;
+	};
+
+	/** Directories from a text file, one or more (separated as in EnvironmentPathSource) per line. Lines starting
+	* with '#' are ignored. File is read each time directories are requested.
+	*/
+	class ConfigFilePathSource : public PathSource
+	{
+	public:
+		/** Creates path source
+		*
+		* \param _filepath Path to configuration file
+		*/
+		CPPFAPIWRAPPER ConfigFilePathSource(const std::string & _filepath);
+
+		CPPFAPIWRAPPER std::vector<std::string> getDirectories() const override;
+
+	private:
+		std::string filepath;
+	};
+
+	/** Fixed list of directories */
+	class ListPathSource : public PathSource
+	{
+	public:
+		/** Creates path source
+		*
+		* \param _directories Directories paths
+		*/
+		CPPFAPIWRAPPER ListPathSource(const std::vector<std::string> & _directories);
+
+		CPPFAPIWRAPPER std::vector<std::string> getDirectories() const override;
+
+	private:
+		std::vector<std::string> directories;
+	};
+
+#ifdef _WIN32
+	/** Directories from registry value (by default HKLM\SOFTWARE\ORACLE\FORMS60_PATH) */
+	class RegistryPathSource : public PathSource
+	{
+	public:
+		/** Creates path source
+		*
+		* \param _key_path Path of registry key under HKEY_LOCAL_MACHINE
+		* \param _key_name Name of registry value
+		*/
+		CPPFAPIWRAPPER RegistryPathSource(const std::string & _key_path = "SOFTWARE\\ORACLE", const std::string & _key_name = "FORMS60_PATH");
+
+		CPPFAPIWRAPPER std::vector<std::string> getDirectories() const override;
+
+	private:
+		std::string key_path;
+		std::string key_name;
+	};
+#endif
+
+	/** Finds module files by name (case insensitive) in directories given by a path source. Directories are listed
+	* once and file names are kept in an index, so resolving doesn't touch the file system. Index is rebuilt by
+	* refresh, after path source changes, or when a name is not found and one of the directories was modified
+	* since it was listed.
+	*/
+	class ModulePathResolver
+	{
+	public:
+		/** Creates resolver, directories are listed at first use
+		*
+		* \param _source Path source, default one if null (see defaultPathSource)
+		*/
+		CPPFAPIWRAPPER ModulePathResolver(std::unique_ptr<PathSource> _source = nullptr);
+
+		/** Gets path source used when no other is given: environment variable FORMS60_PATH if it is set,
+		* otherwise (on Windows) registry value HKLM\SOFTWARE\ORACLE\FORMS60_PATH.
+		*
+		* \return Path source
+		*/
+		CPPFAPIWRAPPER static std::unique_ptr<PathSource> defaultPathSource();
+
+		/** Replaces path source, index is rebuilt at next use
+		*
+		* \param _source Path source
+		*/
+		CPPFAPIWRAPPER void setPathSource(std::unique_ptr<PathSource> _source);
+
+		/** Gets searched directories
+		*
+		* \return Collection of directories paths, in search order
+		*/
+		CPPFAPIWRAPPER std::vector<std::string> getDirectories();
+
+		/** Gets path to a file from the first directory containing it. Throws an exception if there's no such file.
+		*
+		* \param _filename File name with extension (e.g. MODULE.FMB), case insensitive
+		* \return Path to a file (uppercase on Windows)
+		*/
+		CPPFAPIWRAPPER std::string resolve(const std::string & _filename);
+
+		/** Gets path to a file from the first directory containing it
+		*
+		* \param _filename File name with extension, case insensitive
+		* \param _filepath Path to a file, unchanged if not found
+		* \return False if there's no such file
+		*/
+		CPPFAPIWRAPPER bool tryResolve(const std::string & _filename, std::string & _filepath);
+
+		/** Reads path source and lists directories again */
+		CPPFAPIWRAPPER void refresh();
+
+		/** Drops index, path source is read and directories are listed again at next use */
+		CPPFAPIWRAPPER void invalidate();
+
+		ModulePathResolver(const ModulePathResolver & _resolver) = delete;
+		ModulePathResolver & operator=(const ModulePathResolver & _resolver) = delete;
+
+	private:
+		void build();
+		bool directoriesChanged() const;
+
+		std::unique_ptr<PathSource> source;
+		std::vector<std::string> directories;
+		std::vector<FileFingerprint> stamps;
+		std::unordered_map<std::string, std::string> index;
+		bool built;
+		std::mutex resolver_mutex;
+	};
+
+	/** Gets resolver used by modulePathFromName and libraryPathFromName
+	*
+	* \return Resolver
+	*/
+	CPPFAPIWRAPPER ModulePathResolver & getModulePathResolver();
+}
+
+#endif // MODULEPATHRESOLVER_H
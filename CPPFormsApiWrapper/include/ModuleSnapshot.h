@@ -0,0 +1,117 @@
+#ifndef MODULESNAPSHOT_H
+#define MODULESNAPSHOT_H
+
+#include "dllmain.h"
+#include "FAPIUtil.h"
+
+#include <string>
+#include <cstdint>
+
+namespace CPPFAPIWrapper {
+	class FAPIModule;
+
+	/*
+	** Snapshot file layout (little endian, all sections 8-byte aligned):
+	**   SnapshotHeader
+	**   SnapshotNode[node_count]         - objects in breadth-first order, so children of a node are contiguous (ordered by type_id)
+	**   SnapshotProperty[prop_count]     - properties of a node are contiguous, sorted by prop_id
+	**   uint32_t[source_count]           - string ids of source module names
+	**   uint32_t[library_count]          - string ids of attached library names
+	**   SnapshotString[string_count]     - string table, offsets relative to string data
+	**   char[]                           - string data, every string is NUL terminated
+	*/
+	constexpr uint32_t SNAPSHOT_VERSION = 2;
+	constexpr uint32_t SNAPSHOT_NONE = 0xFFFFFFFF;
+	constexpr uint32_t SNAPSHOT_SUBCLASSED = 0x1;
+
+	struct SnapshotHeader {
+		char magic[8];			// "CFAPISNP"
+		uint32_t version;
+		uint32_t path;			// string id of module path
+		int64_t file_size;		// fingerprint of module file at the time snapshot was taken
+		int64_t file_mtime;
+		uint64_t file_hash;
+		uint32_t node_count;
+		uint32_t prop_count;
+		uint32_t source_count;
+		uint32_t library_count;
+		uint32_t string_count;
+		int32_t load_status;	// OracleForms status of loading module (see FAPIModule::getLoadStatus)
+		uint64_t nodes_offset;
+		uint64_t props_offset;
+		uint64_t sources_offset;
+		uint64_t libraries_offset;
+		uint64_t strings_offset;
+		uint64_t string_data_offset;
+	};
+
+	struct SnapshotNode {
+		int32_t type_id;
+		int32_t level;
+		uint32_t parent;		// node index, SNAPSHOT_NONE for root
+		uint32_t name;			// string id
+		uint32_t first_child;	// node index
+		uint32_t child_count;
+		uint32_t first_prop;	// property index
+		uint32_t prop_count;
+		uint32_t flags;
+		uint32_t reserved;
+	};
+
+	struct SnapshotProperty {
+		int32_t prop_id;
+		int32_t prop_type;
+		uint32_t value;			// string id
+		int32_t state;			// PropState
+	};
+
+	struct SnapshotString {
+		uint32_t offset;
+		uint32_t length;
+	};
+
+	static_assert(sizeof(SnapshotHeader) == 112, "Unexpected SnapshotHeader layout");
+	static_assert(sizeof(SnapshotNode) == 40, "Unexpected SnapshotNode layout");
+	static_assert(sizeof(SnapshotProperty) == 16, "Unexpected SnapshotProperty layout");
+	static_assert(sizeof(SnapshotString) == 8, "Unexpected SnapshotString layout");
+
+	class ModuleSnapshot
+	{
+	public:
+		/** Gets path of snapshot file for a given module
+		*
+		* \param _directory Directory with snapshots
+		* \param _filepath Path to .fmb/.pll file
+		* \return Path to snapshot file
+		*/
+		CPPFAPIWRAPPER static std::string snapshotPath(const std::string & _directory, const std::string & _filepath);
+
+		/** Writes traversed object tree of a module to a snapshot file. Snapshot is written to a temporary file first
+		* and then replaces the old one, which fails on Windows while old snapshot is mapped by a ModuleImage.
+		* Throws an exception if snapshot can't be written or replaced, old snapshot is kept then.
+		*
+		* \param _module Traversed module
+		* \param _snapshot_path Path to snapshot file
+		*/
+		CPPFAPIWRAPPER static void save(const FAPIModule & _module, const std::string & _snapshot_path);
+
+		/** Restores object tree of a module from a snapshot file, if snapshot exists and module file didn't change
+		* since snapshot was taken. OracleForms objects are not loaded (see FAPIModule::attachNative).
+		*
+		* \param _module Module without object tree
+		* \param _snapshot_path Path to snapshot file
+		* \return True if module was restored
+		*/
+		CPPFAPIWRAPPER static bool load(FAPIModule & _module, const std::string & _snapshot_path);
+
+		/** Checks if snapshot header is valid and module file didn't change since snapshot was taken
+		*
+		* \param _header Snapshot header
+		* \param _filepath Path to .fmb/.pll file
+		* \return True if snapshot can be used
+		*/
+		CPPFAPIWRAPPER static bool isValid(const SnapshotHeader & _header, const std::string & _filepath);
+	};
+}
+
+#endif // MODULESNAPSHOT_H
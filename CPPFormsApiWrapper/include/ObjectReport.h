@@ -0,0 +1,73 @@
+#ifndef OBJECTREPORT_H
+#define OBJECTREPORT_H
+
+#include "dllmain.h"
+
+#include <string>
+#include <string_view>
+#include <ostream>
+
+namespace CPPFAPIWrapper {
+	class FAPIModule;
+	class FormsObject;
+	class Property;
+
+	/** Writes object report (like Forms Documentation of ifcmp60) of a loaded module straight from its object tree.
+	* Every object is written as "* TYPE  NAME" line followed by its properties ("- Property name  value", sorted by
+	* property id) and its children (grouped by type), indented by depth. Lines of multi-line values are aligned
+	* under the first one. Output is collected in a buffer and written to stream in large chunks.
+	*/
+	class ObjectReportWriter
+	{
+	public:
+		/** Creates writer
+		*
+		* \param _stream Output stream, must outlive the writer
+		* \param _buffer_size Number of bytes collected before they are written to stream
+		*/
+		CPPFAPIWRAPPER ObjectReportWriter(std::ostream & _stream, const size_t _buffer_size = 1 << 16);
+
+		/** Flushes buffered output */
+		CPPFAPIWRAPPER ~ObjectReportWriter();
+
+		/** Writes report of a module. Module is only read, so reports of different modules can be written concurrently.
+		*
+		* \param _module Module with traversed objects
+		*/
+		CPPFAPIWRAPPER void writeModule(const FAPIModule & _module);
+
+		/** Writes buffered output to stream. Throws an exception if stream fails. */
+		CPPFAPIWRAPPER void flush();
+
+		ObjectReportWriter() = delete;
+		ObjectReportWriter(const ObjectReportWriter & _writer) = delete;
+		ObjectReportWriter & operator=(const ObjectReportWriter & _writer) = delete;
+
+	private:
+		void writeObject(FormsObject * _object, const size_t _depth);
+		void writeProperty(const Property & _property, const size_t _depth);
+		void writeLine(const size_t _depth, const char _marker, std::string_view _label, std::string_view _value);
+		void append(std::string_view _text);
+
+		std::ostream & stream;
+		std::string buffer;
+		size_t buffer_size;
+	};
+
+	/** Gets path of object report of a module: given path with .txt extension, or module path with .txt extension
+	*
+	* \param _module_path Path to module
+	* \param _filepath Requested location of report, may be empty
+	* \return Path to report file
+	*/
+	CPPFAPIWRAPPER std::string objectReportPath(const std::string & _module_path, const std::string & _filepath = "");
+
+	/** Writes object report of a module to a file
+	*
+	* \param _module Module with traversed objects
+	* \param _filepath Path to report file
+	*/
+	CPPFAPIWRAPPER void writeObjectReportFile(const FAPIModule & _module, const std::string & _filepath);
+}
+
+#endif // OBJECTREPORT_H
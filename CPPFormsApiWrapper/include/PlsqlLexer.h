@@ -0,0 +1,103 @@
+#ifndef PLSQLLEXER_H
+#define PLSQLLEXER_H
+
+#include "dllmain.h"
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <shared_mutex>
+#include <cstdint>
+
+namespace CPPFAPIWrapper {
+
+	enum class PlsqlTokenKind : uint8_t {
+		IDENTIFIER,		// name or "quoted name"
+		KEYWORD,		// reserved word
+		BIND,			// :BLOCK.ITEM, :GLOBAL.NAME, :PARAMETER.NAME
+		NUMBER,
+		STRING,			// literal with quotes
+		SYMBOL			// operator or punctuation, multi-character operators (:=, =>, .., ||) are single tokens
+	};
+
+	CPPFAPIWRAPPER constexpr uint32_t NO_IDENTIFIER = UINT32_MAX;
+
+	struct PlsqlToken {
+		uint32_t offset;		// offset in code
+		uint32_t length;		// length in code
+		uint32_t id;			// interned uppercase text of identifiers, keywords, symbols and bind names (without ':'), NO_IDENTIFIER for numbers and strings
+		PlsqlTokenKind kind;
+	};
+
+	/** Interns identifiers, so tokens of all units compare names by id. Thread-safe. */
+	class IdentifierTable
+	{
+	public:
+		CPPFAPIWRAPPER IdentifierTable();
+
+		/** Gets id of a name, adding it if needed
+		*
+		* \param _name Name, compared as given (callers uppercase PLSQL names)
+		* \return Id of name
+		*/
+		CPPFAPIWRAPPER uint32_t intern(const std::string & _name);
+
+		/** Gets id of a name without adding it
+		*
+		* \param _name Name
+		* \return Id of name, NO_IDENTIFIER if name wasn't interned
+		*/
+		CPPFAPIWRAPPER uint32_t find(const std::string & _name) const;
+
+		/** Gets name of an id
+		*
+		* \param _id Id returned by intern
+		* \return Name
+		*/
+		CPPFAPIWRAPPER const std::string & getName(const uint32_t _id) const;
+
+		/** Gets number of interned names
+		*
+		* \return Number of names
+		*/
+		CPPFAPIWRAPPER size_t size() const;
+
+		IdentifierTable(const IdentifierTable & _table) = delete;
+		IdentifierTable & operator=(const IdentifierTable & _table) = delete;
+
+	private:
+		mutable std::shared_mutex table_mutex;
+		std::unordered_map<std::string, uint32_t> ids;
+		std::deque<std::string> names;	// deque keeps references returned by getName valid
+	};
+
+	/** Gets identifier table shared by all token streams cached on FormsObjects. Names are never removed, so ids stay
+	* valid for lifetime of the process and table grows with number of distinct names in all code tokenized so far.
+	* Structures indexed by id should be sized by ids they actually hold, not by size of the table.
+	*
+	* \return Reference to table
+	*/
+	CPPFAPIWRAPPER IdentifierTable & getIdentifierTable();
+
+	/** Finds end of a comment, string literal or quoted name starting at a position of PLSQL code. Unterminated ones
+	* end with code.
+	*
+	* \param _begin Position in code
+	* \param _end End of code
+	* \return Position after comment, literal or quoted name, _begin if none starts there
+	*/
+	CPPFAPIWRAPPER const char * skipCommentOrLiteral(const char * _begin, const char * _end);
+
+	/** Splits PLSQL code into tokens in a single pass. Comments and whitespace are skipped, unterminated literals and
+	* comments end with code.
+	*
+	* \param _code PLSQL code
+	* \param _table Table identifiers are interned in
+	* \return Tokens in order of occurrence
+	*/
+	CPPFAPIWRAPPER std::vector<PlsqlToken> tokenizePlsql(std::string_view _code, IdentifierTable & _table = getIdentifierTable());
+}
+
+#endif // PLSQLLEXER_H
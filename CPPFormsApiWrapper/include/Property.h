@@ -2,6 +2,7 @@
 #define PROPERTY_H
 
 #include <string>
+#include <vector>
 #include "dllmain.h"
 
 namespace CPPFAPIWrapper {
@@ -16,6 +17,8 @@ namespace CPPFAPIWrapper {
 
 	class Property {
 	public:
+		static constexpr size_t NOT_MARKED = static_cast<size_t>(-1);
+
 		/** Creates Property object. Used by FAPIModule, shouldn't be called directly.
 		*
 		* \param _parent Pointer to parent FormsObject
@@ -24,6 +27,17 @@ namespace CPPFAPIWrapper {
 		*/
 		CPPFAPIWRAPPER Property(FormsObject * _parent, int _prop_id = -1, int _prop_type = -1);
 
+		/** Creates Property object with already known value and state, without reading OracleForms object.
+		* Used when restoring module from snapshot, shouldn't be called directly.
+		*
+		* \param _parent Pointer to parent FormsObject
+		* \param _prop_id OracleForms property id
+		* \param _prop_type OracleForms property type
+		* \param _value Property value
+		* \param _state Property state
+		*/
+		CPPFAPIWRAPPER Property(FormsObject * _parent, int _prop_id, int _prop_type, const std::string & _value, PropState _state);
+
 		/** Inherits value from source object property*/
 		CPPFAPIWRAPPER void inherit();
 
@@ -33,6 +47,34 @@ namespace CPPFAPIWrapper {
 		/** Checks if property has broken inheritance (OVERRIDEN state)*/
 		CPPFAPIWRAPPER void checkState();
 
+		/** Checks if property has broken inheritance against already found source objects.
+		*
+		* \param _sources Source objects of parent, as returned by FormsObject::findSources
+		* \return OVERRIDEN if value differs from source, INHERITED if inheritance was restored, otherwise current state
+		*/
+		CPPFAPIWRAPPER PropState checkState(const std::vector<FormsObject *> & _sources);
+
+		/** Compares property value with source objects without modifying property or OracleForms object.
+		*
+		* \param _sources Source objects of parent, as returned by FormsObject::findSources
+		* \param _source_value Output parameter, value of the nearest source property if found
+		* \return OVERRIDEN if value differs from source, INHERITED if it equals source, otherwise current state (also if no
+		* source defines property, _source_value stays empty then)
+		*/
+		CPPFAPIWRAPPER PropState inspectState(const std::vector<FormsObject *> & _sources, std::string & _source_value) const;
+
+		/** Checks if property is a candidate for broken inheritance check (local value of subclassed object)
+		*
+		* \return True if checkState would compare property with its source
+		*/
+		CPPFAPIWRAPPER bool needsCheck() const;
+
+		/** Applies result of previous checkState call without looking for source objects.
+		*
+		* \param _result Result returned by checkState
+		*/
+		CPPFAPIWRAPPER void restoreState(const PropState _result);
+
 		/** Gets current property value
 		*
 		* \return Property value
@@ -81,6 +123,8 @@ namespace CPPFAPIWrapper {
 		*/
 		CPPFAPIWRAPPER FormsObject * getParent() const;
 	private:
+		friend class FormsObject;
+
 		CPPFAPIWRAPPER void checkValue();
 		CPPFAPIWRAPPER void checkStateOnInit();
 
@@ -93,6 +137,7 @@ namespace CPPFAPIWrapper {
 		int prop_id;		// internal forms api property id
 		int prop_type;	 // internal forms api property type
 		bool dirty;		 // was property value changed
+		size_t mark_index;	// position in parent's marked properties, NOT_MARKED if not marked
 		std::string original_value;
 		std::string value;
 	};
@@ -0,0 +1,74 @@
+#ifndef TASKEXECUTOR_H
+#define TASKEXECUTOR_H
+
+#include "dllmain.h"
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace CPPFAPIWrapper {
+	/** Fixed number of threads executing queued tasks in FIFO order. With single thread, tasks are executed
+	* one after another, which is how FAPIContext serializes OracleForms API calls.
+	*/
+	class TaskExecutor
+	{
+	public:
+		/** Starts threads
+		*
+		* \param _threads Number of threads
+		*/
+		CPPFAPIWRAPPER TaskExecutor(const size_t _threads = 1);
+
+		/** Executes all queued tasks and stops threads */
+		CPPFAPIWRAPPER ~TaskExecutor();
+
+		/** Queues task
+		*
+		* \param _task Function to execute
+		* \return Future with result or exception of task, of any type
+		*/
+		template<class F>
+		auto submit(F && _task) -> std::future<decltype(_task())> {
+			using R = decltype(_task());
+			auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(_task));
+			auto result = task->get_future();
+			post([task]() { (*task)(); });
+
+			return result;
+		}
+
+		/** Queues task without result
+		*
+		* \param _task Function to execute, exceptions are logged and ignored
+		*/
+		CPPFAPIWRAPPER void post(std::function<void()> _task);
+
+		/** Checks if current thread belongs to executor
+		*
+		* \return True if called from a task
+		*/
+		CPPFAPIWRAPPER bool isExecutorThread() const;
+
+		TaskExecutor(TaskExecutor && _executor) = delete;
+		TaskExecutor & operator=(TaskExecutor && _executor) = delete;
+		TaskExecutor(const TaskExecutor & _executor) = delete;
+		TaskExecutor & operator=(const TaskExecutor & _executor) = delete;
+
+	private:
+		void run();
+
+		std::vector<std::thread> threads;
+		std::deque<std::function<void()>> tasks;
+		std::mutex tasks_mutex;
+		std::condition_variable queued;
+		bool stopping;
+	};
+}
+
+#endif // TASKEXECUTOR_H
@@ -0,0 +1,151 @@
+#ifndef WORKERFARM_H
+#define WORKERFARM_H
+
+#include "dllmain.h"
+#include "FarmProtocol.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <chrono>
+
+namespace CPPFAPIWrapper {
+	class FAPIContext;
+
+	/** Running worker of a WorkerFarm */
+	class FarmWorker
+	{
+	public:
+		CPPFAPIWRAPPER virtual ~FarmWorker();
+
+		/** Gets pipe connected to worker
+		*
+		* \return Pipe, reading gives worker's messages, writing sends messages to worker
+		*/
+		CPPFAPIWRAPPER virtual FarmPipe & getPipe() = 0;
+
+		/** Stops worker forcibly without closing its pipe, so thread still reading the pipe gets end of stream.
+		* terminate must be called once nothing uses the pipe.
+		*/
+		CPPFAPIWRAPPER virtual void kill() = 0;
+
+		/** Stops worker (forcibly if it is still running), waits until it is finished and closes its pipe */
+		CPPFAPIWRAPPER virtual void terminate() = 0;
+	};
+
+	/** Starts workers for a WorkerFarm */
+	class WorkerLauncher
+	{
+	public:
+		CPPFAPIWRAPPER virtual ~WorkerLauncher();
+
+		/** Starts new worker. Throws an exception if worker can't be started.
+		*
+		* \return Running worker
+		*/
+		CPPFAPIWRAPPER virtual std::unique_ptr<FarmWorker> launch() = 0;
+	};
+
+	/** Starts workers as separate processes, talking to the farm through standard input and output (see
+	* runFarmWorkerProcess).
+	*/
+	class ProcessWorkerLauncher : public WorkerLauncher
+	{
+	public:
+		/** Creates launcher
+		*
+		* \param _command Worker executable followed by its arguments
+		*/
+		CPPFAPIWRAPPER ProcessWorkerLauncher(const std::vector<std::string> & _command);
+
+		CPPFAPIWRAPPER std::unique_ptr<FarmWorker> launch() override;
+
+	private:
+		std::vector<std::string> command;
+	};
+
+	/** Starts workers as threads of current process, running given handler without OracleForms context. Meant for
+	* testing the farm and the protocol locally with a stub backend.
+	*/
+	class ThreadWorkerLauncher : public WorkerLauncher
+	{
+	public:
+		/** Creates launcher
+		*
+		* \param _handler Function processing module path, its result is sent back to the farm
+		* \param _crashes Function checking if worker should crash on a module: it closes its pipe and stops without
+		* an answer, as if worker process died. No worker crashes if null.
+		*/
+		CPPFAPIWRAPPER ThreadWorkerLauncher(std::function<std::string(const std::string &)> _handler, std::function<bool(const std::string &)> _crashes = nullptr);
+
+		CPPFAPIWRAPPER std::unique_ptr<FarmWorker> launch() override;
+
+	private:
+		std::function<std::string(const std::string &)> handler;
+		std::function<bool(const std::string &)> crashes;
+	};
+
+	struct FarmResult {
+		std::string path;		// module path
+		bool success;			// false if handler threw an exception or worker crashed too many times
+		std::string payload;	// handler result, or error message
+		size_t attempts;		// number of workers which got the module
+	};
+
+	/** Processes modules with a pool of workers, each owning its own OracleForms context. Modules are split into
+	* contiguous per-worker queues (so related modules given next to each other usually land on the same worker);
+	* idle worker steals from the end of the longest queue of other workers. When worker crashes, its module is
+	* retried on another worker and crashed worker is restarted.
+	*/
+	class WorkerFarm
+	{
+	public:
+		/** Creates farm, workers are started by run
+		*
+		* \param _launcher Starts workers, must outlive the farm
+		* \param _workers Number of workers
+		* \param _max_attempts Number of crashes after which module is reported as failed
+		* \param _shutdown_timeout Time given to workers to stop after shutdown message, then they are killed
+		*/
+		CPPFAPIWRAPPER WorkerFarm(WorkerLauncher & _launcher, const size_t _workers, const size_t _max_attempts = 3, const std::chrono::milliseconds _shutdown_timeout = std::chrono::seconds(10));
+
+		/** Processes modules and stops workers
+		*
+		* \param _filepaths Paths to modules
+		* \param _on_result Function called (on calling thread) as soon as result of a module arrives
+		* \return Results in order of _filepaths
+		*/
+		CPPFAPIWRAPPER std::vector<FarmResult> run(const std::vector<std::string> & _filepaths, std::function<void(const FarmResult &)> _on_result = nullptr);
+
+		WorkerFarm() = delete;
+		WorkerFarm(const WorkerFarm & _farm) = delete;
+		WorkerFarm & operator=(const WorkerFarm & _farm) = delete;
+
+	private:
+		WorkerLauncher & launcher;
+		size_t workers;
+		size_t max_attempts;
+		std::chrono::milliseconds shutdown_timeout;
+	};
+
+	/** Serves farm messages from a pipe until farm shuts worker down or closes the pipe
+	*
+	* \param _pipe Pipe connected to the farm
+	* \param _handler Function processing module path, exceptions are reported to the farm as failures
+	* \return Exit code for worker process
+	*/
+	CPPFAPIWRAPPER int runFarmWorker(FarmPipe & _pipe, std::function<std::string(const std::string &)> _handler);
+
+	/** Main loop of a worker process started by ProcessWorkerLauncher. Creates OracleForms context and serves
+	* modules from standard input; context is reset after each module.
+	*
+	* \param _handler Function processing module, its result is sent back to the farm
+	* \param _connstring Database connection string, context is not connected if empty
+	* \return Exit code for worker process
+	*/
+	CPPFAPIWRAPPER int runFarmWorkerProcess(std::function<std::string(FAPIContext &, const std::string &)> _handler, const std::string & _connstring = "");
+}
+
+#endif // WORKERFARM_H
@@ -0,0 +1,161 @@
+#include "BuiltinsCatalogue.h"
+
+#include "FAPIUtil.h"
+
+#include "Exceptions.h"
+#include "FAPILogger.h"
+
+#include <fstream>
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+
+namespace CPPFAPIWrapper {
+	using namespace std;
+
+	const string BUILTINS_CATALOGUE_HEADER = "CPPFAPIBUILTINS\t2";
+	const string BUILTINS_CATALOGUE_TRAILER = "END";
+
+	// compares upper case catalogue name with identifier of any case
+	int compareBuiltinName(const string_view _upper, const string_view _name) {
+		size_t len = min(_upper.size(), _name.size());
+
+		for (size_t i = 0; i < len; ++i) {
+			int c = toupper(static_cast<unsigned char>(_name[i]));
+
+			if (static_cast<unsigned char>(_upper[i]) != c)
+				return static_cast<unsigned char>(_upper[i]) < c ? -1 : 1;
+		}
+
+		return _upper.size() == _name.size() ? 0 : (_upper.size() < _name.size() ? -1 : 1);
+	}
+
+	BuiltinsCatalogue::BuiltinsCatalogue()
+		: version(0) { TRACE_FNC("") }
+
+	void BuiltinsCatalogue::build(const uint32_t _version, const unordered_map<string, vector<string>> & _packages) { TRACE_FNC(to_string(_version))
+		version = _version;
+		packages = _packages;
+		names.clear();
+
+		for (const auto & package : packages) {
+			string package_name = toUpper(package.first);
+
+			for (const auto & unit : package.second) {
+				string unit_name = toUpper(unit);
+				names.emplace_back(unit_name);
+				names.emplace_back(package_name + "." + unit_name);
+			}
+		}
+
+		sort(names.begin(), names.end());
+		names.erase(unique(names.begin(), names.end()), names.end());
+	}
+
+	bool BuiltinsCatalogue::load(const string & _filepath, const uint32_t _version) { TRACE_FNC(_filepath + " | " + to_string(_version))
+		ifstream file{ _filepath };
+
+		if (!file.is_open())
+			return false;
+
+		string line;
+		getline(file, line);
+
+		if (line != BUILTINS_CATALOGUE_HEADER + "\t" + to_string(_version)) {
+			FAPILogger::debug("Builtins catalogue made by other version: " + _filepath);
+			return false;
+		}
+
+		unordered_map<string, vector<string>> loaded;
+		uint64_t hash = hashBytes("", 0);
+		bool complete{ false };
+
+		while (getline(file, line)) {
+			// trailer keeps number of packages and hash of package lines, so truncated file isn't accepted
+			if (line.compare(0, BUILTINS_CATALOGUE_TRAILER.size() + 1, BUILTINS_CATALOGUE_TRAILER + "\t") == 0) {
+				complete = line == BUILTINS_CATALOGUE_TRAILER + "\t" + to_string(loaded.size()) + "\t" + to_string(hash);
+				break;
+			}
+
+			hash = hashBytes(line.data(), line.size(), hash);
+			hash = hashBytes("\n", 1, hash);
+
+			if (line.empty())
+				continue;
+
+			size_t pos = line.find('\t');
+			auto & units = loaded[line.substr(0, pos)];
+
+			while (pos != string::npos) {
+				size_t next = line.find('\t', pos + 1);
+				units.emplace_back(line.substr(pos + 1, next == string::npos ? string::npos : next - pos - 1));
+				pos = next;
+			}
+		}
+
+		if (!complete || loaded.empty()) {
+			FAPILogger::debug("Builtins catalogue is incomplete: " + _filepath);
+			return false;
+		}
+
+		build(_version, loaded);
+
+		return true;
+	}
+
+	void BuiltinsCatalogue::save(const string & _filepath) const { TRACE_FNC(_filepath)
+		// every process writing the same catalogue has its own temporary file
+		string tmp_path = temporaryPath(_filepath);
+		bool written{ false };
+
+		{
+			ofstream file{ tmp_path, ios::trunc };
+
+			if (file.is_open()) {
+				uint64_t hash = hashBytes("", 0);
+				file << BUILTINS_CATALOGUE_HEADER << "\t" << version << "\n";
+
+				for (const auto & package : packages) {
+					string line = package.first;
+
+					for (const auto & unit : package.second)
+						line += "\t" + unit;
+
+					line += "\n";
+					hash = hashBytes(line.data(), line.size(), hash);
+					file << line;
+				}
+
+				file << BUILTINS_CATALOGUE_TRAILER << "\t" << packages.size() << "\t" << hash << "\n";
+				written = static_cast<bool>(file);
+			}
+		}
+
+		if (!written || !replaceFile(tmp_path, _filepath)) {
+			remove(tmp_path.c_str());
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Couldn't write builtins catalogue: " + _filepath };
+		}
+	}
+
+	bool BuiltinsCatalogue::contains(const string_view _name) const {
+		auto it = lower_bound(names.begin(), names.end(), _name, [](const string & _entry, const string_view _value) { return compareBuiltinName(_entry, _value) < 0; });
+		return it != names.end() && compareBuiltinName(*it, _name) == 0;
+	}
+
+	bool BuiltinsCatalogue::isEmpty() const { TRACE_FNC("")
+		return names.empty();
+	}
+
+	uint32_t BuiltinsCatalogue::getVersion() const { TRACE_FNC("")
+		return version;
+	}
+
+	const unordered_map<string, vector<string>> & BuiltinsCatalogue::getPackages() const { TRACE_FNC("")
+		return packages;
+	}
+
+	string BuiltinsCatalogue::cataloguePath(const string & _directory, const uint32_t _version) { TRACE_FNC(_directory + " | " + to_string(_version))
+		string separator = _directory.empty() || _directory.back() == '/' || _directory.back() == '\\' ? "" : "/";
+		return _directory + separator + "builtins_" + to_string(_version) + ".cat";
+	}
+}
@@ -0,0 +1,210 @@
+#include "BuiltinsMatcher.h"
+
+#include "BuiltinsCatalogue.h"
+#include "FAPIModule.h"
+#include "FormsObject.h"
+#include "Property.h"
+#include "FAPIUtil.h"
+#include "PlsqlLexer.h"
+#include "FAPIWrapper.h"
+
+#include "Exceptions.h"
+#include "FAPILogger.h"
+
+#include <algorithm>
+#include <cctype>
+#include <deque>
+
+namespace CPPFAPIWrapper {
+	using namespace std;
+
+	const uint32_t NO_MATCH = UINT32_MAX;
+
+	bool isBuiltinNameChar(const char _char) {
+		unsigned char c = static_cast<unsigned char>(_char);
+		return isalnum(c) || c == '_' || c == '$' || c == '#';
+	}
+
+	BuiltinsMatcher::BuiltinsMatcher(const BuiltinsCatalogue & _catalogue)
+		: symbols{}, alphabet(1) { TRACE_FNC("")
+
+		for (const auto & package : _catalogue.getPackages()) {
+			string package_name = toUpper(package.first);
+
+			for (const auto & unit : package.second) {
+				string unit_name = toUpper(unit);
+				names.emplace_back(unit_name);
+				names.emplace_back(package_name + "." + unit_name);
+			}
+		}
+
+		sort(names.begin(), names.end());
+		names.erase(unique(names.begin(), names.end()), names.end());
+
+		for (const auto & name : names)
+			for (auto c : name) {
+				unsigned char upper = static_cast<unsigned char>(c);
+
+				if (symbols[upper])
+					continue;
+
+				symbols[upper] = static_cast<uint8_t>(alphabet);
+				symbols[static_cast<unsigned char>(tolower(upper))] = static_cast<uint8_t>(alphabet);
+				++alphabet;
+			}
+
+		transitions.assign(alphabet, 0);
+		outputs.assign(1, NO_MATCH);
+		suffixes.assign(1, 0);
+
+		for (const auto & name : names)
+			addName(name);
+
+		link();
+		FAPILogger::debug("Built-ins matcher: " + to_string(names.size()) + " names, " + to_string(outputs.size()) + " states");
+	}
+
+	void BuiltinsMatcher::addName(const string & _name) {
+		uint32_t state{ 0 };
+
+		for (auto c : _name) {
+			uint32_t & next = transitions[state * alphabet + symbols[static_cast<unsigned char>(c)]];
+
+			if (!next) {
+				next = static_cast<uint32_t>(outputs.size());
+				transitions.resize(transitions.size() + alphabet, 0);
+				outputs.emplace_back(NO_MATCH);
+				suffixes.emplace_back(0);
+			}
+
+			// reference can't be reused, resize may have moved transitions
+			state = transitions[state * alphabet + symbols[static_cast<unsigned char>(c)]];
+		}
+
+		outputs[state] = static_cast<uint32_t>(&_name - names.data());
+	}
+
+	void BuiltinsMatcher::link() {
+		// breadth-first, so failure state of every state is resolved before its children
+		vector<uint32_t> failures(outputs.size(), 0);
+		deque<uint32_t> pending;
+
+		for (size_t symbol = 1; symbol < alphabet; ++symbol)
+			if (transitions[symbol])
+				pending.emplace_back(transitions[symbol]);
+
+		while (!pending.empty()) {
+			uint32_t state = pending.front();
+			pending.pop_front();
+
+			for (size_t symbol = 1; symbol < alphabet; ++symbol) {
+				uint32_t & next = transitions[state * alphabet + symbol];
+				uint32_t failure_next = transitions[failures[state] * alphabet + symbol];
+
+				if (!next) {
+					next = failure_next;
+					continue;
+				}
+
+				failures[next] = failure_next;
+				suffixes[next] = outputs[failure_next] != NO_MATCH ? failure_next : suffixes[failure_next];
+				pending.emplace_back(next);
+			}
+		}
+	}
+
+	void BuiltinsMatcher::match(string_view _code, vector<uint32_t> & _matches) const {
+		const char * code = _code.data();
+		const char * p = code;
+		const char * end = p + _code.size();
+		uint32_t state{ 0 };
+
+		while (p < end) {
+			uint8_t symbol = symbols[static_cast<unsigned char>(*p)];
+
+			if (!symbol) {
+				state = 0;
+				const char * skipped = skipCommentOrLiteral(p, end);
+				p = skipped != p ? skipped : p + 1;
+
+				continue;
+			}
+
+			state = transitions[state * alphabet + symbol];
+			++p;
+
+			uint32_t found = outputs[state] != NO_MATCH ? state : suffixes[state];
+
+			// name has to end with identifier
+			if (!found || (p < end && isBuiltinNameChar(*p)))
+				continue;
+
+			// longest name which starts an identifier, not qualified by anything else (:BLOCK.ITEM, RECORD.FIELD)
+			for (; found; found = suffixes[found]) {
+				const char * start = p - names[outputs[found]].size();
+
+				if (start == code || (!isBuiltinNameChar(start[-1]) && start[-1] != '.' && start[-1] != ':')) {
+					_matches.emplace_back(outputs[found]);
+					break;
+				}
+			}
+		}
+	}
+
+	map<string, size_t> BuiltinsMatcher::countBuiltins(string_view _code) const { TRACE_FNC(to_string(_code.size()))
+		vector<uint32_t> matches;
+		map<string, size_t> counts;
+		match(_code, matches);
+
+		for (auto id : matches)
+			++counts[names[id]];
+
+		return counts;
+	}
+
+	BuiltinsReport BuiltinsMatcher::analyseModule(const FAPIModule & _module) const { TRACE_FNC(_module.getFilepath())
+		BuiltinsReport report{ _module.getFilepath(), {}, {} };
+		vector<uint32_t> matches;
+
+		for (const auto & fo : _module.getAllObjects()) {
+			int type_id = fo->getId();
+
+			if (type_id != D2FFO_TRIGGER && type_id != D2FFO_PROG_UNIT && type_id != D2FFO_LIB_PROG_UNIT)
+				continue;
+
+			auto & properties = fo->getProperties();
+			auto code = properties.find(type_id == D2FFO_TRIGGER ? D2FP_TRG_TXT : D2FP_PGU_TXT);
+
+			if (code == properties.end())
+				continue;
+
+			matches.clear();
+			match(code->second->getValue(), matches);
+
+			if (matches.empty())
+				continue;
+
+			BuiltinsUnitUsage usage{ type_id, fo->getFullName(), {} };
+
+			for (auto id : matches) {
+				++usage.builtins[names[id]];
+				++report.totals[names[id]];
+			}
+
+			report.units.emplace_back(move(usage));
+		}
+
+		return report;
+	}
+
+	const string & BuiltinsMatcher::getName(const uint32_t _id) const { TRACE_FNC(to_string(_id))
+		if (_id >= names.size())
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Unknown built-in " + to_string(_id) };
+
+		return names[_id];
+	}
+
+	size_t BuiltinsMatcher::size() const { TRACE_FNC("")
+		return names.size();
+	}
+}
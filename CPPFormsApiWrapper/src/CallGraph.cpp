@@ -0,0 +1,445 @@
+#include "CallGraph.h"
+
+#include "FAPIContext.h"
+#include "FAPIForm.h"
+#include "FAPILibrary.h"
+#include "FormsObject.h"
+#include "PlsqlLexer.h"
+#include "FAPIWrapper.h"
+
+#include "Exceptions.h"
+#include "FAPILogger.h"
+
+#include <algorithm>
+#include <deque>
+#include <unordered_set>
+
+namespace CPPFAPIWrapper {
+	using namespace std;
+
+	// subprogram of a package body, its references are made by PKG.PROC instead of whole package
+	struct PackageSubprogram {
+		size_t begin;			// range of tokens, from PROCEDURE/FUNCTION to ';' ending declaration or body
+		size_t end;
+		uint32_t local_name;	// PROC
+		uint32_t name;			// PKG.PROC
+	};
+
+	// subprograms declared on package level of a package body, empty for other units
+	static vector<PackageSubprogram> findSubprograms(const vector<PlsqlToken> & _tokens, IdentifierTable & _table) {
+		vector<PackageSubprogram> subprograms;
+		auto keyword = [&_tokens](const size_t _i, const uint32_t _id) { return _i < _tokens.size() && _tokens[_i].kind == PlsqlTokenKind::KEYWORD && _tokens[_i].id == _id; };
+
+		if (!keyword(0, _table.intern("PACKAGE")) || !keyword(1, _table.intern("BODY")) || _tokens.size() < 3 || _tokens[2].kind != PlsqlTokenKind::IDENTIFIER)
+			return subprograms;
+
+		const string package = _table.getName(_tokens[2].id) + ".";
+		uint32_t procedure = _table.intern("PROCEDURE"), function = _table.intern("FUNCTION"), is = _table.intern("IS"), as = _table.intern("AS");
+		uint32_t declare = _table.intern("DECLARE"), begin = _table.intern("BEGIN"), end = _table.intern("END"), case_id = _table.intern("CASE");
+		uint32_t if_id = _table.intern("IF"), loop = _table.intern("LOOP");
+		uint32_t semicolon = _table.intern(";"), open_paren = _table.intern("("), close_paren = _table.intern(")");
+		// open blocks, true while declarations of subprogram or DECLARE wait for their BEGIN
+		vector<bool> blocks;
+		bool header{ false };	// between PROCEDURE/FUNCTION and IS/AS or ';' of forward declaration
+		bool closed{ false };	// END of package level subprogram was found, it ends with next ';'
+		bool open{ false };
+		int parens{ 0 };
+
+		for (size_t i = 3; i < _tokens.size(); ++i) {
+			const auto & token = _tokens[i];
+
+			if (token.kind == PlsqlTokenKind::SYMBOL) {
+				if (token.id == open_paren)
+					++parens;
+				else if (token.id == close_paren)
+					--parens;
+				else if (token.id == semicolon && parens == 0) {
+					if (open && (closed || (header && blocks.empty()))) {
+						subprograms.back().end = i + 1;
+						open = closed = false;
+					}
+
+					header = false;
+				}
+
+				continue;
+			}
+
+			if (token.kind != PlsqlTokenKind::KEYWORD)
+				continue;
+
+			if (token.id == procedure || token.id == function) {
+				if (blocks.empty() && !open && i + 1 < _tokens.size() && _tokens[i + 1].kind == PlsqlTokenKind::IDENTIFIER) {
+					uint32_t local_name = _tokens[i + 1].id;
+					subprograms.emplace_back(PackageSubprogram{ i, _tokens.size(), local_name, _table.intern(package + _table.getName(local_name)) });
+					open = true;
+				}
+
+				header = true;
+				parens = 0;
+			}
+			else if ((token.id == is || token.id == as) && header && parens == 0) {
+				header = false;
+				blocks.emplace_back(true);
+			}
+			else if (token.id == declare)
+				blocks.emplace_back(true);
+			else if (token.id == begin) {
+				if (!blocks.empty() && blocks.back())
+					blocks.back() = false;
+				else
+					blocks.emplace_back(false);
+			}
+			else if (token.id == case_id)
+				blocks.emplace_back(false);
+			else if (token.id == end) {
+				// END IF and END LOOP close statements, not blocks
+				if (keyword(i + 1, if_id) || keyword(i + 1, loop)) {
+					++i;
+					continue;
+				}
+
+				if (keyword(i + 1, case_id))
+					++i;
+
+				if (!blocks.empty())
+					blocks.pop_back();
+
+				closed = open && blocks.empty();
+			}
+		}
+
+		return subprograms;
+	}
+
+	CallGraph::CallGraph()
+		: removed_units(0) { TRACE_FNC("") }
+
+	size_t CallGraph::update(FAPIContext & _ctx) { TRACE_FNC("")
+		size_t added{ 0 };
+
+		for (const auto & module : _ctx.getModules()) {
+			if (!module.second->isTraversed() || !isOutdated(module.second->getFilepath()))
+				continue;
+
+			addModule(*module.second);
+			++added;
+		}
+
+		for (const auto & library : _ctx.getLibraries()) {
+			if (!isOutdated(library.second->getFilepath()))
+				continue;
+
+			addModule(*library.second);
+			++added;
+		}
+
+		compact();
+
+		return added;
+	}
+
+	size_t CallGraph::update(FAPIContext & _ctx, const vector<string> & _filepaths, const bool _ignore_missing_libs, const bool _ignore_missing_sub) { TRACE_FNC(to_string(_filepaths.size()))
+		size_t added{ 0 };
+
+		for (const auto & filepath : _filepaths) {
+			if (!isOutdated(filepath))
+				continue;
+
+			_ctx.visitModule(filepath, [this](const FAPIModule & _module) { addModule(_module); }, _ignore_missing_libs, _ignore_missing_sub);
+
+			++added;
+		}
+
+		compact();
+
+		FAPILogger::debug("Call graph: " + to_string(added) + " of " + to_string(_filepaths.size()) + " modules added");
+		return added;
+	}
+
+	void CallGraph::updateModule(const FAPIModule & _module) { TRACE_FNC(_module.getFilepath())
+		addModule(_module);
+		compact();
+	}
+
+	void CallGraph::removeModule(const string & _filepath) { TRACE_FNC(_filepath)
+		if (!hasModule(_filepath))
+			return;
+
+		eraseModule(_filepath);
+		compact();
+	}
+
+	bool CallGraph::hasModule(const string & _filepath) const { TRACE_FNC(_filepath)
+		return modules.count(_filepath) > 0;
+	}
+
+	bool CallGraph::isOutdated(const string & _filepath) { TRACE_FNC(_filepath)
+		auto module = modules.find(_filepath);
+
+		if (module == modules.end())
+			return true;
+
+		FileFingerprint & added = module->second.fingerprint;
+
+		if (fileChanged(added, _filepath))
+			return true;
+
+		// touched but unchanged file keeps its units, new modification time saves hashing it next time
+		added.mtime = fileFingerprint(_filepath, false).mtime;
+		return false;
+	}
+
+	vector<CallGraphUnit> CallGraph::getCallers(const string & _name, const bool _transitive) const { TRACE_FNC(_name + " | " + to_string(_transitive))
+		uint32_t name = getIdentifierTable().find(toUpper(_name));
+
+		if (name == NO_IDENTIFIER)
+			return {};
+
+		vector<bool> found(units.size(), false);
+		vector<uint32_t> calling;
+		unordered_set<uint32_t> visited{ name };
+		deque<uint32_t> pending{ name };
+
+		while (!pending.empty()) {
+			auto called = callers.find(pending.front());
+			pending.pop_front();
+
+			if (called == callers.end())
+				continue;
+
+			for (const auto & caller : called->second) {
+				if (units[caller.unit].removed)
+					continue;
+
+				if (!found[caller.unit]) {
+					found[caller.unit] = true;
+					calling.emplace_back(caller.unit);
+				}
+
+				// every subprogram of a package continues the search on its own
+				if (_transitive && caller.name != NO_IDENTIFIER && visited.insert(caller.name).second)
+					pending.emplace_back(caller.name);
+			}
+		}
+
+		return toUnits(move(calling));
+	}
+
+	vector<string> CallGraph::getCallees(const string & _filepath, const string & _object) const { TRACE_FNC(_filepath + " | " + _object)
+		auto module = modules.find(_filepath);
+
+		if (module == modules.end())
+			throw FAPIException{ Reason::OBJECT_NOT_FOUND, __FILE__, __LINE__, _filepath };
+
+		auto unit = find_if(module->second.units.begin(), module->second.units.end(), [&](const uint32_t _id) { return units[_id].object == _object; });
+
+		if (unit == module->second.units.end())
+			throw FAPIException{ Reason::OBJECT_NOT_FOUND, __FILE__, __LINE__, _filepath + " | " + _object };
+
+		auto & table = getIdentifierTable();
+		vector<string> callees;
+		vector<string> packages;
+
+		for (uint32_t i = units[*unit].refs_begin; i < units[*unit].refs_end; ++i) {
+			const string & callee = table.getName(refs[i]);
+			auto dot = callee.find('.');
+
+			if (dot == string::npos) {
+				if (definitions.count(refs[i]))
+					callees.emplace_back(callee);
+			}
+			else if (definitions.count(table.find(callee.substr(0, dot)))) {
+				callees.emplace_back(callee);
+				packages.emplace_back(callee.substr(0, dot));
+			}
+		}
+
+		// package used only through its subprograms is listed by them
+		callees.erase(remove_if(callees.begin(), callees.end(), [&packages](const string & _callee) { return find(packages.begin(), packages.end(), _callee) != packages.end(); }), callees.end());
+		sort(callees.begin(), callees.end());
+
+		return callees;
+	}
+
+	vector<CallGraphUnit> CallGraph::getDefinitions(const string & _name) const { TRACE_FNC(_name)
+		auto defined = definitions.find(getIdentifierTable().find(toUpper(_name)));
+
+		if (defined == definitions.end())
+			return {};
+
+		return toUnits(defined->second);
+	}
+
+	size_t CallGraph::getModuleCount() const { TRACE_FNC("")
+		return modules.size();
+	}
+
+	size_t CallGraph::getUnitCount() const { TRACE_FNC("")
+		return units.size() - removed_units;
+	}
+
+	void CallGraph::addModule(const FAPIModule & _module) { TRACE_FNC(_module.getFilepath())
+		const string & filepath = _module.getFilepath();
+		eraseModule(filepath);
+
+		auto & table = getIdentifierTable();
+		uint32_t dot = table.intern(".");
+		GraphModule module{ fileFingerprint(filepath), {} };
+		vector<uint32_t> unit_refs;
+		vector<pair<uint32_t, uint32_t>> unit_callers;	// referenced name, name of calling unit or subprogram
+		unordered_map<uint64_t, uint32_t> qualified;	// (head, name) pair, interned HEAD.NAME
+
+		for (const auto & fo : _module.getAllObjects()) {
+			int type_id = fo->getId();
+
+			if (type_id != D2FFO_TRIGGER && type_id != D2FFO_PROG_UNIT && type_id != D2FFO_LIB_PROG_UNIT)
+				continue;
+
+			const auto & tokens = fo->getTokens();
+			uint32_t name = type_id != D2FFO_TRIGGER ? table.intern(toUpper(fo->getName())) : NO_IDENTIFIER;
+			auto isDot = [&tokens, dot](const size_t _i) { return tokens[_i].kind == PlsqlTokenKind::SYMBOL && tokens[_i].id == dot; };
+			auto subprograms = findSubprograms(tokens, table);
+			unordered_map<uint32_t, uint32_t> local_names;	// subprogram of package called without package name
+			auto subprogram = subprograms.begin();
+			unit_callers.clear();
+
+			for (const auto & sub : subprograms)
+				local_names.emplace(sub.local_name, sub.name);
+
+			for (size_t i = 0; i < tokens.size(); ++i) {
+				// only first name of a chain is a reference, REC.FIELD or PKG.PROC are handled by their head
+				if (tokens[i].kind != PlsqlTokenKind::IDENTIFIER || (i > 0 && isDot(i - 1)))
+					continue;
+
+				while (subprogram != subprograms.end() && subprogram->end <= i)
+					++subprogram;
+
+				uint32_t caller = subprogram != subprograms.end() && subprogram->begin <= i ? subprogram->name : name;
+				bool chain = i + 2 < tokens.size() && isDot(i + 1) && tokens[i + 2].kind == PlsqlTokenKind::IDENTIFIER;
+				auto local = chain ? local_names.end() : local_names.find(tokens[i].id);
+
+				unit_callers.emplace_back(local != local_names.end() ? local->second : tokens[i].id, caller);
+
+				if (chain) {
+					auto pair = qualified.emplace((static_cast<uint64_t>(tokens[i].id) << 32) | tokens[i + 2].id, 0);
+
+					if (pair.second)
+						pair.first->second = table.intern(table.getName(tokens[i].id) + "." + table.getName(tokens[i + 2].id));
+
+					unit_callers.emplace_back(pair.first->second, caller);
+				}
+			}
+
+			// program unit or subprogram repeats its own name in declaration and END
+			unit_callers.erase(remove_if(unit_callers.begin(), unit_callers.end(), [name](const pair<uint32_t, uint32_t> & _ref) { return _ref.first == _ref.second || _ref.first == name; }), unit_callers.end());
+			sort(unit_callers.begin(), unit_callers.end());
+			unit_callers.erase(unique(unit_callers.begin(), unit_callers.end()), unit_callers.end());
+
+			uint32_t id = static_cast<uint32_t>(units.size());
+			unit_refs.clear();
+
+			// ids of added units only grow, so caller lists stay in order of unit ids
+			for (const auto & ref : unit_callers) {
+				if (unit_refs.empty() || unit_refs.back() != ref.first)
+					unit_refs.emplace_back(ref.first);
+
+				callers[ref.first].emplace_back(GraphCaller{ id, ref.second });
+			}
+
+			units.emplace_back(GraphUnit{ filepath, type_id, fo->getFullName(), name, static_cast<uint32_t>(refs.size()), static_cast<uint32_t>(refs.size() + unit_refs.size()), false });
+			refs.insert(refs.end(), unit_refs.begin(), unit_refs.end());
+			module.units.emplace_back(id);
+
+			if (name != NO_IDENTIFIER)
+				definitions[name].emplace_back(id);
+		}
+
+		modules[filepath] = move(module);
+	}
+
+	void CallGraph::eraseModule(const string & _filepath) { TRACE_FNC(_filepath)
+		auto module = modules.find(_filepath);
+
+		if (module == modules.end())
+			return;
+
+		for (auto id : module->second.units) {
+			auto & unit = units[id];
+			unit.removed = true;
+
+			if (unit.name == NO_IDENTIFIER)
+				continue;
+
+			auto & defined = definitions[unit.name];
+			defined.erase(remove(defined.begin(), defined.end(), id), defined.end());
+
+			if (defined.empty())
+				definitions.erase(unit.name);
+		}
+
+		removed_units += module->second.units.size();
+		modules.erase(module);
+	}
+
+	void CallGraph::compact() { TRACE_FNC(to_string(removed_units))
+		if (removed_units <= units.size() / 2)
+			return;
+
+		vector<uint32_t> new_ids(units.size(), NO_IDENTIFIER);
+		vector<GraphUnit> live_units;
+		vector<uint32_t> live_refs;
+		live_units.reserve(units.size() - removed_units);
+
+		for (uint32_t id = 0; id < units.size(); ++id) {
+			auto & unit = units[id];
+
+			if (unit.removed)
+				continue;
+
+			uint32_t begin = static_cast<uint32_t>(live_refs.size());
+			live_refs.insert(live_refs.end(), refs.begin() + unit.refs_begin, refs.begin() + unit.refs_end);
+			unit.refs_begin = begin;
+			unit.refs_end = static_cast<uint32_t>(live_refs.size());
+
+			new_ids[id] = static_cast<uint32_t>(live_units.size());
+			live_units.emplace_back(move(unit));
+		}
+
+		for (auto & module : modules)
+			for (auto & id : module.second.units)
+				id = new_ids[id];
+
+		for (auto & defined : definitions)
+			for (auto & id : defined.second)
+				id = new_ids[id];
+
+		for (auto called = callers.begin(); called != callers.end(); ) {
+			auto & list = called->second;
+			list.erase(remove_if(list.begin(), list.end(), [&new_ids](const GraphCaller & _caller) { return new_ids[_caller.unit] == NO_IDENTIFIER; }), list.end());
+
+			for (auto & caller : list)
+				caller.unit = new_ids[caller.unit];
+
+			called = list.empty() ? callers.erase(called) : next(called);
+		}
+
+		units = move(live_units);
+		refs = move(live_refs);
+		removed_units = 0;
+	}
+
+	vector<CallGraphUnit> CallGraph::toUnits(vector<uint32_t> _ids) const { TRACE_FNC(to_string(_ids.size()))
+		sort(_ids.begin(), _ids.end(), [this](const uint32_t _lhs, const uint32_t _rhs) {
+			return units[_lhs].module != units[_rhs].module ? units[_lhs].module < units[_rhs].module : _lhs < _rhs;
+		});
+
+		vector<CallGraphUnit> result;
+		result.reserve(_ids.size());
+
+		for (auto id : _ids)
+			result.emplace_back(CallGraphUnit{ units[id].module, units[id].type_id, units[id].object });
+
+		return result;
+	}
+}
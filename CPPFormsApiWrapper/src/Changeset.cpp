@@ -0,0 +1,181 @@
+#include "Changeset.h"
+
+#include "FAPIModule.h"
+#include "FormsObject.h"
+#include "Property.h"
+#include "FAPIUtil.h"
+
+#include "Exceptions.h"
+#include "FAPILogger.h"
+
+#include <fstream>
+#include <sstream>
+
+namespace CPPFAPIWrapper {
+	using namespace std;
+
+	const string CHANGESET_HEADER = "CPPFAPICHANGESET\t1";
+
+	Changeset::Changeset()
+		: committed(false) { TRACE_FNC("") }
+
+	void Changeset::set(FormsObject * _object, const int _prop_id, const string & _value) { TRACE_FNC(to_string(_prop_id) + " | " + _value)
+		auto & properties = _object->getProperties();
+		auto property = properties.find(_prop_id);
+
+		if (property == properties.end())
+			throw FAPIException{ Reason::OBJECT_NOT_FOUND, __FILE__, __LINE__, _object->getFullName() + " " + to_string(_prop_id) };
+
+		string fullname = _object->getParent() ? _object->getFullName() : "";
+		changes.emplace_back(PropertyChange{ _object->getModule(), _object, _object->getId(), fullname, _prop_id, property->second->getValue(), _value });
+	}
+
+	void Changeset::append(const Changeset & _changeset) { TRACE_FNC(to_string(_changeset.size()))
+		if (committed || _changeset.committed)
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Can't append committed changeset" };
+
+		changes.insert(changes.end(), _changeset.changes.begin(), _changeset.changes.end());
+	}
+
+	void Changeset::commit(FAPIModule * _module, const bool _check_old) { TRACE_FNC(_module->getFilepath() + " | " + to_string(changes.size()))
+		if (committed)
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Changeset is already committed" };
+
+		vector<Property *> properties;
+		properties.reserve(changes.size());
+
+		// everything is checked before first value is set
+		for (const auto & change : changes) {
+			FormsObject * object = change.module == _module ? change.object : nullptr;
+
+			if (!object && change.fullname.empty())
+				object = _module->getRoot();
+			else if (!object) {
+				auto found = _module->getObject(change.type_id, change.fullname);
+				object = found.isValid() ? found.get() : nullptr;
+			}
+
+			if (!object || object->getId() != change.type_id)
+				throw FAPIException{ Reason::OBJECT_NOT_FOUND, __FILE__, __LINE__, "Changed object not found: " + change.fullname };
+
+			auto property = object->getProperties().find(change.prop_id);
+
+			if (property == object->getProperties().end())
+				throw FAPIException{ Reason::OBJECT_NOT_FOUND, __FILE__, __LINE__, "Changed property not found: " + change.fullname + " " + to_string(change.prop_id) };
+
+			if (_check_old && property->second->getValue() != change.old_value)
+				throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Conflicting value of " + change.fullname + " " + to_string(change.prop_id) + ": " + property->second->getValue() };
+
+			properties.emplace_back(property->second.get());
+		}
+
+		applied.clear();
+		applied.reserve(changes.size());
+
+		// value actually overwritten is kept, it differs from recorded old value when _check_old is false
+		for (size_t i = 0; i < changes.size(); ++i) {
+			applied.emplace_back(properties[i], properties[i]->getValue());
+			properties[i]->setValue(changes[i].new_value);
+		}
+
+		committed = true;
+	}
+
+	void Changeset::rollback() { TRACE_FNC(to_string(changes.size()))
+		if (!committed) {
+			clear();
+			return;
+		}
+
+		// reverse order, so property changed twice ends with value it had before commit
+		for (size_t i = applied.size(); i > 0; --i)
+			applied[i - 1].first->setValue(applied[i - 1].second);
+
+		applied.clear();
+		committed = false;
+	}
+
+	void Changeset::clear() { TRACE_FNC("")
+		changes.clear();
+		applied.clear();
+		committed = false;
+	}
+
+	const vector<PropertyChange> & Changeset::getChanges() const { TRACE_FNC("")
+		return changes;
+	}
+
+	size_t Changeset::size() const { TRACE_FNC("")
+		return changes.size();
+	}
+
+	bool Changeset::isEmpty() const { TRACE_FNC("")
+		return changes.empty();
+	}
+
+	bool Changeset::isCommitted() const { TRACE_FNC("")
+		return committed;
+	}
+
+	string Changeset::serialise() const { TRACE_FNC(to_string(changes.size()))
+		string text = CHANGESET_HEADER + "\n";
+
+		for (const auto & change : changes)
+			text += "C\t" + to_string(change.type_id) + "\t" + escapeField(change.fullname) + "\t" + to_string(change.prop_id) + "\t"
+				+ escapeField(change.old_value) + "\t" + escapeField(change.new_value) + "\n";
+
+		return text;
+	}
+
+	void Changeset::deserialise(const string & _text) { TRACE_FNC(to_string(_text.size()))
+		stringstream stream{ _text };
+		string line;
+		vector<PropertyChange> loaded;
+
+		if (!getline(stream, line) || line != CHANGESET_HEADER)
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Invalid changeset" };
+
+		try {
+			while (getline(stream, line)) {
+				if (line.empty())
+					continue;
+
+				auto fields = splitEscapedFields(line);
+
+				if (fields.size() != 6 || fields[0] != "C")
+					throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Malformed changeset line: " + line };
+
+				loaded.emplace_back(PropertyChange{ nullptr, nullptr, stoi(fields[1]), fields[2], stoi(fields[3]), fields[4], fields[5] });
+			}
+		}
+		catch (logic_error & ex) {
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, string{ "Malformed changeset: " } + ex.what() };
+		}
+
+		clear();
+		changes.swap(loaded);
+	}
+
+	void Changeset::save(const string & _filepath) const { TRACE_FNC(_filepath)
+		ofstream file{ _filepath, ios::binary };
+
+		if (!file.is_open())
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Couldn't create changeset file: " + _filepath };
+
+		file << serialise();
+
+		if (!file)
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Couldn't write changeset file: " + _filepath };
+	}
+
+	void Changeset::load(const string & _filepath) { TRACE_FNC(_filepath)
+		ifstream file{ _filepath, ios::binary };
+
+		if (!file.is_open())
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Couldn't open changeset file: " + _filepath };
+
+		stringstream text;
+		text << file.rdbuf();
+		deserialise(text.str());
+	}
+}
@@ -0,0 +1,308 @@
+#include "CloneDetector.h"
+
+#include "FAPIContext.h"
+#include "FAPIForm.h"
+#include "FAPILibrary.h"
+#include "FormsObject.h"
+#include "Property.h"
+#include "PlsqlLexer.h"
+#include "FAPIWrapper.h"
+
+#include "Exceptions.h"
+#include "FAPILogger.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <functional>
+#include <string_view>
+
+namespace CPPFAPIWrapper {
+	using namespace std;
+
+	const uint64_t CLONE_HASH_BASE = 0x100000001B3ULL;
+
+	// spreads small token values over all bits, so rolling hash of similar windows differs
+	inline uint64_t mixCloneValue(uint64_t _value) {
+		_value ^= _value >> 33;
+		_value *= 0xFF51AFD7ED558CCDULL;
+		_value ^= _value >> 33;
+
+		return _value;
+	}
+
+	CloneDetector::CloneDetector(const size_t _min_tokens, const bool _ignore_names)
+		: min_tokens(max<size_t>(_min_tokens, 1)), ignore_names(_ignore_names) { TRACE_FNC(to_string(_min_tokens) + " | " + to_string(_ignore_names)) }
+
+	void CloneDetector::addModule(const FAPIModule & _module) { TRACE_FNC(_module.getFilepath())
+		string filepath = _module.getFilepath();
+		vector<CloneUnit> units;
+
+		for (const auto & fo : _module.getAllObjects()) {
+			int type_id = fo->getId();
+
+			if (type_id != D2FFO_TRIGGER && type_id != D2FFO_PROG_UNIT && type_id != D2FFO_LIB_PROG_UNIT)
+				continue;
+
+			auto & properties = fo->getProperties();
+			auto text = properties.find(type_id == D2FFO_TRIGGER ? D2FP_TRG_TXT : D2FP_PGU_TXT);
+
+			if (text == properties.end())
+				continue;
+
+			string code = text->second->getValue();
+			const auto & tokens = fo->getTokens();
+			CloneUnit unit{ filepath, type_id, fo->getFullName(), {}, {} };
+			unit.values.reserve(tokens.size());
+			unit.lines.reserve(tokens.size());
+
+			uint32_t line{ 1 };
+			size_t counted{ 0 };
+
+			for (const auto & token : tokens) {
+				line += static_cast<uint32_t>(count(code.begin() + counted, code.begin() + token.offset, '\n'));
+				counted = token.offset;
+
+				uint64_t value;
+
+				switch (token.kind) {
+				case PlsqlTokenKind::IDENTIFIER:
+					value = ignore_names ? 0 : token.id;
+					break;
+				case PlsqlTokenKind::NUMBER:
+				case PlsqlTokenKind::STRING:
+					value = ignore_names ? 0 : hash<string_view>{}(string_view{ code }.substr(token.offset, token.length));
+					break;
+				default:
+					value = token.id;
+				}
+
+				unit.values.emplace_back(mixCloneValue((value << 3) ^ static_cast<uint64_t>(token.kind)));
+				unit.lines.emplace_back(line);
+			}
+
+			units.emplace_back(move(unit));
+		}
+
+		modules[filepath] = move(units);
+	}
+
+	size_t CloneDetector::addModules(FAPIContext & _ctx) { TRACE_FNC("")
+		size_t added{ 0 };
+
+		for (const auto & module : _ctx.getModules()) {
+			if (!module.second->isTraversed())
+				continue;
+
+			addModule(*module.second);
+			++added;
+		}
+
+		for (const auto & library : _ctx.getLibraries()) {
+			addModule(*library.second);
+			++added;
+		}
+
+		return added;
+	}
+
+	void CloneDetector::removeModule(const string & _filepath) { TRACE_FNC(_filepath)
+		modules.erase(_filepath);
+	}
+
+	vector<CloneCluster> CloneDetector::findClones() const { TRACE_FNC("")
+		vector<const CloneUnit *> units;
+
+		for (const auto & module : modules)
+			for (const auto & unit : module.second)
+				if (unit.values.size() >= min_tokens)
+					units.emplace_back(&unit);
+
+		vector<CloneCluster> whole_clusters;
+		vector<CloneCluster> fragment_clusters;
+		vector<bool> represented(units.size(), false);	// duplicate of an earlier unit
+
+		// whole units, equal hashes are verified as hashes of different units can collide
+		vector<uint64_t> unit_hashes(units.size(), 0);
+		unordered_map<uint64_t, vector<uint32_t>> by_hash;
+
+		for (uint32_t u = 0; u < units.size(); ++u) {
+			for (auto value : units[u]->values)
+				unit_hashes[u] = unit_hashes[u] * CLONE_HASH_BASE + value;
+
+			by_hash[unit_hashes[u]].emplace_back(u);
+		}
+
+		for (uint32_t u = 0; u < units.size(); ++u) {
+			if (represented[u])
+				continue;
+
+			CloneCluster cluster{ units[u]->values.size(), true, { locate(*units[u], 0, units[u]->values.size()) } };
+
+			for (auto other : by_hash[unit_hashes[u]])
+				if (other > u && !represented[other] && units[other]->values == units[u]->values) {
+					represented[other] = true;
+					cluster.locations.emplace_back(locate(*units[other], 0, units[other]->values.size()));
+				}
+
+			if (cluster.locations.size() > 1)
+				whole_clusters.emplace_back(move(cluster));
+		}
+
+		// fragments, every window of min_tokens is fingerprinted with rolling hash
+		const size_t window = min_tokens;
+		uint64_t base_power{ 1 };
+
+		for (size_t i = 1; i < window; ++i)
+			base_power *= CLONE_HASH_BASE;
+
+		struct Window {
+			uint64_t hash;
+			uint32_t unit;
+			uint32_t position;
+		};
+
+		vector<Window> windows;
+		vector<vector<uint32_t>> window_indexes(units.size());	// position of unit's windows in sorted windows
+
+		for (uint32_t u = 0; u < units.size(); ++u) {
+			if (represented[u])
+				continue;
+
+			const auto & values = units[u]->values;
+			window_indexes[u].resize(values.size() - window + 1);
+			uint64_t h{ 0 };
+
+			for (size_t i = 0; i < values.size(); ++i) {
+				if (i >= window)
+					h -= values[i - window] * base_power;
+
+				h = h * CLONE_HASH_BASE + values[i];
+
+				if (i + 1 >= window)
+					windows.emplace_back(Window{ h, u, static_cast<uint32_t>(i + 1 - window) });
+			}
+		}
+
+		// equal windows become neighbours, ordered by unit and position
+		sort(windows.begin(), windows.end(), [](const Window & _lhs, const Window & _rhs) {
+			return _lhs.hash != _rhs.hash ? _lhs.hash < _rhs.hash : (_lhs.unit != _rhs.unit ? _lhs.unit < _rhs.unit : _lhs.position < _rhs.position);
+		});
+
+		vector<uint32_t> run_begins(windows.size());
+
+		for (uint32_t i = 0; i < windows.size(); ++i) {
+			run_begins[i] = i > 0 && windows[i - 1].hash == windows[i].hash ? run_begins[i - 1] : i;
+			window_indexes[windows[i].unit][windows[i].position] = i;
+		}
+
+		// windows already reported as part of a fragment
+		vector<vector<bool>> covered(units.size());
+
+		for (uint32_t u = 0; u < units.size(); ++u)
+			covered[u].assign(window_indexes[u].size(), false);
+
+		for (uint32_t u = 0; u < units.size(); ++u) {
+			const auto & values = units[u]->values;
+
+			for (uint32_t p = 0; p < window_indexes[u].size(); ++p) {
+				if (covered[u][p])
+					continue;
+
+				size_t run_begin = run_begins[window_indexes[u][p]];
+				size_t run_end = run_begin + 1;
+
+				while (run_end < windows.size() && windows[run_end].hash == windows[run_begin].hash)
+					++run_end;
+
+				if (run_end - run_begin < 2)
+					continue;
+
+				vector<pair<Window, size_t>> copies;
+
+				for (size_t i = run_begin; i < run_end; ++i) {
+					uint32_t v = windows[i].unit;
+					uint32_t q = windows[i].position;
+
+					// copy inside the same unit can't overlap its original
+					if (v == u && q < p + window && p < q + window)
+						continue;
+
+					const auto & other = units[v]->values;
+
+					// copy continuing an earlier common part was reported from its beginning
+					if (p > 0 && q > 0 && values[p - 1] == other[q - 1])
+						continue;
+
+					if (!equal(values.begin() + p, values.begin() + p + window, other.begin() + q))
+						continue;
+
+					size_t limit = min(values.size() - p, other.size() - q);
+
+					if (v == u)
+						limit = min<size_t>(limit, q > p ? q - p : p - q);
+
+					size_t length = window;
+
+					while (length < limit && values[p + length] == other[q + length])
+						++length;
+
+					copies.emplace_back(windows[i], length);
+				}
+
+				if (copies.empty())
+					continue;
+
+				// every distinct copy length is a cluster of copies at least that long, so copies sharing a longer part
+				// with the unit aren't hidden by the shortest one (their continuation is skipped above)
+				vector<size_t> lengths;
+
+				for (const auto & copy : copies) {
+					uint32_t v = copy.first.unit;
+					uint32_t q = copy.first.position;
+					lengths.emplace_back(copy.second);
+
+					for (size_t i = q; i + window <= q + copy.second; ++i)
+						covered[v][i] = true;
+				}
+
+				sort(lengths.begin(), lengths.end());
+				lengths.erase(unique(lengths.begin(), lengths.end()), lengths.end());
+
+				for (size_t i = p; i + window <= p + lengths.back(); ++i)
+					covered[u][i] = true;
+
+				for (auto length : lengths) {
+					CloneCluster cluster{ length, false, { locate(*units[u], p, length) } };
+
+					for (const auto & copy : copies)
+						if (copy.second >= length)
+							cluster.locations.emplace_back(locate(*units[copy.first.unit], copy.first.position, length));
+
+					fragment_clusters.emplace_back(move(cluster));
+				}
+			}
+		}
+
+		auto longer = [](const CloneCluster & _lhs, const CloneCluster & _rhs) { return _lhs.tokens > _rhs.tokens; };
+		stable_sort(whole_clusters.begin(), whole_clusters.end(), longer);
+		stable_sort(fragment_clusters.begin(), fragment_clusters.end(), longer);
+
+		FAPILogger::debug("Clones: " + to_string(whole_clusters.size()) + " whole-unit and " + to_string(fragment_clusters.size()) + " fragment clusters in " + to_string(units.size()) + " units");
+		whole_clusters.insert(whole_clusters.end(), make_move_iterator(fragment_clusters.begin()), make_move_iterator(fragment_clusters.end()));
+
+		return whole_clusters;
+	}
+
+	size_t CloneDetector::getUnitCount() const { TRACE_FNC("")
+		size_t count{ 0 };
+
+		for (const auto & module : modules)
+			count += module.second.size();
+
+		return count;
+	}
+
+	CloneLocation CloneDetector::locate(const CloneUnit & _unit, const size_t _first, const size_t _length) const {
+		return CloneLocation{ _unit.module, _unit.type_id, _unit.object, _unit.lines[_first], _unit.lines[_first + _length - 1] };
+	}
+}
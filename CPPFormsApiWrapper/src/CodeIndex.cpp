@@ -0,0 +1,485 @@
+#include "CodeIndex.h"
+
+#include "FAPIContext.h"
+#include "FAPIForm.h"
+#include "FAPILibrary.h"
+#include "FormsObject.h"
+#include "Property.h"
+#include "FAPIWrapper.h"
+#include "FAPIUtil.h"
+
+#include "Exceptions.h"
+#include "FAPILogger.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <regex>
+#include <cctype>
+
+namespace CPPFAPIWrapper {
+	using namespace std;
+
+	const string CODE_INDEX_HEADER = "CPPFAPICODEINDEX\t1";
+
+	inline unsigned char foldCase(const char _c) {
+		return static_cast<unsigned char>(toupper(static_cast<unsigned char>(_c)));
+	}
+
+	// distinct trigrams of text, ignoring case
+	vector<uint32_t> extractTrigrams(const string & _text) {
+		vector<uint32_t> keys;
+
+		if (_text.size() < 3)
+			return keys;
+
+		keys.reserve(_text.size() - 2);
+		uint32_t key = (foldCase(_text[0]) << 8) | foldCase(_text[1]);
+
+		for (size_t i = 2; i < _text.size(); ++i) {
+			key = ((key << 8) | foldCase(_text[i])) & 0xFFFFFF;
+			keys.emplace_back(key);
+		}
+
+		sort(keys.begin(), keys.end());
+		keys.erase(unique(keys.begin(), keys.end()), keys.end());
+
+		return keys;
+	}
+
+	// literal runs every match of expression has to contain, empty if they can't be told
+	vector<string> requiredLiterals(const string & _pattern) {
+		vector<string> literals;
+
+		if (_pattern.find('|') != string::npos)
+			return literals;
+
+		string run;
+		int depth{ 0 };
+
+		auto endRun = [&]() {
+			if (run.size() >= 3)
+				literals.emplace_back(run);
+
+			run.clear();
+		};
+
+		for (size_t i = 0; i < _pattern.size(); ++i) {
+			char c = _pattern[i];
+
+			switch (c) {
+			case '*':
+			case '?':
+			case '{':
+				// preceding character is optional
+				if (!run.empty())
+					run.pop_back();
+
+				endRun();
+
+				if (c == '{')
+					i = min(_pattern.find('}', i), _pattern.size());
+
+				break;
+			case '+':
+				endRun();
+				break;
+			case '(':
+				++depth;
+				endRun();
+				break;
+			case ')':
+				--depth;
+				endRun();
+				break;
+			case '[':
+				endRun();
+
+				for (++i; i < _pattern.size() && _pattern[i] != ']'; ++i)
+					if (_pattern[i] == '\\')
+						++i;
+
+				break;
+			case '.':
+			case '^':
+			case '$':
+				endRun();
+				break;
+			case '\\':
+				if (i + 1 < _pattern.size() && !isalnum(static_cast<unsigned char>(_pattern[i + 1]))) {
+					if (depth == 0)
+						run += _pattern[++i];
+					else
+						++i;
+				}
+				else {
+					// character class, back-reference or escaped character code, skipped as a whole
+					endRun();
+					++i;
+
+					if (i >= _pattern.size())
+						break;
+
+					size_t length{ 0 };
+
+					if (_pattern[i] == 'x')
+						length = 2;
+					else if (_pattern[i] == 'u')
+						length = 4;
+					else if (_pattern[i] == 'c')
+						length = 1;
+					else
+						while (isdigit(static_cast<unsigned char>(_pattern[i])) && i + 1 < _pattern.size() && isdigit(static_cast<unsigned char>(_pattern[i + 1])))
+							++i;
+
+					i = min(i + length, _pattern.size() - 1);
+				}
+
+				break;
+			default:
+				if (depth == 0)
+					run += c;
+			}
+		}
+
+		endRun();
+		return literals;
+	}
+
+	CodeIndex::CodeIndex()
+		: removed_units(0) { TRACE_FNC("") }
+
+	size_t CodeIndex::update(FAPIContext & _ctx) { TRACE_FNC("")
+		size_t indexed{ 0 };
+
+		for (const auto & module : _ctx.getModules()) {
+			if (!module.second->isTraversed() || !isOutdated(module.second->getFilepath()))
+				continue;
+
+			indexModule(*module.second);
+			++indexed;
+		}
+
+		for (const auto & library : _ctx.getLibraries()) {
+			if (!isOutdated(library.second->getFilepath()))
+				continue;
+
+			indexModule(*library.second);
+			++indexed;
+		}
+
+		return indexed;
+	}
+
+	size_t CodeIndex::update(FAPIContext & _ctx, const vector<string> & _filepaths, const bool _ignore_missing_libs, const bool _ignore_missing_sub) { TRACE_FNC(to_string(_filepaths.size()))
+		size_t indexed{ 0 };
+
+		for (const auto & filepath : _filepaths) {
+			if (!isOutdated(filepath))
+				continue;
+
+			_ctx.visitModule(filepath, [this](const FAPIModule & _module) { indexModule(_module); }, _ignore_missing_libs, _ignore_missing_sub);
+
+			++indexed;
+		}
+
+		FAPILogger::debug("Code index: " + to_string(indexed) + " of " + to_string(_filepaths.size()) + " modules indexed");
+		return indexed;
+	}
+
+	void CodeIndex::indexModule(const FAPIModule & _module) { TRACE_FNC(_module.getFilepath())
+		vector<IndexedUnit> module_units;
+
+		for (const auto & fo : _module.getAllObjects()) {
+			int type_id = fo->getId();
+
+			if (type_id != D2FFO_TRIGGER && type_id != D2FFO_PROG_UNIT && type_id != D2FFO_LIB_PROG_UNIT)
+				continue;
+
+			auto & properties = fo->getProperties();
+			auto code = properties.find(type_id == D2FFO_TRIGGER ? D2FP_TRG_TXT : D2FP_PGU_TXT);
+
+			if (code != properties.end())
+				module_units.emplace_back(IndexedUnit{ _module.getFilepath(), type_id, fo->getFullName(), code->second->getValue(), false });
+		}
+
+		addModule(_module.getFilepath(), fileFingerprint(_module.getFilepath()), move(module_units));
+	}
+
+	void CodeIndex::removeModule(const string & _filepath) { TRACE_FNC(_filepath)
+		auto module = modules.find(_filepath);
+
+		if (module == modules.end())
+			return;
+
+		for (auto id : module->second.units)
+			units[id].removed = true;
+
+		removed_units += module->second.units.size();
+		modules.erase(module);
+
+		if (removed_units > units.size() / 2)
+			compact();
+	}
+
+	bool CodeIndex::hasModule(const string & _filepath) const { TRACE_FNC(_filepath)
+		return modules.count(_filepath) > 0;
+	}
+
+	bool CodeIndex::isOutdated(const string & _filepath) { TRACE_FNC(_filepath)
+		auto module = modules.find(_filepath);
+
+		if (module == modules.end())
+			return true;
+
+		FileFingerprint & indexed = module->second.fingerprint;
+
+		if (fileChanged(indexed, _filepath))
+			return true;
+
+		// touched but unchanged file keeps its units, new modification time saves hashing it next time
+		indexed.mtime = fileFingerprint(_filepath, false).mtime;
+		return false;
+	}
+
+	vector<CodeHit> CodeIndex::find(const string & _text) const { TRACE_FNC(_text)
+		if (_text.empty())
+			return {};
+
+		return collectHits(findCandidates({ _text }), [&_text](const string & _code, vector<size_t> & _offsets) {
+			auto equal = [](const char _lhs, const char _rhs) { return foldCase(_lhs) == foldCase(_rhs); };
+			auto it = _code.begin();
+
+			while ((it = search(it, _code.end(), _text.begin(), _text.end(), equal)) != _code.end()) {
+				_offsets.emplace_back(it - _code.begin());
+				++it;
+			}
+		});
+	}
+
+	vector<CodeHit> CodeIndex::findRegex(const string & _pattern, const bool _icase) const { TRACE_FNC(_pattern)
+		regex expression;
+
+		try {
+			expression = regex{ _pattern, _icase ? regex::ECMAScript | regex::icase : regex::ECMAScript };
+		}
+		catch (regex_error & ex) {
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Invalid regular expression " + _pattern + ": " + ex.what() };
+		}
+
+		// every line is matched separately, so ^ and $ anchor at its boundaries
+		return collectHits(findCandidates(requiredLiterals(_pattern)), [&expression](const string & _code, vector<size_t> & _offsets) {
+			for (size_t begin = 0; ; ) {
+				size_t end = _code.find('\n', begin);
+				size_t text_end = end == string::npos ? _code.size() : end;
+
+				if (text_end > begin && _code[text_end - 1] == '\r')
+					--text_end;
+
+				if (regex_search(_code.begin() + begin, _code.begin() + text_end, expression))
+					_offsets.emplace_back(begin);
+
+				// line separator ending the code doesn't start another line
+				if (end == string::npos || end + 1 == _code.size())
+					break;
+
+				begin = end + 1;
+			}
+		});
+	}
+
+	size_t CodeIndex::getModuleCount() const { TRACE_FNC("")
+		return modules.size();
+	}
+
+	size_t CodeIndex::getUnitCount() const { TRACE_FNC("")
+		return units.size() - removed_units;
+	}
+
+	void CodeIndex::save(const string & _filepath) const { TRACE_FNC(_filepath)
+		// every process writing the same index has its own temporary file
+		string tmp_path = temporaryPath(_filepath);
+		bool written{ false };
+
+		{
+			ofstream file{ tmp_path, ios::binary | ios::trunc };
+
+			if (file.is_open()) {
+				file << CODE_INDEX_HEADER << "\n";
+
+				for (const auto & module : modules) {
+					const auto & fingerprint = module.second.fingerprint;
+					file << "M\t" << escapeField(module.first) << "\t" << fingerprint.size << "\t" << fingerprint.mtime << "\t" << fingerprint.hash << "\n";
+
+					for (auto id : module.second.units)
+						file << "U\t" << units[id].type_id << "\t" << escapeField(units[id].object) << "\t" << escapeField(units[id].code) << "\n";
+				}
+
+				written = static_cast<bool>(file);
+			}
+		}
+
+		if (!written || !replaceFile(tmp_path, _filepath)) {
+			remove(tmp_path.c_str());
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Couldn't write code index: " + _filepath };
+		}
+	}
+
+	void CodeIndex::load(const string & _filepath) { TRACE_FNC(_filepath)
+		ifstream file{ _filepath, ios::binary };
+
+		if (!file.is_open())
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Couldn't open code index: " + _filepath };
+
+		string line;
+
+		if (!getline(file, line) || line != CODE_INDEX_HEADER)
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Invalid code index: " + _filepath };
+
+		vector<pair<string, FileFingerprint>> loaded_modules;
+		vector<vector<IndexedUnit>> loaded_units;
+
+		try {
+			while (getline(file, line)) {
+				auto fields = splitEscapedFields(line);
+
+				if (fields[0] == "M" && fields.size() == 5) {
+					loaded_modules.emplace_back(fields[1], FileFingerprint{ stoll(fields[2]), stoll(fields[3]), stoull(fields[4]) });
+					loaded_units.emplace_back();
+				}
+				else if (fields[0] == "U" && fields.size() == 4 && !loaded_modules.empty())
+					loaded_units.back().emplace_back(IndexedUnit{ loaded_modules.back().first, stoi(fields[1]), fields[2], fields[3], false });
+				else
+					throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Malformed code index line: " + line };
+			}
+		}
+		catch (logic_error & ex) {
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, string{ "Malformed code index: " } + ex.what() };
+		}
+
+		modules.clear();
+		units.clear();
+		trigrams.clear();
+		removed_units = 0;
+
+		for (size_t i = 0; i < loaded_modules.size(); ++i)
+			addModule(loaded_modules[i].first, loaded_modules[i].second, move(loaded_units[i]));
+	}
+
+	void CodeIndex::addModule(const string & _filepath, const FileFingerprint & _fingerprint, vector<IndexedUnit> _units) { TRACE_FNC(_filepath + " | " + to_string(_units.size()))
+		removeModule(_filepath);
+		IndexedModule & module = modules[_filepath];
+		module.fingerprint = _fingerprint;
+
+		for (auto & unit : _units) {
+			module.units.emplace_back(static_cast<uint32_t>(units.size()));
+			units.emplace_back(move(unit));
+			addTrigrams(module.units.back());
+		}
+	}
+
+	void CodeIndex::addTrigrams(const uint32_t _unit) {
+		for (auto key : extractTrigrams(units[_unit].code))
+			trigrams[key].emplace_back(_unit);
+	}
+
+	void CodeIndex::compact() { TRACE_FNC(to_string(removed_units))
+		vector<uint32_t> new_ids(units.size());
+		vector<IndexedUnit> kept;
+		kept.reserve(units.size() - removed_units);
+
+		for (size_t i = 0; i < units.size(); ++i) {
+			if (units[i].removed)
+				continue;
+
+			new_ids[i] = static_cast<uint32_t>(kept.size());
+			kept.emplace_back(move(units[i]));
+		}
+
+		for (auto & module : modules)
+			for (auto & id : module.second.units)
+				id = new_ids[id];
+
+		units.swap(kept);
+		removed_units = 0;
+		trigrams.clear();
+
+		for (uint32_t i = 0; i < units.size(); ++i)
+			addTrigrams(i);
+	}
+
+	vector<uint32_t> CodeIndex::findCandidates(const vector<string> & _literals) const {
+		vector<const vector<uint32_t> *> postings;
+
+		for (const auto & literal : _literals) {
+			for (auto key : extractTrigrams(literal)) {
+				auto posting = trigrams.find(key);
+
+				if (posting == trigrams.end())
+					return {};
+
+				postings.emplace_back(&posting->second);
+			}
+		}
+
+		vector<uint32_t> candidates;
+
+		if (postings.empty()) {
+			for (uint32_t i = 0; i < units.size(); ++i)
+				if (!units[i].removed)
+					candidates.emplace_back(i);
+
+			return candidates;
+		}
+
+		// intersection from the rarest trigram, so intermediate results are smallest
+		sort(postings.begin(), postings.end(), [](const auto * _lhs, const auto * _rhs) { return _lhs->size() < _rhs->size(); });
+		candidates = *postings[0];
+
+		for (size_t i = 1; i < postings.size() && !candidates.empty(); ++i) {
+			vector<uint32_t> intersection;
+			set_intersection(candidates.begin(), candidates.end(), postings[i]->begin(), postings[i]->end(), back_inserter(intersection));
+			candidates.swap(intersection);
+		}
+
+		candidates.erase(remove_if(candidates.begin(), candidates.end(), [this](const uint32_t _id) { return units[_id].removed; }), candidates.end());
+		return candidates;
+	}
+
+	vector<CodeHit> CodeIndex::collectHits(const vector<uint32_t> & _candidates, function<void(const string &, vector<size_t> &)> _match) const {
+		vector<CodeHit> hits;
+		vector<size_t> offsets;
+
+		for (auto id : _candidates) {
+			const IndexedUnit & unit = units[id];
+			offsets.clear();
+			_match(unit.code, offsets);
+
+			size_t line{ 1 };
+			size_t counted{ 0 };
+			size_t last_line{ 0 };
+
+			for (auto offset : offsets) {
+				line += count(unit.code.begin() + counted, unit.code.begin() + offset, '\n');
+				counted = offset;
+
+				if (line == last_line)
+					continue;
+
+				size_t begin = unit.code.rfind('\n', offset == 0 ? 0 : offset - 1);
+				begin = begin == string::npos || offset == 0 ? 0 : begin + 1;
+				size_t end = unit.code.find('\n', offset);
+				string text = unit.code.substr(begin, end == string::npos ? string::npos : end - begin);
+
+				if (!text.empty() && text.back() == '\r')
+					text.pop_back();
+
+				hits.emplace_back(CodeHit{ unit.module, unit.type_id, unit.object, line, move(text) });
+				last_line = line;
+			}
+		}
+
+		stable_sort(hits.begin(), hits.end(), [](const CodeHit & _lhs, const CodeHit & _rhs) { return _lhs.module < _rhs.module; });
+		return hits;
+	}
+}
@@ -0,0 +1,167 @@
+#include "ContextPool.h"
+
+#include "FAPIContext.h"
+#include "FAPIWrapper.h"
+
+#include "Exceptions.h"
+#include "FAPILogger.h"
+
+namespace CPPFAPIWrapper {
+	using namespace std;
+
+	ContextLease::ContextLease(ContextPool * _pool, unique_ptr<FAPIContext> _ctx)
+		: pool(_pool), ctx(move(_ctx)) { TRACE_FNC("") }
+
+	ContextLease::ContextLease(ContextLease && _lease)
+		: pool(_lease.pool), ctx(move(_lease.ctx)) { TRACE_FNC("") }
+
+	ContextLease & ContextLease::operator=(ContextLease && _lease) { TRACE_FNC("")
+		if (this != &_lease) {
+			release();
+			pool = _lease.pool;
+			ctx = move(_lease.ctx);
+		}
+
+		return *this;
+	}
+
+	ContextLease::~ContextLease() { TRACE_FNC("")
+		release();
+	}
+
+	FAPIContext * ContextLease::get() const { TRACE_FNC("")
+		if (!ctx)
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Context lease is not valid" };
+
+		return ctx.get();
+	}
+
+	FAPIContext * ContextLease::operator->() const { TRACE_FNC("")
+		return get();
+	}
+
+	FAPIContext & ContextLease::operator*() const { TRACE_FNC("")
+		return *get();
+	}
+
+	bool ContextLease::isValid() const { TRACE_FNC("")
+		return ctx != nullptr;
+	}
+
+	void ContextLease::release() { TRACE_FNC("")
+		if (ctx)
+			pool->release(move(ctx), false);
+	}
+
+	void ContextLease::discard() { TRACE_FNC("")
+		if (ctx)
+			pool->release(move(ctx), true);
+	}
+
+	ContextPool::ContextPool(const size_t _size, const string & _connstring, function<void(FAPIContext &)> _init)
+		: connstring(_connstring), init(_init), pool_size(_size), missing(0) { TRACE_FNC(to_string(_size) + " | " + _connstring)
+		if (_size == 0)
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Context pool can't be empty" };
+
+		idle.reserve(_size);
+
+		for (size_t i = 0; i < _size; ++i)
+			idle.emplace_back(createPooledContext());
+	}
+
+	ContextPool::~ContextPool() { TRACE_FNC("")
+		if (idle.size() + missing != pool_size)
+			FAPILogger::warn("Context pool destroyed while contexts are still leased");
+	}
+
+	unique_ptr<FAPIContext> ContextPool::createPooledContext() const { TRACE_FNC("")
+		auto ctx = make_unique<FAPIContext>();
+
+		if (!connstring.empty())
+			ctx->connectContextToDB(connstring);
+
+		if (init)
+			init(*ctx);
+
+		return ctx;
+	}
+
+	ContextLease ContextPool::take(unique_lock<mutex> & _lock) { TRACE_FNC("")
+		if (!idle.empty()) {
+			auto ctx = move(idle.back());
+			idle.pop_back();
+
+			return ContextLease{ this, move(ctx) };
+		}
+
+		// context discarded earlier couldn't be recreated, try again
+		--missing;
+		_lock.unlock();
+
+		try {
+			return ContextLease{ this, createPooledContext() };
+		}
+		catch (...) {
+			_lock.lock();
+			++missing;
+			throw;
+		}
+	}
+
+	ContextLease ContextPool::acquire() { TRACE_FNC("")
+		unique_lock<mutex> lock{ pool_mutex };
+		returned.wait(lock, [this]() { return !idle.empty() || missing > 0; });
+
+		return take(lock);
+	}
+
+	ContextLease ContextPool::tryAcquire(const chrono::milliseconds _timeout) { TRACE_FNC(to_string(_timeout.count()))
+		unique_lock<mutex> lock{ pool_mutex };
+
+		if (!returned.wait_for(lock, _timeout, [this]() { return !idle.empty() || missing > 0; }))
+			return ContextLease{ this, nullptr };
+
+		return take(lock);
+	}
+
+	void ContextPool::release(unique_ptr<FAPIContext> _ctx, bool _discard) { TRACE_FNC(to_string(_discard))
+		if (!_discard) {
+			try {
+				_ctx->reset();
+			}
+			catch (exception & ex) {
+				FAPILogger::warn(string{ "Couldn't reset pooled context: " } + ex.what());
+				_discard = true;
+			}
+		}
+
+		if (_discard) {
+			_ctx = nullptr;
+
+			try {
+				_ctx = createPooledContext();
+			}
+			catch (exception & ex) { FAPILogger::warn(string{ "Couldn't recreate pooled context: " } + ex.what()); }
+		}
+
+		{
+			lock_guard<mutex> lock{ pool_mutex };
+
+			if (_ctx)
+				idle.emplace_back(move(_ctx));
+			else
+				++missing;
+		}
+
+		returned.notify_one();
+	}
+
+	size_t ContextPool::size() const { TRACE_FNC("")
+		return pool_size;
+	}
+
+	size_t ContextPool::available() const { TRACE_FNC("")
+		lock_guard<mutex> lock{ pool_mutex };
+		return idle.size() + missing;
+	}
+}
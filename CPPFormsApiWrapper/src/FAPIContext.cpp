@@ -4,7 +4,16 @@
 #include "FAPILibrary.h"
 #include "FAPIWrapper.h"
 #include "FAPIUtil.h"
+#include "ModuleSnapshot.h"
+#include "ModuleImage.h"
+#include "ModulePathResolver.h"
+#include "BuiltinsCatalogue.h"
+#include "ObjectReport.h"
+#include "TaskExecutor.h"
 #include <algorithm>
+#include <atomic>
+#include <deque>
+#include <unordered_set>
 
 #include "Expected.h"
 #include "Exceptions.h"
@@ -29,9 +38,191 @@ namespace CPPFAPIWrapper {
 		ctx = unique_ptr<d2fctx, function<void(d2fctx *)>>{ ctx_, deleter };
 	}
 
-	FAPIContext::~FAPIContext() { TRACE_FNC(""); }
+	FAPIContext::~FAPIContext() { TRACE_FNC("");
+		// pending asynchronous operations still use modules and OracleForms context
+		worker = nullptr;
+		// modules release shared libraries when destroyed
+		reset();
+	}
+
+	// runs task inline when called from worker thread, so waiting for result can't deadlock
+	template<class F>
+	auto submitToContextWorker(TaskExecutor & _worker, F && _task) -> future<decltype(_task())> {
+		if (!_worker.isExecutorThread())
+			return _worker.submit(forward<F>(_task));
+
+		packaged_task<decltype(_task())()> task{ forward<F>(_task) };
+		auto result = task.get_future();
+		task();
+
+		return result;
+	}
+
+	TaskExecutor & FAPIContext::getWorker() { TRACE_FNC("")
+		lock_guard<mutex> lock{ worker_mutex };
+
+		if (!worker)
+			worker = make_unique<TaskExecutor>(1);
+
+		return *worker;
+	}
+
+	future<FAPIForm *> FAPIContext::loadModuleAsync(const string & _filepath, const bool _ignore_missing_libs, const bool _ignore_missing_sub, const bool _traverse) { TRACE_FNC(_filepath)
+		return submitToContextWorker(getWorker(), [this, _filepath, _ignore_missing_libs, _ignore_missing_sub, _traverse]() {
+			loadModule(_filepath, _ignore_missing_libs, _ignore_missing_sub, _traverse);
+			return getModule(_filepath);
+		});
+	}
+
+	future<FAPILibrary *> FAPIContext::loadLibraryAsync(const string & _filepath) { TRACE_FNC(_filepath)
+		return submitToContextWorker(getWorker(), [this, _filepath]() {
+			loadLibrary(_filepath);
+			return getLibrary(_filepath);
+		});
+	}
+
+	future<void> FAPIContext::runAsync(function<void(FAPIContext &)> _task) { TRACE_FNC("")
+		return submitToContextWorker(getWorker(), [this, _task]() { _task(*this); });
+	}
+
+	size_t FAPIContext::analyseModules(const vector<string> & _filepaths, function<void(const FAPIForm &)> _analyse, const size_t _threads, const bool _ignore_missing_libs, const bool _ignore_missing_sub) { TRACE_FNC(to_string(_filepaths.size()) + " | " + to_string(_threads))
+		return analyseModules(_filepaths, [&_analyse](const FAPIForm & _module, const size_t) { _analyse(_module); }, _threads, _ignore_missing_libs, _ignore_missing_sub);
+	}
+
+	size_t FAPIContext::analyseModules(const vector<string> & _filepaths, function<void(const FAPIForm &, const size_t)> _analyse, const size_t _threads, const bool _ignore_missing_libs, const bool _ignore_missing_sub) { TRACE_FNC(to_string(_filepaths.size()) + " | " + to_string(_threads))
+		TaskExecutor & ctx_worker = getWorker();
+
+		if (ctx_worker.isExecutorThread())
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Modules can't be analysed from context worker thread" };
+
+		atomic<bool> aborted{ false };
+		exception_ptr error;
+		size_t analysed{ 0 };
+		// same module listed twice would be removed after first analysis while second one still uses it
+		vector<size_t> indices;
+		unordered_set<string> listed;
+
+		for (size_t i = 0; i < _filepaths.size(); ++i)
+			if (listed.insert(toUpper(_filepaths[i])).second)
+				indices.emplace_back(i);
+
+		{
+			TaskExecutor analysers{ _threads };
+			deque<future<bool>> pending;
+			// number of modules loaded ahead of analysis
+			size_t window = max<size_t>(_threads, 1) + 1;
+
+			auto wait_front = [&]() {
+				try {
+					analysed += pending.front().get() ? 1 : 0;
+				}
+				catch (...) {
+					if (!error)
+						error = current_exception();
+
+					aborted = true;
+				}
+
+				pending.pop_front();
+			};
+
+			for (auto index : indices) {
+				if (aborted)
+					break;
+
+				const string & filepath = _filepaths[index];
+
+				auto load = ctx_worker.submit([this, filepath, _ignore_missing_libs, _ignore_missing_sub, &aborted]() {
+					if (aborted)
+						return make_pair(static_cast<FAPIForm *>(nullptr), true);
+
+					bool loaded = hasModule(filepath);
+
+					if (!loaded)
+						loadModule(filepath, _ignore_missing_libs, _ignore_missing_sub);
+
+					auto module = getModule(filepath);
+
+					if (!module->isTraversed()) {
+						int status = module->traverseObjects();
+
+						if (status != D2FS_SUCCESS)
+							throw FAPIException{ Reason::INTERNAL_ERROR, __FILE__, __LINE__, filepath, status };
+					}
+
+					return make_pair(module, loaded);
+				}).share();
+
+				pending.emplace_back(analysers.submit([this, filepath, index, load, &_analyse, &ctx_worker, &aborted]() {
+					auto module = load.get();
+
+					if (!module.first)
+						return false;
+
+					auto release = [&]() {
+						if (!module.second)
+							ctx_worker.post([this, filepath]() { removeModule(filepath); });
+					};
+
+					try {
+						if (!aborted)
+							_analyse(*module.first, index);
+					}
+					catch (...) {
+						release();
+						throw;
+					}
+
+					release();
+
+					return !aborted;
+				}));
+
+				if (pending.size() >= window)
+					wait_front();
+			}
+
+			while (!pending.empty())
+				wait_front();
+		}
+
+		// wait until analysed modules are removed
+		ctx_worker.submit([]() {}).get();
+
+		if (error)
+			rethrow_exception(error);
+
+		return analysed;
+	}
 
 	unordered_map<string, vector<string>> FAPIContext::getBuiltins() { TRACE_FNC("")
+		return getBuiltinsCatalogue(this).getPackages();
+	}
+
+	bool FAPIContext::isBuiltin(const string & _name) { TRACE_FNC(_name)
+		return getBuiltinsCatalogue(this).contains(_name);
+	}
+
+	const BuiltinsMatcher & FAPIContext::getBuiltinsMatcher() { TRACE_FNC("")
+		lock_guard<mutex> lock{ matcher_mutex };
+
+		if (!builtins_matcher)
+			builtins_matcher = make_unique<BuiltinsMatcher>(getBuiltinsCatalogue(this));
+
+		return *builtins_matcher;
+	}
+
+	uint32_t FAPIContext::getBuilderVersion() const { TRACE_FNC("")
+		number version{ 0 };
+		int status = d2fctxbv_BuilderVersion(ctx.get(), &version);
+
+		if (status != D2FS_SUCCESS)
+			throw FAPIException{ Reason::INTERNAL_ERROR, __FILE__, __LINE__, "", status };
+
+		return static_cast<uint32_t>(version);
+	}
+
+	unordered_map<string, vector<string>> FAPIContext::enumerateBuiltins() { TRACE_FNC("")
 		unordered_map<string, vector<string>> builtins;
 		text *** arr{ nullptr };
 		int status = d2fctxbi_BuiltIns(ctx.get(), &arr);
@@ -39,7 +230,7 @@ namespace CPPFAPIWrapper {
 		if (status != D2FS_SUCCESS)
 			throw FAPIException{ Reason::INTERNAL_ERROR, __FILE__, __LINE__, "", status };
 
-		while (*arr) {
+		while (arr && *arr) {
 			text ** list{ *arr };
 
 			vector<string> units;
@@ -57,48 +248,210 @@ namespace CPPFAPIWrapper {
 		return builtins;
 	}
 
-	void FAPIContext::loadSourceModules(const FAPIForm * _module, const bool _ignore_missing_libs, const bool _ignore_missing_sub, const bool _traverse) { TRACE_FNC(to_string(_ignore_missing_libs) + " | " + to_string(_ignore_missing_sub))
-		unordered_set<string> to_process = _module->getSourceModules();
-		unordered_set<string> processed = _module->getSourceModules();
-		processed.insert(_module->getName());
+	size_t FAPIContext::createObjectReports(const vector<string> & _filepaths, const string & _directory, const size_t _threads, const bool _ignore_missing_libs, const bool _ignore_missing_sub) { TRACE_FNC(to_string(_filepaths.size()) + " | " + _directory + " | " + to_string(_threads))
+		return analyseModules(_filepaths, [&_directory](const FAPIForm & _module) {
+			string module_path = _module.getFilepath();
+			string report_path = _directory.empty() ? "" : _directory + "/" + module_path.substr(module_path.find_last_of("/\\") + 1);
+			writeObjectReportFile(_module, objectReportPath(module_path, report_path));
+		}, _threads, _ignore_missing_libs, _ignore_missing_sub);
+	}
 
-		while (true) {
-			unordered_set<string> to_load;
+	vector<BuiltinsReport> FAPIContext::reportBuiltins(const vector<string> & _filepaths, const size_t _threads, const bool _ignore_missing_libs, const bool _ignore_missing_sub) { TRACE_FNC(to_string(_filepaths.size()) + " | " + to_string(_threads))
+		// compiled before analysis starts, analysis threads can't use context
+		const BuiltinsMatcher & matcher = getBuiltinsMatcher();
+		vector<pair<size_t, BuiltinsReport>> indexed_reports;
+		mutex reports_mutex;
 
-			for (const auto & source_mod : to_process) {
-				string path = modulePathFromName(source_mod);
+		analyseModules(_filepaths, [&](const FAPIForm & _module, const size_t _index) {
+			auto report = matcher.analyseModule(_module);
 
-				if (hasModule(path))
-					continue;
+			lock_guard<mutex> lock{ reports_mutex };
+			indexed_reports.emplace_back(_index, move(report));
+		}, _threads, _ignore_missing_libs, _ignore_missing_sub);
 
-				try {
-					loadModule(path, _ignore_missing_libs, _ignore_missing_sub);
-					auto parent_module = getModule(path);
+		// reports are ordered as paths given, whatever path module was loaded with
+		sort(indexed_reports.begin(), indexed_reports.end(), [](const pair<size_t, BuiltinsReport> & _lhs, const pair<size_t, BuiltinsReport> & _rhs) { return _lhs.first < _rhs.first; });
 
-					for (auto & source_mod2 : parent_module->getSourceModules()) {
-						if (processed.find(source_mod2) == processed.end()) {
-							to_load.insert(source_mod2);
-							processed.insert(source_mod2);
+		vector<BuiltinsReport> reports;
+		reports.reserve(indexed_reports.size());
 
-							FAPILogger::debug("To process: " + source_mod2);
-						}
-					}
+		for (auto & report : indexed_reports)
+			reports.emplace_back(move(report.second));
+
+		return reports;
+	}
+
+	ModuleGraph FAPIContext::buildModuleGraph(const string & _filepath, const bool _ignore_missing_libs, const bool _ignore_missing_sub) { TRACE_FNC(_filepath + " | " + to_string(_ignore_missing_libs) + " | " + to_string(_ignore_missing_sub))
+		ModuleGraph graph;
+		string root_name = moduleNameFromPath(_filepath);
+		vector<string> to_process{ root_name };
+		graph.addModule(root_name, toUpper(_filepath), ModuleKind::FORM);
+
+		while (!to_process.empty()) {
+			string name = to_process.back();
+			to_process.pop_back();
+			string path = graph.getModule(name).path;
+
+			if (path.empty())
+				continue;
+
+			// restored module has its dependencies known, so it isn't loaded by OracleForms at all
+			if (!hasModule(path) && !restoreModule(path, _ignore_missing_libs, _ignore_missing_sub))
+				loadModule(path, _ignore_missing_libs, _ignore_missing_sub, false);
+
+			auto module = getModule(path);
+			int status = module->scanDependencies();
+
+			if (status != D2FS_SUCCESS)
+				throw FAPIException{ Reason::INTERNAL_ERROR, __FILE__, __LINE__, path, status };
+
+			for (const auto & source_mod : module->getSourceModules()) {
+				if (source_mod == name)
+					continue;
+
+				if (!graph.hasModule(source_mod)) {
+					graph.addModule(source_mod, resolveModulePath(source_mod, ModuleKind::FORM, _ignore_missing_sub), ModuleKind::FORM);
+					to_process.emplace_back(source_mod);
+
+					FAPILogger::debug("To process: " + source_mod);
 				}
-				catch (exception & ex) { FAPILogger::error(ex.what()); }
+
+				graph.addDependency(name, source_mod);
 			}
 
-			if (to_load.empty())
-				break;
+			for (const auto & lib : module->getLibraryModules()) {
+				if (!graph.hasModule(lib))
+					graph.addModule(lib, resolveModulePath(lib, ModuleKind::LIBRARY, _ignore_missing_libs), ModuleKind::LIBRARY);
 
-			to_process.insert(to_load.begin(), to_load.end());
+				graph.addDependency(name, lib);
+			}
+		}
+
+		return graph;
+	}
+
+	void FAPIContext::loadSourceModules(const FAPIForm * _module, const bool _ignore_missing_libs, const bool _ignore_missing_sub, const bool _traverse) { TRACE_FNC(to_string(_ignore_missing_libs) + " | " + to_string(_ignore_missing_sub))
+		auto graph = buildModuleGraph(_module->getFilepath(), _ignore_missing_libs, _ignore_missing_sub);
+
+		for (const auto & name : graph.topologicalOrder()) {
+			const auto & node = graph.getModule(name);
+
+			if (node.kind != ModuleKind::FORM || node.path.empty() || !_traverse)
+				continue;
+
+			auto module = getModule(node.path);
+
+			if (module->isTraversed())
+				continue;
+
+			int status = module->traverseObjects();
+
+			if (status != D2FS_SUCCESS)
+				throw FAPIException{ Reason::INTERNAL_ERROR, __FILE__, __LINE__, node.path, status };
+
+			saveSnapshot(module);
 		}
 	}
 
 	void FAPIContext::loadModuleWithSources(const string & _filepath, const bool _ignore_missing_libs, const bool _ignore_missing_sub, const bool _traverse) { TRACE_FNC(_filepath + " | " + to_string(_ignore_missing_libs) + " | " + to_string(_ignore_missing_sub))
-		loadModule(_filepath, _ignore_missing_libs, _ignore_missing_sub);
+		loadModule(_filepath, _ignore_missing_libs, _ignore_missing_sub, _traverse);
 		auto module = getModule(_filepath);
-		loadSourceModules(module, _ignore_missing_libs, _ignore_missing_sub);
-		module->checkOverriden();
+		loadSourceModules(module, _ignore_missing_libs, _ignore_missing_sub, _traverse);
+
+		// inheritance is checked on object tree, which untraversed module doesn't have
+		if (module->isTraversed())
+			module->checkOverriden();
+	}
+
+	size_t FAPIContext::reportInheritance(const vector<string> & _filepaths, InheritanceSink & _sink, const bool _ignore_missing_libs, const bool _ignore_missing_sub) { TRACE_FNC(to_string(_filepaths.size()))
+		size_t records{ 0 };
+
+		for (const auto & filepath : _filepaths) {
+			bool loaded = hasModule(filepath);
+
+			if (!loaded)
+				loadModule(filepath, _ignore_missing_libs, _ignore_missing_sub);
+
+			auto module = getModule(filepath);
+
+			try {
+				if (!module->isTraversed()) {
+					int status = module->traverseObjects();
+
+					if (status != D2FS_SUCCESS)
+						throw FAPIException{ Reason::INTERNAL_ERROR, __FILE__, __LINE__, filepath, status };
+				}
+
+				records += module->reportOverriden(_sink);
+			}
+			catch (...) {
+				if (!loaded)
+					removeModule(filepath);
+
+				throw;
+			}
+
+			if (!loaded)
+				removeModule(filepath);
+		}
+
+		return records;
+	}
+
+	void FAPIContext::visitModule(const string & _filepath, function<void(const FAPIModule &)> _visit, const bool _ignore_missing_libs, const bool _ignore_missing_sub) { TRACE_FNC(_filepath)
+		bool library = toUpper(_filepath.substr(_filepath.rfind('.') + 1)) == "PLL";
+		bool loaded = library ? hasLibrary(_filepath) : hasModule(_filepath);
+
+		auto unload = [&]() {
+			if (loaded)
+				return;
+
+			if (library)
+				removeLibrary(_filepath);
+			else
+				removeModule(_filepath);
+		};
+
+		if (library) {
+			if (!loaded)
+				loadLibrary(_filepath);
+
+			try {
+				_visit(*getLibrary(_filepath));
+			}
+			catch (...) {
+				unload();
+				throw;
+			}
+		}
+		else {
+			if (!loaded)
+				loadModule(_filepath, _ignore_missing_libs, _ignore_missing_sub);
+
+			auto module = getModule(_filepath);
+
+			try {
+				if (!module->isTraversed()) {
+					int status = module->traverseObjects();
+
+					if (status != D2FS_SUCCESS)
+						throw FAPIException{ Reason::INTERNAL_ERROR, __FILE__, __LINE__, _filepath, status };
+				}
+
+				_visit(*module);
+			}
+			catch (...) {
+				unload();
+				throw;
+			}
+		}
+
+		unload();
+	}
+
+	// module with missing libraries or subobjects is accepted only if they are ignored
+	bool isAcceptedLoadStatus(const int _status, const bool _ignore_missing_libs, const bool _ignore_missing_sub) {
+		return _status == D2FS_SUCCESS || (_ignore_missing_libs && _status == D2FS_MISSINGLIBMOD) || (_ignore_missing_sub && _status == D2FS_MISSINGSUBCLMOD);
 	}
 
 	void FAPIContext::loadModule(const string & _filepath, const bool _ignore_missing_libs, const bool _ignore_missing_sub, const bool _traverse) { TRACE_FNC(_filepath + " | " + to_string(_ignore_missing_libs) + " | " + to_string(_ignore_missing_sub))
@@ -108,21 +461,24 @@ namespace CPPFAPIWrapper {
 		if (!fileExists(_filepath))
 			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, _filepath };
 
+		if (_traverse && restoreModule(_filepath, _ignore_missing_libs, _ignore_missing_sub))
+			return;
+
 		d2ffmd * mod{ nullptr };
 		int status = d2ffmdld_Load(ctx.get(), &mod, stringToText(_filepath), FALSE);
 
-		if ((status != D2FS_SUCCESS && status != D2FS_MISSINGLIBMOD && status != D2FS_MISSINGSUBCLMOD)
-			|| (!_ignore_missing_libs && status == D2FS_MISSINGLIBMOD)
-			|| (!_ignore_missing_sub && status == D2FS_MISSINGSUBCLMOD))
+		if (!isAcceptedLoadStatus(status, _ignore_missing_libs, _ignore_missing_sub))
 			throw FAPIException{ Reason::INTERNAL_ERROR, __FILE__, __LINE__, _filepath, status }; // "operation failed", when trying to load, already loaded, module
 
-		auto module = make_unique<FAPIForm>(this, mod, _filepath);
+		auto module = make_unique<FAPIForm>(this, mod, _filepath, status);
 
 		if (_traverse) {
 			status = module->traverseObjects();
 
 			if (status != D2FS_SUCCESS)
 				throw FAPIException{ Reason::INTERNAL_ERROR, __FILE__, __LINE__, "", status };
+
+			saveSnapshot(module.get());
 		}
 
 		modules[toUpper(_filepath)] = move(module);
@@ -135,6 +491,15 @@ namespace CPPFAPIWrapper {
 		if (!fileExists(_filepath))
 			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, _filepath };
 
+		if (!snapshot_dir.empty()) {
+			auto library = make_unique<FAPILibrary>(this, nullptr, _filepath);
+
+			if (ModuleSnapshot::load(*library, ModuleSnapshot::snapshotPath(snapshot_dir, _filepath))) {
+				libs[toUpper(_filepath)] = move(library);
+				return;
+			}
+		}
+
 		d2flib * lib{ nullptr };
 		int status = d2flibld_Load(ctx.get(), &lib, stringToText(_filepath), FALSE);
 
@@ -148,15 +513,98 @@ namespace CPPFAPIWrapper {
 		if (status != D2FS_SUCCESS)
 			throw FAPIException{ Reason::INTERNAL_ERROR, __FILE__, __LINE__, "", status };
 
+		saveSnapshot(library.get());
+
 		libs[toUpper(_filepath)] = move(library);
 	}
 
+	bool FAPIContext::restoreModule(const string & _filepath, const bool _ignore_missing_libs, const bool _ignore_missing_sub) { TRACE_FNC(_filepath)
+		if (snapshot_dir.empty())
+			return false;
+
+		auto module = make_unique<FAPIForm>(this, nullptr, _filepath);
+
+		if (!ModuleSnapshot::load(*module, ModuleSnapshot::snapshotPath(snapshot_dir, _filepath)))
+			return false;
+
+		// same checks as loading by OracleForms, module would be loaded with the same status
+		if (!isAcceptedLoadStatus(module->getLoadStatus(), _ignore_missing_libs, _ignore_missing_sub))
+			throw FAPIException{ Reason::INTERNAL_ERROR, __FILE__, __LINE__, _filepath, module->getLoadStatus() };
+
+		modules[toUpper(_filepath)] = move(module);
+		return true;
+	}
+
+	void FAPIContext::saveSnapshot(const FAPIModule * _module) { TRACE_FNC(_module->getFilepath())
+		if (snapshot_dir.empty())
+			return;
+
+		try {
+			ModuleSnapshot::save(*_module, ModuleSnapshot::snapshotPath(snapshot_dir, _module->getFilepath()));
+		}
+		catch (FAPIException & ex) { FAPILogger::warn(ex.what()); }
+	}
+
+	void FAPIContext::setSnapshotDirectory(const string & _directory) { TRACE_FNC(_directory)
+		snapshot_dir = _directory;
+	}
+
+	string FAPIContext::getSnapshotDirectory() const { TRACE_FNC("")
+		return snapshot_dir;
+	}
+
+	unique_ptr<ModuleImage> FAPIContext::openModuleImage(const string & _filepath, const bool _ignore_missing_libs, const bool _ignore_missing_sub) { TRACE_FNC(_filepath)
+		if (snapshot_dir.empty())
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Snapshot directory is not set" };
+
+		string snapshot_path = ModuleSnapshot::snapshotPath(snapshot_dir, _filepath);
+
+		try {
+			auto image = make_unique<ModuleImage>(snapshot_path);
+
+			if (image->isValid(_filepath))
+				return image;
+		}
+		catch (FAPIException & ex) { FAPILogger::debug(ex.what()); }
+
+		string upper_path = toUpper(_filepath);
+		bool is_library = upper_path.size() > 4 && upper_path.compare(upper_path.size() - 4, 4, ".PLL") == 0;
+		bool loaded = is_library ? hasLibrary(_filepath) : hasModule(_filepath);
+
+		if (loaded) {
+			FAPIModule * module = is_library ? static_cast<FAPIModule *>(getLibrary(_filepath)) : getModule(_filepath);
+
+			if (!module->isTraversed())
+				module->traverseObjects();
+
+			ModuleSnapshot::save(*module, snapshot_path);
+		}
+		else if (is_library) {
+			loadLibrary(_filepath);
+			removeLibrary(_filepath);
+		}
+		else {
+			loadModule(_filepath, _ignore_missing_libs, _ignore_missing_sub);
+			removeModule(_filepath);
+		}
+
+		// loading only warns when snapshot can't be replaced, so old one may still be there
+		auto image = make_unique<ModuleImage>(snapshot_path);
+
+		if (!image->isValid(_filepath))
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Snapshot couldn't be refreshed, it may be mapped by another image: " + snapshot_path };
+
+		return image;
+	}
+
 	FAPIForm * FAPIContext::getModule(const string & _filepath) { TRACE_FNC(_filepath)
-		return Expected<FAPIForm>{ modules[toUpper(_filepath)].get() }.get();
+		auto module = modules.find(toUpper(_filepath));
+		return Expected<FAPIForm>{ module != modules.end() ? module->second.get() : nullptr }.get();
 	}
 
 	FAPILibrary * FAPIContext::getLibrary(const string & _filepath) { TRACE_FNC(_filepath)
-		return Expected<FAPILibrary>{ libs[toUpper(_filepath)].get() }.get();
+		auto library = libs.find(toUpper(_filepath));
+		return Expected<FAPILibrary>{ library != libs.end() ? library->second.get() : nullptr }.get();
 	}
 
 	bool FAPIContext::hasModule(const string & _filepath) { TRACE_FNC(_filepath)
@@ -185,7 +633,80 @@ namespace CPPFAPIWrapper {
 	}
 
 	void FAPIContext::removeLibrary(const string & _filepath) { TRACE_FNC(_filepath)
-		libs.erase(toUpper(_filepath));
+		auto share = lib_shares.find(toUpper(_filepath));
+
+		if (share != lib_shares.end()) {
+			FAPILogger::debug("Library still shared, removed after release: " + _filepath);
+			share->second.unload = true;
+			return;
+		}
+
+		// destroyed library releases libraries it acquired, so it is taken out of libs first
+		libs.extract(toUpper(_filepath));
+	}
+
+	FAPILibrary * FAPIContext::acquireLibrary(const string & _filepath) { TRACE_FNC(_filepath)
+		auto share = lib_shares.find(toUpper(_filepath));
+
+		if (share == lib_shares.end()) {
+			bool loaded = hasLibrary(_filepath);
+
+			if (!loaded)
+				loadLibrary(_filepath);
+
+			share = lib_shares.emplace(toUpper(_filepath), LibraryShare{ 0, !loaded }).first;
+		}
+
+		++share->second.references;
+		return getLibrary(_filepath);
+	}
+
+	void FAPIContext::releaseLibrary(const string & _filepath) { TRACE_FNC(_filepath)
+		auto share = lib_shares.find(toUpper(_filepath));
+
+		if (share == lib_shares.end() || --share->second.references > 0)
+			return;
+
+		bool unload = share->second.unload;
+		lib_shares.erase(share);
+
+		// destroyed library releases libraries it acquired, so it is taken out of libs first
+		if (unload)
+			libs.extract(toUpper(_filepath));
+	}
+
+	size_t FAPIContext::getLibraryReferences(const string & _filepath) const { TRACE_FNC(_filepath)
+		auto share = lib_shares.find(toUpper(_filepath));
+		return share != lib_shares.end() ? share->second.references : 0;
+	}
+
+	void FAPIContext::reset() { TRACE_FNC("")
+		TaskExecutor * pending{ nullptr };
+
+		{
+			lock_guard<mutex> lock{ worker_mutex };
+			pending = worker.get();
+		}
+
+		// asynchronous operations queued before still use modules, unless reset is one of them
+		if (pending && !pending->isExecutorThread())
+			pending->submit([]() {}).get();
+
+		// forms first, since they may have libraries attached
+		modules.clear();
+		// libraries release their attached libraries when destroyed, without shares they don't touch libs any more
+		lib_shares.clear();
+		auto removed = move(libs);
+		libs.clear();
+		removed.clear();
+
+		{
+			lock_guard<mutex> lock{ matcher_mutex };
+			builtins_matcher = nullptr;
+		}
+
+		// module files might have been added or moved before the next job
+		getModulePathResolver().invalidate();
 	}
 
 	bool FAPIContext::connectContextToDB(const string & _connstring) { TRACE_FNC(_connstring)
@@ -2,17 +2,20 @@
 
 #include <algorithm>
 #include <fstream>
-#include <regex>
 
 #include "Property.h"
 #include "FAPIWrapper.h"
 #include "FAPIContext.h"
 #include "FormsObject.h"
 #include "FAPIUtil.h"
+#include "InheritanceCache.h"
+#include "InheritanceReport.h"
 
 #include "d2ffmd.h"
 #include "d2fob.h"
 #include "d2falb.h"
+#include "d2ftrg.h"
+#include "d2fpgu.h"
 
 #include "Exceptions.h"
 #include "FAPILogger.h"
@@ -20,8 +23,9 @@
 namespace CPPFAPIWrapper {
 	using namespace std;
 
-	FAPIForm::FAPIForm(FAPIContext * _ctx, void * _mod, const string & _filepath)
+	FAPIForm::FAPIForm(FAPIContext * _ctx, void * _mod, const string & _filepath, const int _load_status)
 		: FAPIModule(_ctx, _filepath) { TRACE_FNC(_filepath)
+		load_status = _load_status;
 		auto deleter = [this](const void * data) { d2ffmdde_Destroy(this->ctx->getContext(), const_cast<void *>(data)); };
 		mod = unique_ptr<void, function<void(const void*)>>{ _mod, deleter };
 	}
@@ -46,27 +50,13 @@ namespace CPPFAPIWrapper {
 	}
 
 	void FAPIForm::findGlobals() { TRACE_FNC("")
-		globals.clear();
-
-		auto triggers = getTriggers();
+		auto units = getTriggers();
 		auto prog_units = getProgramUnits();
-		regex pattern{ "global.[A-Za-z0-9_!@#$%^&*()]+", regex_constants::icase };
-		smatch match;
-
-		for (const auto & trg : triggers) {
-			string code = trg->getProperties().at(D2FP_TRG_TXT)->getValue();
-			regex_search(code, match, pattern);
-			transform(match.begin(), match.end(), inserter(globals, globals.begin()), [](const auto & _val) { return _val.str().substr(GLOBAL_OFFSET); });
-		}
+		units.insert(units.end(), prog_units.begin(), prog_units.end());
 
-		for (const auto & pgu : prog_units) {
-			string code = pgu->getProperties().at(D2FP_PGU_TXT)->getValue();
-			regex_search(code, match, pattern);
-			transform(match.begin(), match.end(), inserter(globals, globals.begin()), [](const auto & _val) { return _val.str().substr(GLOBAL_OFFSET); });
-		}
+		collectGlobals(units);
 	}
 
-
 	void FAPIForm::inheritAllProp() { TRACE_FNC("")
 		for (const auto & obj : getAllObjects())
 			obj->inheritAllProp();
@@ -104,26 +94,114 @@ namespace CPPFAPIWrapper {
 		}
 	}
 
-	string FAPIForm::createObjectReportFile(const string & _filepath) { TRACE_FNC(_filepath)
-		string out_file = (_filepath != "" ? _filepath.substr(0, _filepath.rfind(".")) : filepath.substr(0, filepath.rfind("."))) + ".txt";
-		string cmd = "ifcmp60.exe module=\"" + filepath + "\" output_file=\"" + out_file + "\" forms_doc=YES window_state=minimize"; // TODO
+	void FAPIForm::checkOverriden() { TRACE_FNC("")
+		for (const auto & fo : getAllObjects()) {
+			if (!fo->isSubclassed())
+				continue;
+
+			auto sources = fo->findSources();
+
+			for (const auto & entry : fo->getProperties())
+				entry.second->checkState(sources);
+		}
+	}
+
+	size_t FAPIForm::checkOverriden(InheritanceCache & _cache) { TRACE_FNC("")
+		bool full_check = !_cache.isValid(filepath);
+		auto changed = full_check ? unordered_set<string>{} : _cache.getChangedSources(filepath);
+		ModuleCheck previous = full_check ? ModuleCheck{} : _cache.getModule(filepath);
+		ModuleCheck current;
+		current.fingerprint = fileFingerprint(filepath);
+		string name = getName();
+		size_t rechecked{ 0 };
+
+		for (const auto & fo : getAllObjects()) {
+			if (!fo->isSubclassed())
+				continue;
+
+			string key = to_string(fo->getId()) + ":" + fo->getFullName();
+			auto & properties = fo->getProperties();
+			auto prev = previous.objects.find(key);
+			ObjectCheck check;
+
+			if (prev != previous.objects.end() && none_of(prev->second.source_modules.begin(), prev->second.source_modules.end(), [&changed](const auto & _mod) { return changed.find(_mod) != changed.end(); })) {
+				check = prev->second;
+
+				for (const auto & result : check.results)
+					if (properties.find(result.first) != properties.end())
+						properties[result.first]->restoreState(result.second);
+
+				for (const auto & source_mod : check.source_modules)
+					current.sources[source_mod] = previous.sources[source_mod];
+			}
+			else {
+				auto sources = fo->findSources();
+				++rechecked;
+
+				for (const auto & source : sources) {
+					auto source_module = source->getModule();
+					string source_name = source_module->getName();
+
+					if (source_name == name || find(check.source_modules.begin(), check.source_modules.end(), source_name) != check.source_modules.end())
+						continue;
 
-		if (ctx->getConnstring() != "")
-			cmd += " userid=" + ctx->getConnstring();
+					check.source_modules.emplace_back(source_name);
 
-		FAPILogger::debug("out_file=" + out_file + " cmd=" + cmd);
-		system(cmd.c_str());
+					if (current.sources.find(source_name) == current.sources.end())
+						current.sources[source_name] = SourceCheck{ source_module->getFilepath(), fileFingerprint(source_module->getFilepath()) };
+				}
+
+				for (const auto & entry : properties) {
+					PropState before = entry.second->getState();
+					PropState result = entry.second->checkState(sources);
+
+					if (result != before)
+						check.results.emplace_back(entry.first, result);
+				}
+			}
+
+			current.objects[key] = move(check);
+		}
 
-		if (!fileExists(out_file))
-			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, filepath + "_" + out_file };
+		FAPILogger::debug(filepath + ": rechecked " + to_string(rechecked) + " objects");
+		_cache.getModule(filepath) = move(current);
 
-		return out_file;
+		return rechecked;
 	}
 
-	void FAPIForm::checkOverriden() { TRACE_FNC("")
-		for (const auto & fo : getAllObjects())
-			for (const auto & entry : fo->getProperties())
-				entry.second->checkState();
+	size_t FAPIForm::reportOverriden(InheritanceSink & _sink) { TRACE_FNC("")
+		size_t records{ 0 };
+
+		for (const auto & fo : getAllObjects()) {
+			if (!fo->isSubclassed())
+				continue;
+
+			auto & properties = fo->getProperties();
+			vector<int> prop_ids;
+
+			for (const auto & entry : properties)
+				if (entry.second->needsCheck())
+					prop_ids.emplace_back(entry.first);
+
+			if (prop_ids.empty())
+				continue;
+
+			sort(prop_ids.begin(), prop_ids.end());
+			auto sources = fo->findSources();
+			string fullname = fo->getFullName();
+
+			for (int prop_id : prop_ids) {
+				const auto & property = properties[prop_id];
+				string source_value;
+				PropState state = property->inspectState(sources, source_value);
+
+				_sink.write(InheritanceRecord{ filepath, fo->getId(), fullname, prop_id, property->getValue(), source_value, state });
+				++records;
+			}
+		}
+
+		_sink.flush();
+		return records;
 	}
 
 	void FAPIForm::attachLib(const string & _lib_name) { TRACE_FNC(_lib_name)
@@ -133,12 +211,13 @@ namespace CPPFAPIWrapper {
 		}
 
 		d2falb *ppd2falb{ nullptr };
-		int status = d2falbat_Attach(ctx->getContext(), mod.get(), &ppd2falb, FALSE, stringToText(_lib_name));
+		int status = d2falbat_Attach(ctx->getContext(), getModule(), &ppd2falb, FALSE, stringToText(_lib_name));
 
 		if (status != D2FS_SUCCESS)
 			throw FAPIException{ Reason::INTERNAL_ERROR, __FILE__, __LINE__, _lib_name, status };
 
 		root->addChild(new FormsObject{ this, D2FFO_ATT_LIB, ppd2falb, 1 });
+		markModified();
 	}
 
 	void FAPIForm::detachLib(const string & _lib_name) { TRACE_FNC(_lib_name)
@@ -157,54 +236,199 @@ namespace CPPFAPIWrapper {
 				throw FAPIException(Reason::INTERNAL_ERROR, __FILE__, __LINE__, _lib_name, status);
 
 			detached = true;
+			markModified();
 			root->removeChild(exp_lib.get());
 			exp_lib = root->getObject(D2FFO_ATT_LIB, _lib_name);
 		}
 	}
 
-	void FAPIForm::saveModule(const string & _path) { TRACE_FNC(_path)
+	// d2ffmdsv_Save writes .fmb module, so temporary file keeps its extension
+	string temporarySavePath(const string & _path) {
+		size_t separator = _path.find_last_of("\\/");
+		size_t extension = _path.rfind('.');
+
+		if (extension == string::npos || (separator != string::npos && extension < separator))
+			return _path + "_tmp";
+
+		return _path.substr(0, extension) + "_tmp" + _path.substr(extension);
+	}
+
+	bool FAPIForm::saveModule(const string & _path, const bool _keep_identical) { TRACE_FNC(_path + " | " + to_string(_keep_identical))
 		string path { _path == "" ? filepath : _path };
+		bool own_file = toUpper(path) == toUpper(filepath);
+
+		if (own_file && !isModified() && fileExists(path)) {
+			FAPILogger::debug("Module not modified, save skipped: " + path);
+			return false;
+		}
 
 		FAPILogger::debug(path);
 
-		for (const auto & marked_obj : marked_objects) {
-			auto & marked_properties = marked_obj->getMarkedProperties();
+		// applied properties keep module modified until its own file is written
+		applyMarkedObjects();
+		bool compare = _keep_identical && fileExists(path);
+		string save_path = compare ? temporarySavePath(path) : path;
+		int status = d2ffmdsv_Save(ctx->getContext(), getModule(), stringToText(save_path), FALSE);
 
-			for (const auto & marked_prop : marked_properties)
-				marked_obj->setProperty(marked_prop);
+		if (status != D2FS_SUCCESS) {
+			if (compare)
+				remove(save_path.c_str());
 
-			marked_properties.clear();
+			throw FAPIException{ Reason::INTERNAL_ERROR, __FILE__, __LINE__, save_path, status };
 		}
 
-		marked_objects.clear();
-		int status = d2ffmdsv_Save(ctx->getContext(), mod.get(), stringToText(path), FALSE);
+		bool written{ true };
 
-		if (status != D2FS_SUCCESS)
-			throw FAPIException{ Reason::INTERNAL_ERROR, __FILE__, __LINE__, path, status };
+		if (compare) {
+			FileFingerprint saved = fileFingerprint(save_path);
+			FileFingerprint existing = fileFingerprint(path);
+
+			if (saved.size == existing.size && saved.hash == existing.hash) {
+				FAPILogger::debug("Saved module is identical, file kept: " + path);
+				remove(save_path.c_str());
+				written = false;
+			}
+			// original module is kept if it can't be replaced
+			else if (!replaceFile(save_path, path)) {
+				remove(save_path.c_str());
+				throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Couldn't replace " + path + " with " + save_path };
+			}
+		}
+
+		// module's own file is still outdated if saved elsewhere
+		if (own_file)
+			modified = false;
+
+		return written;
+	}
+
+	// triggers and program units, program units first
+	vector<FormsObject *> findCompileUnits(const vector<FormsObject *> & _objects) {
+		vector<FormsObject *> units;
+
+		for (const auto & fo : _objects)
+			if (fo->getId() == D2FFO_PROG_UNIT)
+				units.emplace_back(fo);
+
+		for (const auto & fo : _objects)
+			if (fo->getId() == D2FFO_TRIGGER)
+				units.emplace_back(fo);
+
+		return units;
+	}
+
+	uint64_t compileUnitHash(FormsObject * _unit) {
+		auto & properties = _unit->getProperties();
+		auto text = properties.find(_unit->getId() == D2FFO_TRIGGER ? D2FP_TRG_TXT : D2FP_PGU_TXT);
+		string code = text != properties.end() ? text->second->getValue() : "";
+
+		return hashBytes(code.data(), code.size());
+	}
+
+	string compileUnitKey(FormsObject * _unit) {
+		return to_string(_unit->getId()) + ":" + _unit->getFullName();
 	}
 
 	void FAPIForm::compileModule() { TRACE_FNC("")
-		int status = d2ffmdco_CompileObj(ctx->getContext(), mod.get());
+		applyMarkedObjects();
+		int status = d2ffmdco_CompileObj(ctx->getContext(), getModule());
 
 		if (status != D2FS_SUCCESS)
 			throw FAPIException{ Reason::INTERNAL_ERROR, __FILE__, __LINE__, "", status };
+
+		// compiled code is saved with the module
+		modified = true;
+		compiled_units.clear();
+
+		for (const auto & unit : findCompileUnits(getAllObjects()))
+			compiled_units[compileUnitKey(unit)] = compileUnitHash(unit);
+	}
+
+	vector<UnitCompileResult> FAPIForm::compileUnits(const bool _force) { TRACE_FNC(to_string(_force))
+		auto units = findCompileUnits(getAllObjects());
+		vector<string> keys;
+		vector<uint64_t> hashes;
+		bool compile_all{ _force };
+
+		keys.reserve(units.size());
+		hashes.reserve(units.size());
+
+		for (const auto & unit : units) {
+			keys.emplace_back(compileUnitKey(unit));
+			hashes.emplace_back(compileUnitHash(unit));
+
+			if (unit->getId() != D2FFO_PROG_UNIT)
+				continue;
+
+			auto compiled = compiled_units.find(keys.back());
+			compile_all = compile_all || compiled == compiled_units.end() || compiled->second != hashes.back();
+		}
+
+		vector<UnitCompileResult> results;
+		results.reserve(units.size());
+		size_t compiled_count{ 0 };
+
+		for (size_t i = 0; i < units.size(); ++i) {
+			FormsObject * unit = units[i];
+			string fullname = keys[i].substr(keys[i].find(':') + 1);
+			auto compiled = compiled_units.find(keys[i]);
+
+			if (!compile_all && compiled != compiled_units.end() && compiled->second == hashes[i]) {
+				results.emplace_back(UnitCompileResult{ unit->getId(), fullname, D2FS_SUCCESS, "", false });
+				continue;
+			}
+
+			// new text has to be set before compilation
+			if (!unit->getMarkedProperties().empty())
+				unit->applyMarkedProperties();
+
+			int status = unit->getId() == D2FFO_TRIGGER
+				? d2ftrgco_CompileObj(ctx->getContext(), static_cast<d2ftrg *>(unit->getFormsObj()))
+				: d2fpguco_CompileObj(ctx->getContext(), static_cast<d2fpgu *>(unit->getFormsObj()));
+
+			if (status == D2FS_SUCCESS) {
+				compiled_units[keys[i]] = hashes[i];
+				modified = true;
+			}
+			else
+				compiled_units.erase(keys[i]);
+
+			string message = status == D2FS_SUCCESS ? "" : (static_cast<size_t>(status) < errors.size() ? errors[status] : to_string(status));
+			results.emplace_back(UnitCompileResult{ unit->getId(), fullname, status, message, true });
+			++compiled_count;
+		}
+
+		FAPILogger::debug(filepath + ": " + to_string(compiled_count) + " of " + to_string(units.size()) + " units compiled");
+		return results;
 	}
 
 	bool FAPIForm::isCompiling() noexcept { TRACE_FNC("")
 		try {
-			compileModule();
-			return true;
+			auto results = compileUnits();
+			return all_of(results.begin(), results.end(), [](const UnitCompileResult & _result) { return _result.status == D2FS_SUCCESS; });
 		} catch (exception &) { return false; }
 	}
 
 	void FAPIForm::generateModule() { TRACE_FNC("")
-		int status = d2ffmdcf_CompileFile(ctx->getContext(), mod.get());
+		int status = d2ffmdcf_CompileFile(ctx->getContext(), getModule());
 
 		if (status != D2FS_SUCCESS)
 			throw FAPIException{ Reason::INTERNAL_ERROR, __FILE__, __LINE__, "", status };
 	}
 
 	void * FAPIForm::getModule() const { TRACE_FNC("")
+		attachNative();
 		return mod.get();
 	}
+
+	void * FAPIForm::loadNative() const { TRACE_FNC(filepath)
+		d2ffmd * mod_{ nullptr };
+		int status = d2ffmdld_Load(ctx->getContext(), &mod_, stringToText(filepath), FALSE);
+
+		// missing libraries or subobjects are accepted only if they were accepted when module was loaded
+		if (status != D2FS_SUCCESS && status != load_status)
+			throw FAPIException{ Reason::INTERNAL_ERROR, __FILE__, __LINE__, filepath, status };
+
+		return mod_;
+	}
 }
@@ -8,7 +8,6 @@
 #include "FAPIUtil.h"
 #include "D2FLIB.H"
 
-#include <regex>
 
 
 namespace CPPFAPIWrapper {
@@ -22,22 +21,6 @@ namespace CPPFAPIWrapper {
 
 	FAPILibrary::~FAPILibrary() { TRACE_FNC("") }
 
-	string FAPILibrary::createObjectReportFile(const string & _filepath) { TRACE_FNC(_filepath)
-		string out_file = (_filepath != "" ? _filepath.substr(0, _filepath.rfind(".")) : filepath.substr(0, filepath.rfind("."))) + ".txt";
-		string cmd = "ifcmp60.exe module=\"" + filepath + "\" output_file=\"" + out_file + "\" forms_doc=YES window_state=minimize module_type=LIBRARY"; // TODO
-
-		if (ctx->getConnstring() != "")
-			cmd += " userid=" + ctx->getConnstring();
-
-		FAPILogger::debug("out_file=" + out_file + " cmd=" + cmd);
-		system(cmd.c_str());
-
-		if (!fileExists(out_file))
-			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, filepath + "_" + out_file };
-
-		return out_file;
-	}
-
 	vector<FormsObject *> FAPILibrary::getAllObjects() const {
 		vector<FormsObject *> objects;
 		auto & children = root->getChildren().at(D2FFO_LIB_PROG_UNIT);
@@ -47,20 +30,21 @@ namespace CPPFAPIWrapper {
 	}
 
 	void FAPILibrary::findGlobals() { TRACE_FNC("")
-		globals.clear();
-
-		auto prog_units = getAllObjects();
-		regex pattern{ "global.[A-Za-z0-9_!@#$%^&*()]+", regex_constants::icase };
-		smatch match;
-
-		for (const auto & pgu : prog_units) {
-			string code = pgu->getProperties().at(D2FP_PGU_TXT)->getValue();
-			regex_search(code, match, pattern);
-			transform(match.begin(), match.end(), inserter(globals, globals.begin()), [](const auto & _val) { return _val.str().substr(GLOBAL_OFFSET); });
-		}
+		collectGlobals(getAllObjects());
 	}
 
 	void * FAPILibrary::getModule() const { TRACE_FNC("")
+		attachNative();
 		return mod.get();
 	}
+
+	void * FAPILibrary::loadNative() const { TRACE_FNC(filepath)
+		d2flib * mod_{ nullptr };
+		int status = d2flibld_Load(ctx->getContext(), &mod_, stringToText(filepath), FALSE);
+
+		if (status != D2FS_SUCCESS)
+			throw FAPIException{ Reason::INTERNAL_ERROR, __FILE__, __LINE__, filepath, status };
+
+		return mod_;
+	}
 }
\ No newline at end of file
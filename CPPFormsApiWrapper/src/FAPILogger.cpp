@@ -13,6 +13,7 @@ namespace CPPFAPIWrapper {
 	bool FAPILogger::is_enabled{ true };
 	easylogger::LogLevel FAPILogger::level{ easylogger::LEVEL_WARNING };
 	easylogger::Logger FAPILogger::logger = easylogger::Logger{ "CPPFapiLogger" };
+	std::recursive_mutex FAPILogger::log_mutex;
 
 	std::string FAPILogger::getTimestamp() {
 		return date::format("[%F %T] ", time_point_cast<milliseconds>(system_clock::now()));
@@ -20,6 +21,7 @@ namespace CPPFAPIWrapper {
 
 	void FAPILogger::trace(const std::string & _str) {
 		if (is_enabled) {
+			std::lock_guard<std::recursive_mutex> lock{ log_mutex };
 			LOG_TRACE(logger, getTimestamp() + _str);
 			flush();
 		}
@@ -37,8 +39,20 @@ namespace CPPFAPIWrapper {
 		return level;
 	}
 
+	bool FAPILogger::isTracing() {
+		return is_enabled && level <= easylogger::LEVEL_TRACE;
+	}
+
+	std::string FAPILogger::traceLocation(const char * _file, const char * _function, const int _line) {
+		std::string file{ _file };
+		size_t separator = file.find_last_of("/\\");
+
+		return (separator == std::string::npos ? file : file.substr(separator)) + " (" + _function + " " + std::to_string(_line) + "): ";
+	}
+
 	void FAPILogger::debug(const std::string & _str) {
 		if (is_enabled) {
+			std::lock_guard<std::recursive_mutex> lock{ log_mutex };
 			LOG_DEBUG(logger, getTimestamp() + _str);
 			flush();
 		}
@@ -46,6 +60,7 @@ namespace CPPFAPIWrapper {
 
 	void FAPILogger::info(const std::string & _str) {
 		if (is_enabled) {
+			std::lock_guard<std::recursive_mutex> lock{ log_mutex };
 			LOG_INFO(logger, getTimestamp() + _str);
 			flush();
 		}
@@ -53,6 +68,7 @@ namespace CPPFAPIWrapper {
 
 	void FAPILogger::warn(const std::string & _str) {
 		if (is_enabled) {
+			std::lock_guard<std::recursive_mutex> lock{ log_mutex };
 			LOG_WARNING(logger, getTimestamp() + _str);
 			flush();
 		}
@@ -60,6 +76,7 @@ namespace CPPFAPIWrapper {
 
 	void FAPILogger::error(const std::string & _str) {
 		if (is_enabled) {
+			std::lock_guard<std::recursive_mutex> lock{ log_mutex };
 			LOG_ERROR(logger, getTimestamp() + _str);
 			flush();
 		}
@@ -67,12 +84,14 @@ namespace CPPFAPIWrapper {
 
 	void FAPILogger::fatal(const std::string & _str) {
 		if (is_enabled) {
+			std::lock_guard<std::recursive_mutex> lock{ log_mutex };
 			LOG_FATAL(logger, getTimestamp() + _str);
 			flush();
 		}
 	}
 
 	void FAPILogger::changePath(const std::string & _logpath) {
+		std::lock_guard<std::recursive_mutex> lock{ log_mutex };
 		filepath = _logpath;
 		stream = std::ofstream{ filepath };
 	}
@@ -1,25 +1,46 @@
 #include "FAPIModule.h"
 
 #include "FAPIContext.h"
+#include "FAPILibrary.h"
 #include "FAPILogger.h"
 #include "Property.h"
 #include "FormsObject.h"
 
 #include "FAPIUtil.h"
+#include "ObjectReport.h"
 
 #include "d2fpr.h"
 
 namespace CPPFAPIWrapper {
 	using namespace std;
 
+	const vector<int> & objectProperties(d2fctx * _ctx) {
+		static vector<int> object_properties;
+
+		if (object_properties.empty())
+			for (int prop_num = D2FP_MIN + 1; prop_num < D2FP_MAX + 1; ++prop_num)
+				if (d2fprgt_GetType(_ctx, prop_num) == D2FP_TYP_OBJECT && !isIrrelevantProperty(prop_num))
+					object_properties.emplace_back(prop_num);
+
+		return object_properties;
+	}
+
 	FAPIModule::FAPIModule(FAPIContext * _ctx, const std::string & _filepath) 
-		: ctx(_ctx), filepath(_filepath)	{ TRACE_FNC(_filepath) }
-	FAPIModule::~FAPIModule() { TRACE_FNC(""); }
+		: ctx(_ctx), filepath(_filepath), dependencies_known(false), globals_found(false), modified(false), load_status(D2FS_SUCCESS), libraries_resolved(false)	{ TRACE_FNC(_filepath) }
+	FAPIModule::~FAPIModule() { TRACE_FNC("");
+		releaseLibraries();
+
+		// marked objects are destroyed with object tree, after marked_objects
+		for (auto forms_object : marked_objects)
+			forms_object->mark_index = Property::NOT_MARKED;
+
+		marked_objects.clear();
+	}
 
 	bool FAPIModule::hasInternalObject(const int _type_id, const string & _fullname) const { TRACE_FNC(to_string(_type_id) + " | " + _fullname)
 		auto splits = splitString(_fullname, ".");
 		d2fob * obj{ nullptr };
-		unordered_map<d2fob *, vector<d2fob *>> objects{ { mod.get(), {} } };
+		unordered_map<d2fob *, vector<d2fob *>> objects{ { static_cast<d2fob *>(getModule()), {} } };
 
 
 		for (const auto & split : splits) {
@@ -62,16 +83,123 @@ namespace CPPFAPIWrapper {
 		return obj;
 	}
 
+	BulkUpdateResult FAPIModule::updateProperty(const int _type_id, const int _prop_id, function<bool(FormsObject *)> _predicate, function<string(FormsObject *, const string &)> _transform) { TRACE_FNC(to_string(_type_id) + " | " + to_string(_prop_id))
+		BulkUpdateResult result{ 0, 0 };
+		vector<pair<Property *, string>> updates;
+		vector<FormsObject *> to_process;
+
+		if (root)
+			to_process.emplace_back(root.get());
+
+		while (!to_process.empty()) {
+			FormsObject * object = to_process.back();
+			to_process.pop_back();
+
+			for (const auto & entry : object->getChildren())
+				for (const auto & child : entry.second)
+					to_process.emplace_back(child.get());
+
+			if (_type_id != D2FFO_ANY && object->getId() != _type_id)
+				continue;
+
+			auto & properties = object->getProperties();
+			auto property = properties.find(_prop_id);
+
+			if (property == properties.end() || (_predicate && !_predicate(object)))
+				continue;
+
+			++result.matched;
+			string value = _transform(object, property->second->getValue());
+
+			if (value != property->second->getValue())
+				updates.emplace_back(property->second.get(), move(value));
+		}
+
+		for (auto & update : updates)
+			update.first->setValue(update.second);
+
+		result.changed = updates.size();
+		return result;
+	}
+
+	BulkUpdateResult FAPIModule::updateProperty(const int _type_id, const int _prop_id, function<bool(FormsObject *)> _predicate, const string & _value) { TRACE_FNC(to_string(_type_id) + " | " + to_string(_prop_id) + " | " + _value)
+		return updateProperty(_type_id, _prop_id, _predicate, [&_value](FormsObject *, const string &) { return _value; });
+	}
+
 	void FAPIModule::markObject(FormsObject * _forms_object) { TRACE_FNC("")
-		if (find(marked_objects.begin(), marked_objects.end(), _forms_object) == marked_objects.end())
-			marked_objects.emplace_back(_forms_object);
+		if (_forms_object->mark_index != Property::NOT_MARKED)
+			return;
+
+		_forms_object->mark_index = marked_objects.size();
+		marked_objects.emplace_back(_forms_object);
 	}
 
 	void FAPIModule::unmarkObject(FormsObject * _forms_object) { TRACE_FNC("")
-		auto idx = find(marked_objects.begin(), marked_objects.end(), _forms_object);
+		size_t index = _forms_object->mark_index;
+
+		if (index == Property::NOT_MARKED)
+			return;
+
+		marked_objects[index] = marked_objects.back();
+		marked_objects[index]->mark_index = index;
+		marked_objects.pop_back();
+		_forms_object->mark_index = Property::NOT_MARKED;
+	}
+
+	string FAPIModule::createObjectReportFile(const string & _filepath) { TRACE_FNC(_filepath)
+		string out_file = objectReportPath(filepath, _filepath);
+		FAPILogger::debug("out_file=" + out_file);
+		writeObjectReportFile(*this, out_file);
+
+		return out_file;
+	}
+
+	void FAPIModule::collectGlobals(const vector<FormsObject *> & _units) { TRACE_FNC(to_string(_units.size()))
+		globals.clear();
+		global_references.clear();
+		globals_found = true;
+
+		vector<GlobalReference> references;
+
+		for (const auto & unit : _units) {
+			auto & properties = unit->getProperties();
+			auto code = properties.find(unit->getId() == D2FFO_TRIGGER ? D2FP_TRG_TXT : D2FP_PGU_TXT);
+
+			if (code == properties.end())
+				continue;
+
+			references.clear();
+			scanGlobals(code->second->getValue(), unit->getTokens(), references);
+
+			for (auto & reference : references) {
+				globals.insert(reference.name);
+				global_references.emplace_back(GlobalUsage{ unit, move(reference) });
+			}
+		}
+	}
+
+	void FAPIModule::applyMarkedObjects() { TRACE_FNC(to_string(marked_objects.size()))
+		size_t applied{ 0 };
+
+		try {
+			for (; applied < marked_objects.size(); ++applied) {
+				marked_objects[applied]->applyMarkedProperties();
+				marked_objects[applied]->mark_index = Property::NOT_MARKED;
+			}
+		}
+		catch (...) {
+			// objects applied before failure changed OracleForms module already
+			modified = modified || applied > 0;
+			marked_objects.erase(marked_objects.begin(), marked_objects.begin() + applied);
+
+			for (size_t i = 0; i < marked_objects.size(); ++i)
+				marked_objects[i]->mark_index = i;
+
+			throw;
+		}
 
-		if (idx != marked_objects.end())
-			marked_objects.erase(idx);
+		modified = modified || applied > 0;
+		marked_objects.clear();
 	}
 
 	bool FAPIModule::hasObject(const int _type_id, const string & _name) const { TRACE_FNC(to_string(_type_id) + " | " + _name)
@@ -79,44 +207,53 @@ namespace CPPFAPIWrapper {
 	}
 
 	Expected<FormsObject> FAPIModule::getObject(const int _type_id, const string & _fullname) const { TRACE_FNC(to_string(_type_id) + " | " + _fullname)
-		auto splits = splitString(_fullname, ".");
-		vector<FormsObject *> to_process{ root.get() };
-		string name{ *splits.end() };
-
-		for (const auto & split : splits) {
-			FAPILogger::debug(split);
+		// names are unique only per type, so every object named like a path segment is a candidate parent
+		vector<FormsObject *> candidates;
+		size_t begin{ 0 };
 
-			vector<FormsObject *> new_process;
+		if (root)
+			candidates.emplace_back(root.get());
 
-			while (!to_process.empty()) {
-				auto curr{ to_process[0] }; to_process.erase(to_process.begin());
-				auto & children_types{ type_hierarchy[curr->getId()] };
+		while (!candidates.empty()) {
+			size_t end = _fullname.find('.', begin);
+			string name = toUpper(_fullname.substr(begin, end == string::npos ? string::npos : end - begin));
 
-				for (const auto & type : children_types) {
-					try {
-						auto child = curr->getObject(type, split).get();
+			if (end == string::npos) {
+				for (auto candidate : candidates) {
+					auto child = candidate->getObject(_type_id, name);
 
-						if (child->getId() == _type_id && child->getName() == name)
-							return Expected<FormsObject>(child);
-						else
-							new_process.emplace_back(child);
-					}
-					catch (exception & ex) { FAPILogger::warn(ex.what()); }
+					if (child.isValid())
+						return child;
 				}
+
+				break;
 			}
 
-			to_process.insert(to_process.end(), new_process.begin(), new_process.end());
+			vector<FormsObject *> next;
+
+			for (auto candidate : candidates)
+				for (const auto & entry : candidate->getChildren())
+					for (const auto & child : entry.second)
+						if (toUpper(child->getName()) == name)
+							next.emplace_back(child.get());
+
+			candidates.swap(next);
+			begin = end + 1;
 		}
 
 		return Expected<FormsObject>(nullptr);
 	}
 
 	int FAPIModule::traverseObjects(d2fob * _obj, int _level, FormsObject * _forms_object) { TRACE_FNC("")
-		if (root && _level == 0)
+		if (_level == 0) {
 			root = nullptr;
+			source_modules.clear();
+			library_modules.clear();
+			library_order.clear();
+		}
 
 		if (!_obj)
-			_obj = mod.get();
+			_obj = static_cast<d2fob *>(getModule());
 
 		d2fctx * ctx = this->ctx->getContext();
 		d2fob * v_subobj, *v_owner;
@@ -150,6 +287,13 @@ namespace CPPFAPIWrapper {
 		if (!root)
 			root = unique_ptr<FormsObject>{ fo };
 
+		if (v_obj_typ == D2FFO_ATT_LIB) {
+			text * v_lib_name{ nullptr };
+
+			if (d2fobg_name(ctx, _obj, &v_lib_name) == D2FS_SUCCESS && v_lib_name)
+				addLibraryModule(truncModuleName(reinterpret_cast<char *>(v_lib_name)));
+		}
+
 		vector<int> object_properties;
 
 		/*
@@ -228,9 +372,160 @@ namespace CPPFAPIWrapper {
 		if (_forms_object)
 			_forms_object->addChild(fo);
 
+		if (_level == 0)
+			dependencies_known = true;
+
+		return D2FS_SUCCESS;
+	}
+
+	int FAPIModule::scanDependencies(d2fob * _obj) { TRACE_FNC("")
+		if (dependencies_known)
+			return D2FS_SUCCESS;
+
+		bool is_root = !_obj;
+
+		if (is_root)
+			_obj = static_cast<d2fob *>(getModule());
+
+		d2fctx * ctx = this->ctx->getContext();
+		const auto & object_properties = objectProperties(ctx);
+
+		d2fob * v_subobj, *v_owner;
+		d2fotyp v_obj_typ;
+		int status = d2fobqt_QueryType(ctx, _obj, &v_obj_typ);
+
+		if (status != D2FS_SUCCESS)
+			return status;
+
+		if (v_obj_typ > D2FFO_MAX || d2fobhp_HasProp(ctx, _obj, D2FP_NAME) != D2FS_YES)
+			return D2FS_SUCCESS;
+
+		if (v_obj_typ == D2FFO_ATT_LIB) {
+			text * v_lib_name{ nullptr };
+
+			if (d2fobg_name(ctx, _obj, &v_lib_name) == D2FS_SUCCESS && v_lib_name)
+				addLibraryModule(truncModuleName(reinterpret_cast<char *>(v_lib_name)));
+		}
+
+		if (d2fobis_IsSubclassed(ctx, _obj) == D2FS_YES) {
+			text * v_par_flnam{ nullptr };
+
+			if (d2fobgt_GetTextProp(ctx, _obj, D2FP_PAR_FLNAM, &v_par_flnam) == D2FS_SUCCESS && v_par_flnam && *v_par_flnam)
+				source_modules.insert(truncModuleName(reinterpret_cast<char *>(v_par_flnam)));
+		}
+
+		for (int prop_num : object_properties) {
+			if (d2fobhp_HasProp(ctx, _obj, prop_num) != D2FS_YES)
+				continue;
+
+			status = d2fobgo_GetObjProp(ctx, _obj, prop_num, &v_subobj);
+
+			if (status != D2FS_SUCCESS)
+				return status;
+
+			if (!v_subobj)
+				continue;
+
+			status = d2fobg_owner(ctx, v_subobj, &v_owner);
+
+			if (status != D2FS_SUCCESS)
+				return status;
+
+			if (_obj != v_owner)
+				continue;
+
+			while (v_subobj) {
+				status = scanDependencies(v_subobj);
+
+				if (status != D2FS_SUCCESS)
+					return status;
+
+				status = d2fobg_next(ctx, v_subobj, &v_subobj);
+
+				if (status != D2FS_SUCCESS)
+					return status;
+			}
+		}
+
+		if (is_root)
+			dependencies_known = true;
+
 		return D2FS_SUCCESS;
 	}
 
+	bool FAPIModule::isTraversed() const { TRACE_FNC("")
+		return root != nullptr;
+	}
+
+	bool FAPIModule::isModified() const { TRACE_FNC("")
+		return modified || !marked_objects.empty();
+	}
+
+	void FAPIModule::markModified() { TRACE_FNC("")
+		modified = true;
+	}
+
+	bool FAPIModule::isNative() const { TRACE_FNC("")
+		return mod != nullptr;
+	}
+
+	int FAPIModule::getLoadStatus() const { TRACE_FNC("")
+		return load_status;
+	}
+
+	void FAPIModule::attachNative() const { TRACE_FNC(filepath)
+		if (mod)
+			return;
+
+		mod.reset(loadNative());
+
+		if (!root)
+			return;
+
+		auto objects = getAllObjects();
+
+		// object without native counterpart would be used with null OracleForms object
+		if (bindObjects(static_cast<d2fob *>(mod.get()), root.get()) != objects.size()) {
+			for (auto fo : objects)
+				fo->attachFormsObj(nullptr);
+
+			mod.reset();
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Restored objects don't match module: " + filepath };
+		}
+	}
+
+	size_t FAPIModule::bindObjects(d2fob * _obj, FormsObject * _forms_object) const { TRACE_FNC("")
+		d2fctx * ctx = this->ctx->getContext();
+		d2fob * v_subobj, *v_owner;
+		size_t bound{ 1 };
+		_forms_object->attachFormsObj(_obj);
+
+		for (int prop_num : objectProperties(ctx)) {
+			if (d2fobhp_HasProp(ctx, _obj, prop_num) != D2FS_YES || d2fobgo_GetObjProp(ctx, _obj, prop_num, &v_subobj) != D2FS_SUCCESS || !v_subobj)
+				continue;
+
+			if (d2fobg_owner(ctx, v_subobj, &v_owner) != D2FS_SUCCESS || _obj != v_owner)
+				continue;
+
+			while (v_subobj) {
+				d2fotyp v_obj_typ;
+				text * v_name{ nullptr };
+
+				if (d2fobqt_QueryType(ctx, v_subobj, &v_obj_typ) == D2FS_SUCCESS && d2fobg_name(ctx, v_subobj, &v_name) == D2FS_SUCCESS && v_name) {
+					auto child = _forms_object->getObject(v_obj_typ, reinterpret_cast<char *>(v_name));
+
+					if (child.isValid())
+						bound += bindObjects(v_subobj, child.get());
+				}
+
+				if (d2fobg_next(ctx, v_subobj, &v_subobj) != D2FS_SUCCESS)
+					break;
+			}
+		}
+
+		return bound;
+	}
+
 	vector<FormsObject *> FAPIModule::getObjects(const int _type_id) const { TRACE_FNC(to_string(_type_id))
 		return root->getObjects(_type_id);
 	}
@@ -239,6 +534,82 @@ namespace CPPFAPIWrapper {
 		return getObjects(D2FFO_ATT_LIB);
 	}
 
+	vector<FAPILibrary *> FAPIModule::getLibraries() { TRACE_FNC(filepath)
+		if (!libraries_resolved) {
+			vector<string> names;
+
+			if (isTraversed()) {
+				for (const auto & att_lib : getAttachedLibraries())
+					names.emplace_back(truncModuleName(att_lib->getName()));
+			}
+			else {
+				scanDependencies();
+				names = library_order;
+			}
+
+			for (const auto & name : names) {
+				FAPILibrary * library{ nullptr };
+
+				try {
+					string path = libraryPathFromName(name);
+					library = ctx->acquireLibrary(path);
+					acquired_libs.emplace_back(path);
+				}
+				catch (FAPIException & ex) { FAPILogger::warn("Attached library not loaded: " + name + " " + ex.what()); }
+
+				attached_libs.emplace_back(name, library);
+			}
+
+			libraries_resolved = true;
+		}
+
+		vector<FAPILibrary *> libraries;
+
+		for (const auto & attached : attached_libs)
+			if (attached.second)
+				libraries.emplace_back(attached.second);
+
+		return libraries;
+	}
+
+	Expected<FAPILibrary> FAPIModule::getLibrary(FormsObject * _att_lib) { TRACE_FNC("")
+		getLibraries();
+		string name = truncModuleName(_att_lib->getName());
+		auto attached = find_if(attached_libs.begin(), attached_libs.end(), [&name](const auto & _attached) { return _attached.first == name; });
+
+		return Expected<FAPILibrary>{ attached != attached_libs.end() ? attached->second : nullptr };
+	}
+
+	void FAPIModule::releaseLibraries() { TRACE_FNC(filepath)
+		for (const auto & path : acquired_libs)
+			ctx->releaseLibrary(path);
+
+		acquired_libs.clear();
+		attached_libs.clear();
+		libraries_resolved = false;
+	}
+
+	const unordered_set<string> & FAPIModule::getGlobals() const { TRACE_FNC("")
+		return globals;
+	}
+
+	const vector<GlobalUsage> & FAPIModule::getGlobalReferences() const { TRACE_FNC("")
+		return global_references;
+	}
+
+	unordered_set<string> FAPIModule::getLibraryGlobals() { TRACE_FNC(filepath)
+		unordered_set<string> library_globals;
+
+		for (auto library : getLibraries()) {
+			if (!library->globals_found)
+				library->findGlobals();
+
+			library_globals.insert(library->globals.begin(), library->globals.end());
+		}
+
+		return library_globals;
+	}
+
 	vector<FormsObject *> FAPIModule::getBlocks() const { TRACE_FNC("")
 		return getObjects(D2FFO_BLOCK);
 	}
@@ -294,4 +665,13 @@ namespace CPPFAPIWrapper {
 	unordered_set<string> FAPIModule::getSourceModules() const { TRACE_FNC("")
 		return source_modules;
 	}
+
+	unordered_set<string> FAPIModule::getLibraryModules() const { TRACE_FNC("")
+		return library_modules;
+	}
+
+	void FAPIModule::addLibraryModule(const string & _name) { TRACE_FNC(_name)
+		if (library_modules.insert(_name).second)
+			library_order.emplace_back(_name);
+	}
 }
\ No newline at end of file
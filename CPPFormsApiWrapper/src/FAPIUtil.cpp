@@ -1,7 +1,15 @@
 #include "FAPIUtil.h"
+#include "ModulePathResolver.h"
 
 #include <algorithm>
 #include <fstream>
+#include <cstdio>
+#include <atomic>
+#include <sys/stat.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
 
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
@@ -45,31 +53,164 @@ namespace CPPFAPIWrapper {
 		return reinterpret_cast<text *>(const_cast<char *>(_str.c_str()));
 	}
 
+	string pathFromName(const string & _name) { TRACE_FNC(_name)
+		return getModulePathResolver().resolve(_name);
+	}
+
 	string modulePathFromName(const string & _str) { TRACE_FNC(_str)
-		vector<string> fmb_paths = getFMBPaths();
-		string name = truncModuleName(_str) + ".FMB";
+		return pathFromName(truncModuleName(_str) + ".FMB");
+	}
+
+	string libraryPathFromName(const string & _str) { TRACE_FNC(_str)
+		return pathFromName(truncModuleName(_str) + ".PLL");
+	}
 
-		for (const auto & fmb_path : fmb_paths) {
-			string filepath = fmb_path + name;
-			FAPILogger::debug(filepath);
+	bool fileExists(const string & _filepath) { TRACE_FNC(_filepath)
+#ifdef _WIN32
+		DWORD attributes = GetFileAttributesA(_filepath.c_str());
+		return attributes != INVALID_FILE_ATTRIBUTES && !(attributes & FILE_ATTRIBUTE_DIRECTORY);
+#else
+		struct stat st;
+		return stat(_filepath.c_str(), &st) == 0 && !S_ISDIR(st.st_mode);
+#endif
+	}
 
-			if (fileExists(filepath))
-				return toUpper(filepath);
+	uint64_t hashBytes(const char * _data, const size_t _size, uint64_t _seed) {
+		for (size_t i = 0; i < _size; ++i) {
+			_seed ^= static_cast<unsigned char>(_data[i]);
+			_seed *= 1099511628211ULL;
 		}
 
-		throw FAPIException{ Reason::OTHER, __FILE__, __LINE__ };
+		return _seed;
 	}
 
-	bool fileExists(const string & _filepath) { TRACE_FNC(_filepath)
-		ifstream file { _filepath };
-		bool exists = file.is_open();
-		file.close();
+	FileFingerprint fileFingerprint(const string & _filepath, const bool _with_hash) { TRACE_FNC(_filepath)
+		FileFingerprint fingerprint{ -1, 0, 0 };
+#ifdef _WIN32
+		WIN32_FILE_ATTRIBUTE_DATA data;
+
+		if (!GetFileAttributesExA(_filepath.c_str(), GetFileExInfoStandard, &data))
+			return fingerprint;
+
+		fingerprint.size = (static_cast<int64_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+		fingerprint.mtime = (static_cast<int64_t>(data.ftLastWriteTime.dwHighDateTime) << 32) | data.ftLastWriteTime.dwLowDateTime;
+#else
+		struct stat st;
+
+		if (stat(_filepath.c_str(), &st) != 0)
+			return fingerprint;
+
+		fingerprint.size = static_cast<int64_t>(st.st_size);
+		fingerprint.mtime = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+
+		if (!_with_hash)
+			return fingerprint;
+
+		ifstream file{ _filepath, ios::binary };
+		vector<char> buffer(1 << 16);
+		uint64_t hash = hashBytes(nullptr, 0);
+
+		while (file) {
+			file.read(buffer.data(), buffer.size());
+			hash = hashBytes(buffer.data(), static_cast<size_t>(file.gcount()), hash);
+		}
+
+		fingerprint.hash = hash;
+		return fingerprint;
+	}
+
+	bool fileChanged(const FileFingerprint & _fingerprint, const string & _filepath) { TRACE_FNC(_filepath)
+		FileFingerprint current = fileFingerprint(_filepath, false);
 
-		return exists;
+		if (current.size != _fingerprint.size)
+			return true;
+
+		if (current.mtime == _fingerprint.mtime)
+			return false;
+
+		return fileFingerprint(_filepath).hash != _fingerprint.hash;
+	}
+
+	bool replaceFile(const string & _source, const string & _target) { TRACE_FNC(_source + " | " + _target)
+#ifdef _WIN32
+		return MoveFileExA(_source.c_str(), _target.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+		return rename(_source.c_str(), _target.c_str()) == 0;
+#endif
+	}
+
+	string temporaryPath(const string & _filepath) { TRACE_FNC(_filepath)
+		static atomic<unsigned long> counter{ 0 };
+#ifdef _WIN32
+		unsigned long pid = GetCurrentProcessId();
+#else
+		unsigned long pid = static_cast<unsigned long>(getpid());
+#endif
+
+		return _filepath + "." + to_string(pid) + "_" + to_string(counter++) + ".tmp";
+	}
+
+	string escapeField(const string & _field) {
+		string escaped;
+		escaped.reserve(_field.size());
+
+		for (const char c : _field) {
+			switch (c) {
+			case '\\': escaped += "\\\\"; break;
+			case '\t': escaped += "\\t"; break;
+			case '\n': escaped += "\\n"; break;
+			case '\r': escaped += "\\r"; break;
+			default: escaped += c;
+			}
+		}
+
+		return escaped;
+	}
+
+	vector<string> splitEscapedFields(const string & _line) {
+		vector<string> fields{ "" };
+
+		for (size_t i = 0; i < _line.size(); ++i) {
+			if (_line[i] == '\t') {
+				fields.emplace_back();
+				continue;
+			}
+
+			if (_line[i] != '\\') {
+				fields.back() += _line[i];
+				continue;
+			}
+
+			if (++i == _line.size())
+				throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Malformed line: " + _line };
+
+			switch (_line[i]) {
+			case 't': fields.back() += '\t'; break;
+			case 'n': fields.back() += '\n'; break;
+			case 'r': fields.back() += '\r'; break;
+			default: fields.back() += _line[i];
+			}
+		}
+
+		return fields;
+	}
+
+	string resolveModulePath(const string & _name, const ModuleKind _kind, const bool _ignore_missing) { TRACE_FNC(_name)
+		try {
+			return _kind == ModuleKind::FORM ? modulePathFromName(_name) : libraryPathFromName(_name);
+		}
+		catch (FAPIException & ex) {
+			if (!_ignore_missing)
+				throw;
+
+			FAPILogger::warn(ex.what());
+			return "";
+		}
 	}
 
 	string moduleNameFromPath(const string & _str) { TRACE_FNC(_str)
-		int pos1 = _str.rfind("/") + 1;
+		int pos1 = _str.find_last_of("/\\") + 1;
 		int pos2 = _str.find(".", pos1);
 
 		return toUpper(_str.substr(pos1, pos2 - pos1));
@@ -102,7 +243,7 @@ namespace CPPFAPIWrapper {
 
 	vector<string> splitString(string _str, const string & _delimiter) { TRACE_FNC(_str + " | " + _delimiter)
 		vector<string> strings;
-		unsigned int pos = _str.find(_delimiter);
+		size_t pos = _str.find(_delimiter);
 
 		while (pos != string::npos) {
 			string path = _str.substr(0, pos);
@@ -121,8 +262,7 @@ namespace CPPFAPIWrapper {
 	}
 
 	vector<string> getFMBPaths() { TRACE_FNC("")
-		string paths = readRegistryKey(HKEY_LOCAL_MACHINE, "SOFTWARE\\ORACLE", "FORMS60_PATH");
-		return splitString(paths);
+		return getModulePathResolver().getDirectories();
 	}
 
 	bool isValueProperty(d2fctx * const _ctx, const int _prop_id) {
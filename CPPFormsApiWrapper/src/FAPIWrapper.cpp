@@ -3,9 +3,12 @@
 #include "d2fctx.h"
 
 #include "FAPIContext.h"
+#include "BuiltinsCatalogue.h"
 #include "Exceptions.h"
 
 #include <algorithm>
+#include <mutex>
+#include <cstdlib>
 
 #include "FAPILogger.h"
 
@@ -20,12 +23,59 @@ namespace CPPFAPIWrapper {
 		auto ctx = make_unique<FAPIContext>();
 		ctx->connectContextToDB(_connstring);
 
-		if (builtins.empty())
-			builtins = ctx->getBuiltins();
-
 		return ctx;
 	}
 
+	string defaultBuiltinsDirectory() {
+		for (const char * var : { "TEMP", "TMP", "TMPDIR" }) {
+			const char * dir = getenv(var);
+
+			if (dir && *dir)
+				return dir;
+		}
+
+		return "";
+	}
+
+	mutex builtins_mutex;
+	string builtins_dir = defaultBuiltinsDirectory();
+	BuiltinsCatalogue builtins_catalogue;
+	bool builtins_loaded = false;
+
+	void setBuiltinsDirectory(const string & _directory) { TRACE_FNC(_directory)
+		lock_guard<mutex> lock{ builtins_mutex };
+		builtins_dir = _directory;
+	}
+
+	string getBuiltinsDirectory() { TRACE_FNC("")
+		lock_guard<mutex> lock{ builtins_mutex };
+		return builtins_dir;
+	}
+
+	const BuiltinsCatalogue & getBuiltinsCatalogue(FAPIContext * _ctx) { TRACE_FNC("")
+		lock_guard<mutex> lock{ builtins_mutex };
+
+		if (builtins_loaded)
+			return builtins_catalogue;
+
+		uint32_t version = _ctx->getBuilderVersion();
+		string filepath = BuiltinsCatalogue::cataloguePath(builtins_dir, version);
+		builtins_loaded = builtins_catalogue.load(filepath, version);
+
+		if (!builtins_loaded) {
+			builtins_catalogue.build(version, _ctx->enumerateBuiltins());
+			builtins_loaded = true;
+
+			try {
+				builtins_catalogue.save(filepath);
+			}
+			catch (FAPIException & ex) { FAPILogger::warn(ex.what()); }
+		}
+
+		builtins = builtins_catalogue.getPackages();
+		return builtins_catalogue;
+	}
+
 	int typeNameToID(const string & _type_name) { TRACE_FNC(_type_name)
 		unsigned int ret = find(obj_types.begin(), obj_types.end(), _type_name) - obj_types.begin();
 		FAPILogger::debug(to_string(ret));
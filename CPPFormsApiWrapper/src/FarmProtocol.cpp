@@ -0,0 +1,261 @@
+#include "FarmProtocol.h"
+
+#include "Exceptions.h"
+#include "FAPILogger.h"
+
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
+#include <sys/socket.h>
+#endif
+
+namespace CPPFAPIWrapper {
+	using namespace std;
+
+	// type and task id
+	const size_t FARM_HEADER_SIZE = 5;
+	const size_t FARM_MAX_FRAME = 64 * 1024 * 1024;
+
+#if !defined(_WIN32) && defined(MSG_NOSIGNAL)
+	const int FARM_SEND_FLAGS = MSG_NOSIGNAL;
+#elif !defined(_WIN32)
+	const int FARM_SEND_FLAGS = 0;	// SO_NOSIGPIPE is set on the socket instead
+#endif
+
+	void appendFarmUInt32(string & _frame, const uint32_t _value) {
+		for (int i = 0; i < 4; ++i)
+			_frame += static_cast<char>((_value >> (8 * i)) & 0xFF);
+	}
+
+	uint32_t readFarmUInt32(const char * _data) {
+		uint32_t value{ 0 };
+
+		for (int i = 0; i < 4; ++i)
+			value |= static_cast<uint32_t>(static_cast<unsigned char>(_data[i])) << (8 * i);
+
+		return value;
+	}
+
+	string encodeFarmMessage(const FarmMessage & _message) { TRACE_FNC(to_string(_message.task_id))
+		if (_message.payload.size() > FARM_MAX_FRAME - FARM_HEADER_SIZE)
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Farm message too long" };
+
+		string frame;
+		frame.reserve(4 + FARM_HEADER_SIZE + _message.payload.size());
+		appendFarmUInt32(frame, static_cast<uint32_t>(FARM_HEADER_SIZE + _message.payload.size()));
+		frame += static_cast<char>(_message.type);
+		appendFarmUInt32(frame, _message.task_id);
+		frame += _message.payload;
+
+		return frame;
+	}
+
+	FarmDecoder::FarmDecoder()
+		: offset(0) { TRACE_FNC("") }
+
+	void FarmDecoder::feed(const char * _data, const size_t _size) { TRACE_FNC(to_string(_size))
+		// drop consumed bytes before buffer grows
+		if (offset > 0 && offset == buffer.size()) {
+			buffer.clear();
+			offset = 0;
+		}
+
+		buffer.insert(buffer.end(), _data, _data + _size);
+	}
+
+	bool FarmDecoder::next(FarmMessage & _message) { TRACE_FNC("")
+		if (buffer.size() - offset < 4)
+			return false;
+
+		uint32_t length = readFarmUInt32(buffer.data() + offset);
+
+		if (length < FARM_HEADER_SIZE || length > FARM_MAX_FRAME)
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Malformed farm message, length: " + to_string(length) };
+
+		if (buffer.size() - offset - 4 < length)
+			return false;
+
+		const char * frame = buffer.data() + offset + 4;
+		uint8_t type = static_cast<uint8_t>(frame[0]);
+
+		if (type < static_cast<uint8_t>(FarmMessageType::TASK) || type > static_cast<uint8_t>(FarmMessageType::SHUTDOWN))
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Malformed farm message, type: " + to_string(type) };
+
+		_message.type = static_cast<FarmMessageType>(type);
+		_message.task_id = readFarmUInt32(frame + 1);
+		_message.payload.assign(frame + FARM_HEADER_SIZE, length - FARM_HEADER_SIZE);
+		offset += 4 + length;
+
+		if (offset == buffer.size()) {
+			buffer.clear();
+			offset = 0;
+		}
+
+		return true;
+	}
+
+	FarmPipe::FarmPipe(intptr_t _read_end, intptr_t _write_end)
+		: read_end(_read_end), write_end(_write_end) { TRACE_FNC("") }
+
+	FarmPipe::FarmPipe(FarmPipe && _pipe)
+		: read_end(_pipe.read_end), write_end(_pipe.write_end), decoder(move(_pipe.decoder)) { TRACE_FNC("")
+		_pipe.read_end = -1;
+		_pipe.write_end = -1;
+	}
+
+	FarmPipe & FarmPipe::operator=(FarmPipe && _pipe) { TRACE_FNC("")
+		if (this != &_pipe) {
+			close();
+			read_end = _pipe.read_end;
+			write_end = _pipe.write_end;
+			decoder = move(_pipe.decoder);
+			_pipe.read_end = -1;
+			_pipe.write_end = -1;
+		}
+
+		return *this;
+	}
+
+	FarmPipe::~FarmPipe() { TRACE_FNC("")
+		close();
+	}
+
+	FarmPipe FarmPipe::standardIO() { TRACE_FNC("")
+#ifdef _WIN32
+		int out = _dup(1);
+		_dup2(2, 1);
+
+		return FarmPipe{ reinterpret_cast<intptr_t>(GetStdHandle(STD_INPUT_HANDLE)), _get_osfhandle(out) };
+#else
+		int out = dup(1);
+		dup2(2, 1);
+
+		return FarmPipe{ 0, out };
+#endif
+	}
+
+	void FarmPipe::createOSPipe(intptr_t & _read_end, intptr_t & _write_end) { TRACE_FNC("")
+#ifdef _WIN32
+		HANDLE read_handle{ nullptr }, write_handle{ nullptr };
+
+		if (!CreatePipe(&read_handle, &write_handle, nullptr, 0))
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Couldn't create pipe: " + to_string(GetLastError()) };
+
+		_read_end = reinterpret_cast<intptr_t>(read_handle);
+		_write_end = reinterpret_cast<intptr_t>(write_handle);
+#else
+		// socket pair instead of pipe, so writes can be told not to raise SIGPIPE
+		int fds[2];
+
+		if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Couldn't create pipe: " + to_string(errno) };
+
+#ifndef MSG_NOSIGNAL
+		int no_sigpipe{ 1 };
+		setsockopt(fds[1], SOL_SOCKET, SO_NOSIGPIPE, &no_sigpipe, sizeof(no_sigpipe));
+#endif
+
+		// not inherited by other workers, so they don't keep it open
+		fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+		fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+		_read_end = fds[0];
+		_write_end = fds[1];
+#endif
+	}
+
+	bool FarmPipe::read(FarmMessage & _message) { TRACE_FNC("")
+		char chunk[4096];
+
+		while (!decoder.next(_message)) {
+			if (read_end == -1)
+				return false;
+
+#ifdef _WIN32
+			DWORD count{ 0 };
+
+			if (!ReadFile(reinterpret_cast<HANDLE>(read_end), chunk, sizeof(chunk), &count, nullptr) || count == 0)
+				return false;
+#else
+			ssize_t count = ::read(static_cast<int>(read_end), chunk, sizeof(chunk));
+
+			if (count < 0 && errno == EINTR)
+				continue;
+
+			if (count <= 0)
+				return false;
+#endif
+
+			decoder.feed(chunk, static_cast<size_t>(count));
+		}
+
+		return true;
+	}
+
+	bool FarmPipe::write(const FarmMessage & _message) { TRACE_FNC(to_string(_message.task_id))
+		if (write_end == -1)
+			return false;
+
+		string frame = encodeFarmMessage(_message);
+		size_t written{ 0 };
+
+		while (written < frame.size()) {
+#ifdef _WIN32
+			DWORD count{ 0 };
+
+			if (!WriteFile(reinterpret_cast<HANDLE>(write_end), frame.data() + written, static_cast<DWORD>(frame.size() - written), &count, nullptr))
+				return false;
+#else
+			// closed other side fails the write with EPIPE instead of raising SIGPIPE in whole process
+			ssize_t count = send(static_cast<int>(write_end), frame.data() + written, frame.size() - written, FARM_SEND_FLAGS);
+
+			// standard output of a worker started by other means may be a plain pipe
+			if (count < 0 && errno == ENOTSOCK)
+				count = ::write(static_cast<int>(write_end), frame.data() + written, frame.size() - written);
+
+			if (count < 0 && errno == EINTR)
+				continue;
+
+			if (count <= 0)
+				return false;
+#endif
+
+			written += static_cast<size_t>(count);
+		}
+
+		return true;
+	}
+
+	void FarmPipe::closeWrite() { TRACE_FNC("")
+		if (write_end == -1)
+			return;
+
+#ifdef _WIN32
+		CloseHandle(reinterpret_cast<HANDLE>(write_end));
+#else
+		::close(static_cast<int>(write_end));
+#endif
+
+		write_end = -1;
+	}
+
+	void FarmPipe::close() {
+		closeWrite();
+
+		if (read_end == -1)
+			return;
+
+#ifdef _WIN32
+		CloseHandle(reinterpret_cast<HANDLE>(read_end));
+#else
+		::close(static_cast<int>(read_end));
+#endif
+
+		read_end = -1;
+	}
+}
@@ -0,0 +1,460 @@
+#include "FmxBuild.h"
+
+#include "FAPIContext.h"
+#include "FAPIForm.h"
+#include "FAPILibrary.h"
+#include "FAPIWrapper.h"
+#include "FAPIUtil.h"
+#include "ModuleGraph.h"
+#include "WorkerFarm.h"
+
+#include "Exceptions.h"
+#include "FAPILogger.h"
+
+#include <map>
+#include <set>
+#include <algorithm>
+
+namespace CPPFAPIWrapper {
+	using namespace std;
+
+	const string BUILD_JOURNAL_HEADER = "CPPFAPIBUILDJOURNAL\t1";
+
+	string joinDependencies(const vector<string> & _dependencies) {
+		string joined;
+
+		for (const auto & dependency : _dependencies)
+			joined += (joined.empty() ? "" : ";") + dependency;
+
+		return joined;
+	}
+
+	vector<string> splitDependencies(const string & _joined) {
+		vector<string> dependencies;
+		size_t begin{ 0 };
+
+		while (begin < _joined.size()) {
+			size_t end = _joined.find(';', begin);
+
+			if (end == string::npos)
+				end = _joined.size();
+
+			if (end - begin > 2)
+				dependencies.emplace_back(_joined.substr(begin, end - begin));
+
+			begin = end + 1;
+		}
+
+		return dependencies;
+	}
+
+	BuildJournal::BuildJournal(const string & _filepath)
+		: filepath(_filepath) { TRACE_FNC(_filepath)
+		load();
+		bool empty = fileFingerprint(filepath, false).size <= 0;
+		file.open(filepath, ios::binary | ios::app);
+
+		if (!file.is_open())
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Couldn't open build journal: " + filepath };
+
+		if (empty)
+			append(BUILD_JOURNAL_HEADER);
+	}
+
+	bool BuildJournal::findModule(const string & _filepath, JournalModule & _module) const { TRACE_FNC(_filepath)
+		auto it = modules.find(_filepath);
+
+		if (it == modules.end())
+			return false;
+
+		_module = it->second;
+		return true;
+	}
+
+	void BuildJournal::recordModule(const string & _filepath, const JournalModule & _module) { TRACE_FNC(_filepath)
+		append("M\t" + escapeField(_filepath) + "\t" + to_string(_module.fingerprint.size) + "\t" + to_string(_module.fingerprint.mtime) + "\t"
+			+ to_string(_module.fingerprint.hash) + "\t" + joinDependencies(_module.dependencies));
+		modules[_filepath] = _module;
+	}
+
+	bool BuildJournal::findOutput(const string & _filepath, JournalOutput & _output) const { TRACE_FNC(_filepath)
+		auto it = outputs.find(_filepath);
+
+		if (it == outputs.end())
+			return false;
+
+		_output = it->second;
+		return true;
+	}
+
+	void BuildJournal::recordOutput(const string & _filepath, const JournalOutput & _output) { TRACE_FNC(_filepath)
+		append("G\t" + escapeField(_filepath) + "\t" + to_string(_output.key) + "\t" + to_string(_output.output.size) + "\t" + to_string(_output.output.mtime));
+		outputs[_filepath] = _output;
+	}
+
+	void BuildJournal::forgetOutput(const string & _filepath) { TRACE_FNC(_filepath)
+		if (outputs.erase(_filepath))
+			append("X\t" + escapeField(_filepath));
+	}
+
+	void BuildJournal::compact() { TRACE_FNC(filepath)
+		string tmp_path = filepath + ".tmp";
+
+		{
+			ofstream tmp_file{ tmp_path, ios::binary | ios::trunc };
+
+			if (!tmp_file.is_open())
+				throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Couldn't write build journal: " + tmp_path };
+
+			tmp_file << BUILD_JOURNAL_HEADER << "\n";
+
+			for (const auto & module : modules)
+				tmp_file << "M\t" << escapeField(module.first) << "\t" << module.second.fingerprint.size << "\t" << module.second.fingerprint.mtime << "\t"
+					<< module.second.fingerprint.hash << "\t" << joinDependencies(module.second.dependencies) << "\n";
+
+			for (const auto & output : outputs)
+				tmp_file << "G\t" << escapeField(output.first) << "\t" << output.second.key << "\t" << output.second.output.size << "\t" << output.second.output.mtime << "\n";
+
+			if (!tmp_file)
+				throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Couldn't write build journal: " + tmp_path };
+		}
+
+		file.close();
+
+		if (!replaceFile(tmp_path, filepath))
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Couldn't write build journal: " + filepath };
+
+		file.open(filepath, ios::binary | ios::app);
+	}
+
+	void BuildJournal::load() { TRACE_FNC(filepath)
+		ifstream input{ filepath, ios::binary };
+
+		if (!input.is_open())
+			return;
+
+		string line;
+
+		if (!getline(input, line))
+			return;
+
+		if (line != BUILD_JOURNAL_HEADER)
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Invalid build journal: " + filepath };
+
+		size_t skipped{ 0 };
+
+		while (getline(input, line)) {
+			try {
+				auto fields = splitEscapedFields(line);
+
+				if (fields[0] == "M" && fields.size() == 6)
+					modules[fields[1]] = JournalModule{ FileFingerprint{ stoll(fields[2]), stoll(fields[3]), stoull(fields[4]) }, splitDependencies(fields[5]) };
+				else if (fields[0] == "G" && fields.size() == 5)
+					outputs[fields[1]] = JournalOutput{ stoull(fields[2]), FileFingerprint{ stoll(fields[3]), stoll(fields[4]), 0 } };
+				else if (fields[0] == "X" && fields.size() == 2)
+					outputs.erase(fields[1]);
+				else
+					++skipped;
+			}
+			catch (exception &) {
+				++skipped;
+			}
+		}
+
+		if (skipped)
+			FAPILogger::warn("Skipped " + to_string(skipped) + " unreadable records of build journal " + filepath);
+	}
+
+	void BuildJournal::append(const string & _line) {
+		file << _line << "\n";
+		file.flush();
+
+		if (!file)
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Couldn't write build journal: " + filepath };
+	}
+
+	// modules are identified by path, so modules of the same name in different directories are kept apart;
+	// path given as input and the same path resolved for a dependency may differ in case and separators
+	static string modulePathKey(const string & _path) {
+		string key = toUpper(_path);
+		replace(key.begin(), key.end(), '\\', '/');
+
+		return key;
+	}
+
+	FmxBuilder::FmxBuilder(FAPIContext & _ctx, WorkerLauncher & _launcher, const size_t _workers, const string & _journal_path)
+		: ctx(_ctx), launcher(_launcher), workers(_workers), journal(_journal_path) { TRACE_FNC(to_string(_workers) + " | " + _journal_path) }
+
+	vector<FmxBuildResult> FmxBuilder::build(const vector<string> & _filepaths, function<void(const FmxBuildResult &)> _on_result, const bool _force,
+		const bool _ignore_missing_libs, const bool _ignore_missing_sub) { TRACE_FNC(to_string(_filepaths.size()) + " | " + to_string(_force))
+		ModuleGraph graph;
+		unordered_map<string, uint64_t> hashes;
+		vector<string> to_process;
+
+		for (const auto & filepath : _filepaths) {
+			string key = modulePathKey(filepath);
+
+			if (!graph.hasModule(key)) {
+				graph.addModule(key, filepath, ModuleKind::FORM);
+				to_process.emplace_back(key);
+			}
+		}
+
+		while (!to_process.empty()) {
+			string key = to_process.back();
+			to_process.pop_back();
+			string path = graph.getModule(key).path;
+			ModuleKind kind = graph.getModule(key).kind;
+
+			if (path.empty())
+				continue;
+
+			JournalModule module = fingerprintModule(path, kind == ModuleKind::FORM, _ignore_missing_libs, _ignore_missing_sub);
+			hashes[key] = module.fingerprint.hash;
+
+			for (const auto & dependency : module.dependencies) {
+				ModuleKind dependency_kind = dependency[0] == 'F' ? ModuleKind::FORM : ModuleKind::LIBRARY;
+				bool ignore = dependency_kind == ModuleKind::FORM ? _ignore_missing_sub : _ignore_missing_libs;
+				string dependency_path = resolveModulePath(dependency.substr(2), dependency_kind, ignore);
+				// unresolved module is kept by name, it can't be a path
+				string dependency_key = dependency_path.empty() ? "<" + dependency + ">" : modulePathKey(dependency_path);
+
+				if (!graph.hasModule(dependency_key)) {
+					graph.addModule(dependency_key, dependency_path, dependency_kind);
+					to_process.emplace_back(dependency_key);
+				}
+
+				graph.addDependency(key, dependency_key);
+			}
+		}
+
+		// every module with all its recurrent dependencies, sorted by path so key doesn't depend on scan order
+		auto order = graph.topologicalOrder();
+		unordered_map<string, set<string>> closures;
+
+		for (const auto & key : order) {
+			auto & closure = closures[key];
+			closure.insert(key);
+
+			for (const auto & dependency : graph.getModule(key).dependencies)
+				closure.insert(closures[dependency].begin(), closures[dependency].end());
+		}
+
+		vector<FmxBuildResult> results(_filepaths.size());
+		unordered_map<string, vector<size_t>> pending;
+		unordered_map<string, uint64_t> keys;
+
+		auto report = [&](const string & _key, const FmxBuildStatus _status, const string & _message) {
+			for (auto i : pending[_key]) {
+				results[i] = FmxBuildResult{ _filepaths[i], _status, _message };
+
+				if (_on_result)
+					_on_result(results[i]);
+			}
+		};
+
+		for (size_t i = 0; i < _filepaths.size(); ++i) {
+			string module_key = modulePathKey(_filepaths[i]);
+			string inputs;
+
+			for (const auto & module : closures[module_key]) {
+				auto hash = hashes.find(module);
+				inputs += module + ":" + (hash != hashes.end() ? to_string(hash->second) : "missing") + "\n";
+			}
+
+			uint64_t key = hashBytes(inputs.data(), inputs.size());
+			const string & path = graph.getModule(module_key).path;
+			FileFingerprint fmx = fileFingerprint(fmxPath(path), false);
+			JournalOutput output;
+
+			if (!_force && fmx.size >= 0 && journal.findOutput(path, output) && output.key == key && output.output.size == fmx.size && output.output.mtime == fmx.mtime) {
+				results[i] = FmxBuildResult{ _filepaths[i], FmxBuildStatus::UP_TO_DATE, "" };
+
+				if (_on_result)
+					_on_result(results[i]);
+
+				continue;
+			}
+
+			pending[module_key].emplace_back(i);
+			keys[module_key] = key;
+		}
+
+		// form is generated in a wave after all its pending source modules
+		unordered_map<string, size_t> levels;
+		map<size_t, vector<string>> waves;
+
+		for (const auto & key : order) {
+			size_t level{ 0 };
+
+			for (const auto & dependency : graph.getModule(key).dependencies)
+				level = max(level, levels[dependency] + (pending.count(dependency) ? 1 : 0));
+
+			levels[key] = level;
+
+			if (pending.count(key))
+				waves[level].emplace_back(key);
+		}
+
+		FAPILogger::info("Fmx build: " + to_string(_filepaths.size() - keys.size()) + " up to date, " + to_string(keys.size()) + " to generate in " + to_string(waves.size()) + " waves");
+
+		set<string> failed;
+
+		for (const auto & wave : waves) {
+			vector<string> paths;
+			vector<string> path_keys;
+
+			for (const auto & key : wave.second) {
+				auto & closure = closures[key];
+				auto failed_dependency = find_if(closure.begin(), closure.end(), [&failed](const string & _module) { return failed.count(_module) > 0; });
+
+				if (failed_dependency != closure.end()) {
+					failed.insert(key);
+					report(key, FmxBuildStatus::SKIPPED, graph.getModule(*failed_dependency).path);
+					continue;
+				}
+
+				paths.emplace_back(graph.getModule(key).path);
+				path_keys.emplace_back(key);
+			}
+
+			if (paths.empty())
+				continue;
+
+			WorkerFarm farm{ launcher, min(workers, paths.size()) };
+			farm.run(paths, [&](const FarmResult & _result) {
+				// paths of a wave are distinct modules, so result is matched by its path
+				size_t index = find(paths.begin(), paths.end(), _result.path) - paths.begin();
+				const string & key = path_keys[index];
+
+				if (!_result.success) {
+					failed.insert(key);
+					report(key, FmxBuildStatus::FAILED, _result.payload);
+					return;
+				}
+
+				FileFingerprint fmx = fileFingerprint(fmxPath(_result.path), false);
+
+				if (fmx.size < 0) {
+					failed.insert(key);
+					report(key, FmxBuildStatus::FAILED, "No .fmx generated: " + fmxPath(_result.path));
+					return;
+				}
+
+				journal.recordOutput(_result.path, JournalOutput{ keys[key], fmx });
+				report(key, FmxBuildStatus::GENERATED, "");
+			});
+		}
+
+		journal.compact();
+		return results;
+	}
+
+	BuildJournal & FmxBuilder::getJournal() { TRACE_FNC("")
+		return journal;
+	}
+
+	string FmxBuilder::generateForm(FAPIContext & _ctx, const string & _filepath) { TRACE_FNC(_filepath)
+		_ctx.loadModule(_filepath, false, false, false);
+		_ctx.getModule(_filepath)->generateModule();
+
+		return "";
+	}
+
+	string FmxBuilder::fmxPath(const string & _filepath) { TRACE_FNC(_filepath)
+		size_t separator = _filepath.find_last_of("\\/");
+		size_t extension = _filepath.rfind('.');
+
+		if (extension == string::npos || (separator != string::npos && extension < separator))
+			return _filepath + ".fmx";
+
+		string fmx_extension = _filepath.size() > extension + 1 && islower(static_cast<unsigned char>(_filepath[extension + 1])) ? ".fmx" : ".FMX";
+		return _filepath.substr(0, extension) + fmx_extension;
+	}
+
+	JournalModule FmxBuilder::fingerprintModule(const string & _filepath, const bool _form, const bool _ignore_missing_libs, const bool _ignore_missing_sub) { TRACE_FNC(_filepath)
+		FileFingerprint current = fileFingerprint(_filepath, false);
+
+		if (current.size < 0)
+			throw FAPIException{ Reason::OBJECT_NOT_FOUND, __FILE__, __LINE__, _filepath };
+
+		JournalModule recorded;
+		bool known = journal.findModule(_filepath, recorded);
+
+		if (known && recorded.fingerprint.size == current.size && recorded.fingerprint.mtime == current.mtime)
+			return recorded;
+
+		current = fileFingerprint(_filepath);
+
+		// touched but unchanged, dependencies are still valid
+		if (known && recorded.fingerprint.size == current.size && recorded.fingerprint.hash == current.hash) {
+			recorded.fingerprint = current;
+			journal.recordModule(_filepath, recorded);
+			return recorded;
+		}
+
+		JournalModule module{ current, {} };
+
+		if (_form) {
+			bool loaded = ctx.hasModule(_filepath);
+
+			if (!loaded)
+				ctx.loadModule(_filepath, _ignore_missing_libs, _ignore_missing_sub, false);
+
+			try {
+				auto form = ctx.getModule(_filepath);
+				int status = form->scanDependencies();
+
+				if (status != D2FS_SUCCESS)
+					throw FAPIException{ Reason::INTERNAL_ERROR, __FILE__, __LINE__, _filepath, status };
+
+				string name = moduleNameFromPath(_filepath);
+
+				for (const auto & source_mod : form->getSourceModules())
+					if (source_mod != name)
+						module.dependencies.emplace_back("F:" + source_mod);
+
+				for (const auto & lib : form->getLibraryModules())
+					module.dependencies.emplace_back("L:" + lib);
+			}
+			catch (...) {
+				if (!loaded)
+					ctx.removeModule(_filepath);
+
+				throw;
+			}
+
+			if (!loaded)
+				ctx.removeModule(_filepath);
+
+			sort(module.dependencies.begin(), module.dependencies.end());
+		}
+		else {
+			// libraries attached to a library are compiled into it as well
+			bool loaded = ctx.hasLibrary(_filepath);
+
+			if (!loaded)
+				ctx.loadLibrary(_filepath);
+
+			try {
+				for (const auto & lib : ctx.getLibrary(_filepath)->getLibraryModules())
+					if (lib != moduleNameFromPath(_filepath))
+						module.dependencies.emplace_back("L:" + lib);
+			}
+			catch (...) {
+				if (!loaded)
+					ctx.removeLibrary(_filepath);
+
+				throw;
+			}
+
+			if (!loaded)
+				ctx.removeLibrary(_filepath);
+
+			sort(module.dependencies.begin(), module.dependencies.end());
+		}
+
+		journal.recordModule(_filepath, module);
+		return module;
+	}
+}
@@ -19,28 +19,36 @@ namespace CPPFAPIWrapper {
 	using namespace std;
 
 	FormsObject::FormsObject(FAPIModule * _module, int _type_id, void * _forms_obj, int _level)
-		: module(_module), parent(nullptr), type_id(_type_id), forms_obj(_forms_obj), level(_level) { TRACE_FNC("") 
+		: module(_module), parent(nullptr), type_id(_type_id), forms_obj(_forms_obj), level(_level), subclassed(false), mark_index(Property::NOT_MARKED) { TRACE_FNC("") 
 
 		auto deleter = [this](const void * data) { d2fobde_Destroy(this->getContext()->getContext(), const_cast<void *>(data)); };
 		forms_obj = unique_ptr<void, function<void(const void*)>>{ _forms_obj, deleter };
+		subclassed = d2fobis_IsSubclassed(getContext()->getContext(), _forms_obj) == D2FS_YES;
 	}
 
-	FormsObject::~FormsObject() { TRACE_FNC(""); }
+	FormsObject::FormsObject(FAPIModule * _module, int _type_id, int _level, bool _subclassed)
+		: module(_module), parent(nullptr), type_id(_type_id), level(_level), subclassed(_subclassed), mark_index(Property::NOT_MARKED) { TRACE_FNC("")
+
+		auto deleter = [this](const void * data) { d2fobde_Destroy(this->getContext()->getContext(), const_cast<void *>(data)); };
+		forms_obj = unique_ptr<void, function<void(const void*)>>{ nullptr, deleter };
+	}
+
+	FormsObject::~FormsObject() { TRACE_FNC("");
+		if (mark_index != Property::NOT_MARKED)
+			module->unmarkObject(this);
+	}
 
 	bool FormsObject::isSubclassed() const { TRACE_FNC("")
-		auto ctx = getContext()->getContext();
-		return d2fobis_IsSubclassed(ctx, forms_obj.get()) == D2FS_YES;
+		return subclassed;
 	}
 
 	vector<FormsObject *> FormsObject::findSources() { TRACE_FNC("")// TODO when testing is done
-		auto ctx = getContext()->getContext();
 		vector<FormsObject *> sources{ this };
 
 		while (true) {  // TODO
-			auto & f_obj = sources.back()->forms_obj;
 			auto & source_props = sources.back()->properties;
 
-			if (d2fobis_IsSubclassed(ctx, f_obj.get()) != D2FS_YES)
+			if (!sources.back()->isSubclassed())
 				break;
 
 			string mod_name = source_props.find(D2FP_PAR_FLNAM) != source_props.end() ? source_props[D2FP_PAR_FLNAM]->getValue() : "";
@@ -66,6 +74,9 @@ namespace CPPFAPIWrapper {
 					fapi_ctx->loadModule(path);
 
 				auto module_ = fapi_ctx->getModule(path);
+
+				if (!module_->isTraversed())
+					module_->traverseObjects();
 				string name2 = source_props.find(D2FP_PAR_SL2OBJ_NAM) != source_props.end() ? source_props[D2FP_PAR_SL2OBJ_NAM]->getValue() : "";
 				int typ2 = stoi(source_props.find(D2FP_PAR_SL2OBJ_TYP) != source_props.end() ? source_props[D2FP_PAR_SL2OBJ_TYP]->getValue() : "0");
 				string name1 = source_props.find(D2FP_PAR_SL1OBJ_NAM) != source_props.end() ? source_props[D2FP_PAR_SL1OBJ_NAM]->getValue() : "";
@@ -141,21 +152,29 @@ namespace CPPFAPIWrapper {
 	}
 
 	void FormsObject::markProperty(Property * _property) { TRACE_FNC("")
-		if (find(marked_properties.begin(), marked_properties.end(), _property) == marked_properties.end()) {
-			marked_properties.emplace_back(_property);
+		if (_property->mark_index != Property::NOT_MARKED)
+			return;
+
+		_property->mark_index = marked_properties.size();
+		marked_properties.emplace_back(_property);
+
+		if (marked_properties.size() == 1)
 			module->markObject(this);
-		}
 	}
 
 	void FormsObject::unmarkProperty(Property * _property) { TRACE_FNC("")
-		auto idx = find(marked_properties.begin(), marked_properties.end(), _property);
+		size_t index = _property->mark_index;
 
-		if (idx != marked_properties.end()) {
-			marked_properties.erase(idx);
+		if (index == Property::NOT_MARKED)
+			return;
 
-			if (marked_properties.empty())
-				module->unmarkObject(this);
-		}
+		marked_properties[index] = marked_properties.back();
+		marked_properties[index]->mark_index = index;
+		marked_properties.pop_back();
+		_property->mark_index = Property::NOT_MARKED;
+
+		if (marked_properties.empty())
+			module->unmarkObject(this);
 	}
 
 	void FormsObject::setProperty(Property * _property) { TRACE_FNC("")
@@ -165,6 +184,27 @@ namespace CPPFAPIWrapper {
 		_property->accept();
 	}
 
+	void FormsObject::applyMarkedProperties() { TRACE_FNC("")
+		size_t applied{ 0 };
+
+		try {
+			for (; applied < marked_properties.size(); ++applied) {
+				setProperty(marked_properties[applied]);
+				marked_properties[applied]->mark_index = Property::NOT_MARKED;
+			}
+		}
+		catch (...) {
+			marked_properties.erase(marked_properties.begin(), marked_properties.begin() + applied);
+
+			for (size_t i = 0; i < marked_properties.size(); ++i)
+				marked_properties[i]->mark_index = i;
+
+			throw;
+		}
+
+		marked_properties.clear();
+	}
+
 	void FormsObject::inheritAllProp() { TRACE_FNC("")
 		for_each(properties.begin(), properties.end(), [](const auto & _entry) { _entry.second->inherit(); });
 	}
@@ -186,6 +226,15 @@ namespace CPPFAPIWrapper {
 		return properties[D2FP_NAME]->getValue();
 	}
 
+	string FormsObject::getFullName() { TRACE_FNC("")
+		string fullname = getName();
+
+		for (auto curr = parent; curr && curr->parent; curr = curr->parent)
+			fullname = curr->getName() + "." + fullname;
+
+		return fullname;
+	}
+
 	unordered_map<int, vector<unique_ptr<FormsObject>>>& FormsObject::getChildren() { TRACE_FNC("")
 		return children;
 	}
@@ -194,10 +243,26 @@ namespace CPPFAPIWrapper {
 		return properties;
 	}
 
-	vector<Property*>& FormsObject::getMarkedProperties() { TRACE_FNC("")
+	const vector<Property*>& FormsObject::getMarkedProperties() const { TRACE_FNC("")
 		return marked_properties;
 	}
 
+	const vector<PlsqlToken> & FormsObject::getTokens() { TRACE_FNC("")
+		if (!tokens) {
+			int text_id = type_id == D2FFO_TRIGGER ? D2FP_TRG_TXT : D2FP_PGU_TXT;
+			auto text = properties.find(text_id);
+			bool has_code = (type_id == D2FFO_TRIGGER || type_id == D2FFO_PROG_UNIT || type_id == D2FFO_LIB_PROG_UNIT) && text != properties.end();
+
+			tokens = make_unique<vector<PlsqlToken>>(has_code ? tokenizePlsql(text->second->getValue()) : vector<PlsqlToken>{});
+		}
+
+		return *tokens;
+	}
+
+	void FormsObject::invalidateTokens() { TRACE_FNC("")
+		tokens.reset();
+	}
+
 	int FormsObject::getLevel() const { TRACE_FNC("")
 		return level;
 	}
@@ -207,9 +272,17 @@ namespace CPPFAPIWrapper {
 	}
 
 	void * FormsObject::getFormsObj() const { TRACE_FNC("")
+		if (!forms_obj)
+			module->attachNative();
+
 		return forms_obj.get();
 	}
 
+	void FormsObject::attachFormsObj(void * _forms_obj) { TRACE_FNC("")
+		forms_obj.release();
+		forms_obj.reset(_forms_obj);
+	}
+
 	FAPIContext * FormsObject::getContext() const { TRACE_FNC("")
 		return module->getContext();
 	}
@@ -0,0 +1,199 @@
+#include "GlobalScanner.h"
+
+#include "FAPILogger.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <cctype>
+
+namespace CPPFAPIWrapper {
+	using namespace std;
+
+	const char GLOBAL_PREFIX[] = "GLOBAL.";
+	const size_t GLOBAL_PREFIX_LENGTH = sizeof(GLOBAL_PREFIX) - 1;
+
+	// characters which can start a reference, comment, string literal or quoted identifier
+	constexpr array<bool, 256> makeScanStops() {
+		array<bool, 256> stops{};
+		stops[':'] = stops['-'] = stops['/'] = stops['\''] = stops['"'] = true;
+		return stops;
+	}
+
+	constexpr array<bool, 256> makeIdentifierChars() {
+		array<bool, 256> chars{};
+
+		for (int c = 'A'; c <= 'Z'; ++c)
+			chars[c] = chars[c - 'A' + 'a'] = true;
+
+		for (int c = '0'; c <= '9'; ++c)
+			chars[c] = true;
+
+		chars['_'] = chars['$'] = chars['#'] = true;
+		return chars;
+	}
+
+	constexpr array<bool, 256> SCAN_STOPS = makeScanStops();
+	constexpr array<bool, 256> IDENTIFIER_CHARS = makeIdentifierChars();
+
+	// length of "GLOBAL.NAME" starting at _begin, 0 if there is no global variable name
+	size_t matchGlobal(const char * _begin, const char * _end) {
+		if (static_cast<size_t>(_end - _begin) <= GLOBAL_PREFIX_LENGTH)
+			return 0;
+
+		// ASCII letters are compared with case bit set, '.' has it set already
+		for (size_t i = 0; i < GLOBAL_PREFIX_LENGTH; ++i)
+			if ((_begin[i] | 0x20) != (GLOBAL_PREFIX[i] | 0x20))
+				return 0;
+
+		const char * name_end = _begin + GLOBAL_PREFIX_LENGTH;
+
+		while (name_end < _end && IDENTIFIER_CHARS[static_cast<unsigned char>(*name_end)])
+			++name_end;
+
+		return name_end == _begin + GLOBAL_PREFIX_LENGTH ? 0 : name_end - _begin;
+	}
+
+	const char * findChar(const char * _begin, const char * _end, const char _char) {
+		const void * found = memchr(_begin, _char, _end - _begin);
+		return found ? static_cast<const char *>(found) : _end;
+	}
+
+	class GlobalScan
+	{
+	public:
+		GlobalScan(string_view _code, vector<GlobalReference> & _references)
+			: code(_code.data()), references(_references), line(1), counted(_code.data()), line_start(_code.data()) {}
+
+		void add(const char * _position, const char * _name, const size_t _length, const bool _quoted) {
+			// lines are counted only up to references, skipped text is not walked character by character
+			size_t newlines = count(counted, _position, '\n');
+
+			if (newlines) {
+				line += newlines;
+				line_start = _position;
+
+				while (line_start[-1] != '\n')
+					--line_start;
+			}
+
+			counted = _position;
+			string name{ _name, _length };
+
+			for (auto & c : name)
+				c = static_cast<char>(toupper(static_cast<unsigned char>(c)));
+
+			references.emplace_back(GlobalReference{ move(name), static_cast<size_t>(_position - code), line, static_cast<size_t>(_position - line_start) + 1, _quoted });
+		}
+
+	private:
+		const char * code;
+		vector<GlobalReference> & references;
+		size_t line;
+		const char * counted;
+		const char * line_start;
+	};
+
+	void scanGlobals(string_view _code, vector<GlobalReference> & _references) { TRACE_FNC(to_string(_code.size()))
+		const char * p = _code.data();
+		const char * end = p + _code.size();
+		GlobalScan scan{ _code, _references };
+
+		while (p < end) {
+			while (p < end && !SCAN_STOPS[static_cast<unsigned char>(*p)])
+				++p;
+
+			if (p == end)
+				break;
+
+			switch (*p) {
+			case ':': {
+				size_t length = matchGlobal(p + 1, end);
+
+				if (length) {
+					scan.add(p, p + 1 + GLOBAL_PREFIX_LENGTH, length - GLOBAL_PREFIX_LENGTH, false);
+					p += 1 + length;
+				}
+				else
+					++p;
+
+				break;
+			}
+			case '-':
+				p = p + 1 < end && p[1] == '-' ? findChar(p + 2, end, '\n') : p + 1;
+				break;
+			case '/':
+				if (p + 1 < end && p[1] == '*') {
+					p += 2;
+
+					while ((p = findChar(p, end, '*')) < end && (p + 1 == end || p[1] != '/'))
+						++p;
+
+					p = p < end ? p + 2 : end;
+				}
+				else
+					++p;
+
+				break;
+			case '"':
+				p = findChar(p + 1, end, '"');
+				p = p < end ? p + 1 : end;
+				break;
+			case '\'': {
+				const char * literal = p + 1;
+				const char * close = findChar(literal, end, '\'');
+				bool escaped{ false };
+
+				// '' is a quote inside literal
+				while (close + 1 < end && close[1] == '\'') {
+					escaped = true;
+					close = findChar(close + 2, end, '\'');
+				}
+
+				const char * name = literal < close && *literal == ':' ? literal + 1 : literal;
+				size_t length = escaped ? 0 : matchGlobal(name, close);
+
+				if (length && name + length == close)
+					scan.add(literal, name + GLOBAL_PREFIX_LENGTH, length - GLOBAL_PREFIX_LENGTH, true);
+
+				p = close < end ? close + 1 : end;
+				break;
+			}
+			}
+		}
+	}
+
+	vector<GlobalReference> scanGlobals(string_view _code) { TRACE_FNC(to_string(_code.size()))
+		vector<GlobalReference> references;
+		scanGlobals(_code, references);
+
+		return references;
+	}
+
+	void scanGlobals(string_view _code, const vector<PlsqlToken> & _tokens, vector<GlobalReference> & _references) { TRACE_FNC(to_string(_tokens.size()))
+		const char * code = _code.data();
+		GlobalScan scan{ _code, _references };
+
+		for (const auto & token : _tokens) {
+			const char * begin = code + token.offset;
+			const char * end = begin + token.length;
+
+			if (token.kind == PlsqlTokenKind::BIND) {
+				size_t length = matchGlobal(begin + 1, end);
+
+				if (length)
+					scan.add(begin, begin + 1 + GLOBAL_PREFIX_LENGTH, length - GLOBAL_PREFIX_LENGTH, false);
+			}
+			else if (token.kind == PlsqlTokenKind::STRING) {
+				const char * literal = begin + 1;
+				const char * close = token.length > 1 && end[-1] == '\'' ? end - 1 : end;	// unterminated literal ends with code
+				const char * name = literal < close && *literal == ':' ? literal + 1 : literal;
+				size_t length = matchGlobal(name, close);
+
+				// '' inside literal stops the name, so escaped literals never match
+				if (length && name + length == close)
+					scan.add(literal, name + GLOBAL_PREFIX_LENGTH, length - GLOBAL_PREFIX_LENGTH, true);
+			}
+		}
+	}
+}
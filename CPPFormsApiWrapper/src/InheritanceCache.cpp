@@ -0,0 +1,158 @@
+#include "InheritanceCache.h"
+
+#include "Exceptions.h"
+#include "FAPILogger.h"
+
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+namespace CPPFAPIWrapper {
+	using namespace std;
+
+	const string INHERITANCE_CACHE_HEADER = "CPPFAPIINHERITANCE\t1";
+
+	vector<string> splitFields(const string & _line, const char _delimiter) {
+		vector<string> fields;
+		stringstream stream{ _line };
+		string field;
+
+		while (getline(stream, field, _delimiter))
+			fields.emplace_back(field);
+
+		return fields;
+	}
+
+	string fingerprintToString(const FileFingerprint & _fingerprint) {
+		return to_string(_fingerprint.size) + "\t" + to_string(_fingerprint.mtime) + "\t" + to_string(_fingerprint.hash);
+	}
+
+	FileFingerprint fingerprintFromFields(const vector<string> & _fields, const size_t _offset) {
+		return FileFingerprint{ stoll(_fields.at(_offset)), stoll(_fields.at(_offset + 1)), stoull(_fields.at(_offset + 2)) };
+	}
+
+	InheritanceCache::InheritanceCache() { TRACE_FNC("") }
+
+	void InheritanceCache::load(const string & _filepath) { TRACE_FNC(_filepath)
+		modules.clear();
+		ifstream file{ _filepath };
+
+		if (!file.is_open())
+			return;
+
+		string line;
+		getline(file, line);
+
+		if (line != INHERITANCE_CACHE_HEADER)
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Invalid inheritance cache file: " + _filepath };
+
+		ModuleCheck * module{ nullptr };
+
+		try {
+			while (getline(file, line)) {
+				auto fields = splitFields(line, '\t');
+
+				if (fields.empty())
+					continue;
+
+				if (fields[0] == "M") {
+					module = &modules[fields.at(1)];
+					module->fingerprint = fingerprintFromFields(fields, 2);
+				}
+				else if (fields[0] == "S" && module)
+					module->sources[fields.at(1)] = SourceCheck{ fields.at(2), fingerprintFromFields(fields, 3) };
+				else if (fields[0] == "O" && module) {
+					ObjectCheck check;
+					check.source_modules = splitFields(fields.at(2), ',');
+
+					for (const auto & result : splitFields(fields.size() > 3 ? fields[3] : "", ',')) {
+						auto pos = result.find(':');
+						check.results.emplace_back(stoi(result.substr(0, pos)), static_cast<PropState>(stoi(result.substr(pos + 1))));
+					}
+
+					module->objects[fields.at(1)] = check;
+				}
+			}
+		}
+		catch (exception & ex) {
+			modules.clear();
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Invalid inheritance cache file: " + _filepath + " " + ex.what() };
+		}
+	}
+
+	void InheritanceCache::save(const string & _filepath) const { TRACE_FNC(_filepath)
+		ofstream file{ _filepath, ios::trunc };
+
+		if (!file.is_open())
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, _filepath };
+
+		file << INHERITANCE_CACHE_HEADER << "\n";
+
+		for (const auto & module : modules) {
+			file << "M\t" << module.first << "\t" << fingerprintToString(module.second.fingerprint) << "\n";
+
+			for (const auto & source : module.second.sources)
+				file << "S\t" << source.first << "\t" << source.second.path << "\t" << fingerprintToString(source.second.fingerprint) << "\n";
+
+			for (const auto & object : module.second.objects) {
+				string source_modules, results;
+
+				for (const auto & name : object.second.source_modules)
+					source_modules += (source_modules.empty() ? "" : ",") + name;
+
+				for (const auto & result : object.second.results)
+					results += (results.empty() ? "" : ",") + to_string(result.first) + ":" + to_string(static_cast<int>(result.second));
+
+				file << "O\t" << object.first << "\t" << source_modules << "\t" << results << "\n";
+			}
+		}
+	}
+
+	bool InheritanceCache::isValid(const string & _filepath) const { TRACE_FNC(_filepath)
+		auto module = modules.find(toUpper(_filepath));
+		return module != modules.end() && !fileChanged(module->second.fingerprint, _filepath);
+	}
+
+	unordered_set<string> InheritanceCache::getChangedSources(const string & _filepath) const { TRACE_FNC(_filepath)
+		unordered_set<string> changed;
+		auto module = modules.find(toUpper(_filepath));
+
+		if (module == modules.end())
+			return changed;
+
+		for (const auto & source : module->second.sources) {
+			if (fileChanged(source.second.fingerprint, source.second.path)) {
+				FAPILogger::debug("Source module changed: " + source.first);
+				changed.insert(source.first);
+			}
+		}
+
+		return changed;
+	}
+
+	bool InheritanceCache::hasModule(const string & _filepath) const { TRACE_FNC(_filepath)
+		return modules.find(toUpper(_filepath)) != modules.end();
+	}
+
+	ModuleCheck & InheritanceCache::getModule(const string & _filepath) { TRACE_FNC(_filepath)
+		return modules[toUpper(_filepath)];
+	}
+
+	void InheritanceCache::refreshModule(const string & _filepath) { TRACE_FNC(_filepath)
+		auto module = modules.find(toUpper(_filepath));
+
+		if (module == modules.end())
+			return;
+
+		module->second.fingerprint = fileFingerprint(_filepath);
+
+		for (auto & object : module->second.objects) {
+			auto & results = object.second.results;
+			results.erase(remove_if(results.begin(), results.end(), [](const auto & _result) { return _result.second == PropState::INHERITED; }), results.end());
+		}
+	}
+
+	void InheritanceCache::removeModule(const string & _filepath) { TRACE_FNC(_filepath)
+		modules.erase(toUpper(_filepath));
+	}
+}
@@ -0,0 +1,107 @@
+#include "InheritanceReport.h"
+
+#include "FAPIWrapper.h"
+#include "FAPILogger.h"
+
+#include <cstdio>
+
+namespace CPPFAPIWrapper {
+	using namespace std;
+
+	static string escapeJson(const string & _str) {
+		string escaped;
+		escaped.reserve(_str.size() + 2);
+
+		for (const char c : _str) {
+			switch (c) {
+				case '"': escaped += "\\\""; break;
+				case '\\': escaped += "\\\\"; break;
+				case '\n': escaped += "\\n"; break;
+				case '\r': escaped += "\\r"; break;
+				case '\t': escaped += "\\t"; break;
+				default:
+					if (static_cast<unsigned char>(c) < 0x20) {
+						char buf[8];
+						snprintf(buf, sizeof(buf), "\\u%04x", c);
+						escaped += buf;
+					}
+					else
+						escaped += c;
+			}
+		}
+
+		return escaped;
+	}
+
+	static string escapeCsv(const string & _str) {
+		if (_str.find_first_of(",\"\r\n") == string::npos)
+			return _str;
+
+		string escaped{ "\"" };
+
+		for (const char c : _str)
+			escaped += c == '"' ? string{ "\"\"" } : string(1, c);
+
+		return escaped + "\"";
+	}
+
+	static string typeName(const int _type_id) {
+		return _type_id >= 0 && static_cast<size_t>(_type_id) < obj_types.size() ? obj_types[_type_id] : to_string(_type_id);
+	}
+
+	static string propName(const int _prop_id) {
+		return _prop_id >= 0 && static_cast<size_t>(_prop_id) < prop_consts.size() ? prop_consts[_prop_id] : to_string(_prop_id);
+	}
+
+	string propStateToString(const PropState _state) {
+		switch (_state) {
+			case PropState::DEFAULT: return "DEFAULT";
+			case PropState::LOCAL: return "LOCAL";
+			case PropState::INHERITED: return "INHERITED";
+			default: return "OVERRIDEN";
+		}
+	}
+
+	InheritanceSink::~InheritanceSink() { TRACE_FNC("") }
+
+	void InheritanceSink::flush() { TRACE_FNC("") }
+
+	JsonLinesSink::JsonLinesSink(ostream & _stream)
+		: stream(_stream) { TRACE_FNC("") }
+
+	void JsonLinesSink::write(const InheritanceRecord & _record) { TRACE_FNC("")
+		stream << "{\"module\":\"" << escapeJson(_record.module)
+			<< "\",\"type\":\"" << typeName(_record.object_type)
+			<< "\",\"object\":\"" << escapeJson(_record.object)
+			<< "\",\"property\":\"" << propName(_record.prop_id)
+			<< "\",\"local\":\"" << escapeJson(_record.local_value)
+			<< "\",\"source\":\"" << escapeJson(_record.source_value)
+			<< "\",\"state\":\"" << propStateToString(_record.state) << "\"}\n";
+	}
+
+	void JsonLinesSink::flush() { TRACE_FNC("")
+		stream.flush();
+	}
+
+	CsvSink::CsvSink(ostream & _stream)
+		: stream(_stream), header_written(false) { TRACE_FNC("") }
+
+	void CsvSink::write(const InheritanceRecord & _record) { TRACE_FNC("")
+		if (!header_written) {
+			stream << "module,type,object,property,local,source,state\n";
+			header_written = true;
+		}
+
+		stream << escapeCsv(_record.module) << ","
+			<< typeName(_record.object_type) << ","
+			<< escapeCsv(_record.object) << ","
+			<< propName(_record.prop_id) << ","
+			<< escapeCsv(_record.local_value) << ","
+			<< escapeCsv(_record.source_value) << ","
+			<< propStateToString(_record.state) << "\n";
+	}
+
+	void CsvSink::flush() { TRACE_FNC("")
+		stream.flush();
+	}
+}
@@ -0,0 +1,148 @@
+#include "ModuleGraph.h"
+
+#include "FAPIUtil.h"
+
+#include "Exceptions.h"
+#include "FAPILogger.h"
+
+#include <set>
+#include <algorithm>
+
+namespace CPPFAPIWrapper {
+	using namespace std;
+
+	ModuleGraph::ModuleGraph() { TRACE_FNC("") }
+
+	void ModuleGraph::addModule(const string & _name, const string & _path, const ModuleKind _kind) { TRACE_FNC(_name + " | " + _path)
+		string name = toUpper(_name);
+		auto node = nodes.find(name);
+
+		if (node != nodes.end()) {
+			if (node->second.path.empty())
+				node->second.path = _path;
+
+			return;
+		}
+
+		nodes[name] = ModuleNode{ name, _path, _kind, {}, {} };
+	}
+
+	void ModuleGraph::addDependency(const string & _name, const string & _dependency) { TRACE_FNC(_name + " | " + _dependency)
+		string name = toUpper(_name);
+		string dependency = toUpper(_dependency);
+
+		if (!hasModule(name) || !hasModule(dependency))
+			throw FAPIException{ Reason::OBJECT_NOT_FOUND, __FILE__, __LINE__, name + " -> " + dependency };
+
+		nodes[name].dependencies.insert(dependency);
+		nodes[dependency].dependents.insert(name);
+	}
+
+	bool ModuleGraph::hasModule(const string & _name) const { TRACE_FNC(_name)
+		return nodes.find(toUpper(_name)) != nodes.end();
+	}
+
+	const ModuleNode & ModuleGraph::getModule(const string & _name) const { TRACE_FNC(_name)
+		auto node = nodes.find(toUpper(_name));
+
+		if (node == nodes.end())
+			throw FAPIException{ Reason::OBJECT_NOT_FOUND, __FILE__, __LINE__, _name };
+
+		return node->second;
+	}
+
+	const unordered_map<string, ModuleNode> & ModuleGraph::getModules() const { TRACE_FNC("")
+		return nodes;
+	}
+
+	vector<string> ModuleGraph::findCycle() const { TRACE_FNC("")
+		enum class Color { WHITE, GREY, BLACK };
+		unordered_map<string, Color> colors;
+		set<string> names;
+
+		for (const auto & entry : nodes) {
+			colors[entry.first] = Color::WHITE;
+			names.insert(entry.first);
+		}
+
+		for (const auto & start : names) {
+			if (colors[start] != Color::WHITE)
+				continue;
+
+			// iterative dfs, path holds current chain of grey nodes with iterators over their dependencies
+			vector<pair<string, vector<string>>> path;
+			auto push = [&](const string & _name) {
+				const auto & deps = nodes.at(_name).dependencies;
+				path.emplace_back(_name, vector<string>{ deps.begin(), deps.end() });
+				colors[_name] = Color::GREY;
+			};
+
+			push(start);
+
+			while (!path.empty()) {
+				auto & top = path.back();
+
+				if (top.second.empty()) {
+					colors[top.first] = Color::BLACK;
+					path.pop_back();
+					continue;
+				}
+
+				string next = top.second.back();
+				top.second.pop_back();
+
+				if (colors[next] == Color::GREY) {
+					vector<string> cycle;
+					auto begin = find_if(path.begin(), path.end(), [&next](const auto & _entry) { return _entry.first == next; });
+					transform(begin, path.end(), back_inserter(cycle), [](const auto & _entry) { return _entry.first; });
+					cycle.emplace_back(next);
+
+					return cycle;
+				}
+
+				if (colors[next] == Color::WHITE)
+					push(next);
+			}
+		}
+
+		return {};
+	}
+
+	bool ModuleGraph::hasCycle() const { TRACE_FNC("")
+		return !findCycle().empty();
+	}
+
+	vector<string> ModuleGraph::topologicalOrder() const { TRACE_FNC("")
+		unordered_map<string, size_t> remaining;
+		set<string> ready;
+		vector<string> order;
+
+		for (const auto & entry : nodes) {
+			remaining[entry.first] = entry.second.dependencies.size();
+
+			if (entry.second.dependencies.empty())
+				ready.insert(entry.first);
+		}
+
+		while (!ready.empty()) {
+			string name = *ready.begin();
+			ready.erase(ready.begin());
+			order.emplace_back(name);
+
+			for (const auto & dependent : nodes.at(name).dependents)
+				if (--remaining[dependent] == 0)
+					ready.insert(dependent);
+		}
+
+		if (order.size() != nodes.size()) {
+			string cycle;
+
+			for (const auto & name : findCycle())
+				cycle += (cycle.empty() ? "" : " -> ") + name;
+
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Module dependency cycle: " + cycle };
+		}
+
+		return order;
+	}
+}
@@ -0,0 +1,362 @@
+#include "ModuleImage.h"
+
+#include "Exceptions.h"
+#include "FAPILogger.h"
+
+#include <cstring>
+#include <cctype>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace CPPFAPIWrapper {
+	using namespace std;
+
+	bool imageNameEquals(const string_view _lhs, const string_view _rhs) {
+		if (_lhs.size() != _rhs.size())
+			return false;
+
+		for (size_t i = 0; i < _lhs.size(); ++i)
+			if (toupper(static_cast<unsigned char>(_lhs[i])) != toupper(static_cast<unsigned char>(_rhs[i])))
+				return false;
+
+		return true;
+	}
+
+	ImageProperty::ImageProperty(const ModuleImage * _image, uint32_t _index)
+		: image(_image), index(_index) {}
+
+	const SnapshotProperty & ImageProperty::record() const {
+		if (!image)
+			throw FAPIException{ Reason::OBJECT_NOT_FOUND, __FILE__, __LINE__, "ImageProperty" };
+
+		return image->property(index);
+	}
+
+	bool ImageProperty::isValid() const { TRACE_FNC("")
+		return image != nullptr;
+	}
+
+	int ImageProperty::getId() const { TRACE_FNC("")
+		return record().prop_id;
+	}
+
+	int ImageProperty::getType() const { TRACE_FNC("")
+		return record().prop_type;
+	}
+
+	string_view ImageProperty::getValue() const { TRACE_FNC("")
+		return image->text(record().value);
+	}
+
+	PropState ImageProperty::getState() const { TRACE_FNC("")
+		return static_cast<PropState>(record().state);
+	}
+
+	ImageObject::ImageObject(const ModuleImage * _image, uint32_t _index)
+		: image(_image), index(_index) {}
+
+	const SnapshotNode & ImageObject::record() const {
+		if (!image)
+			throw FAPIException{ Reason::OBJECT_NOT_FOUND, __FILE__, __LINE__, "ImageObject" };
+
+		return image->node(index);
+	}
+
+	bool ImageObject::isValid() const { TRACE_FNC("")
+		return image != nullptr;
+	}
+
+	int ImageObject::getId() const { TRACE_FNC("")
+		return record().type_id;
+	}
+
+	int ImageObject::getLevel() const { TRACE_FNC("")
+		return record().level;
+	}
+
+	string_view ImageObject::getName() const { TRACE_FNC("")
+		return image->text(record().name);
+	}
+
+	string ImageObject::getFullName() const { TRACE_FNC("")
+		string fullname{ getName() };
+
+		for (auto curr = getParent(); curr.isValid() && curr.record().parent != SNAPSHOT_NONE; curr = curr.getParent())
+			fullname = string{ curr.getName() } + "." + fullname;
+
+		return fullname;
+	}
+
+	bool ImageObject::isSubclassed() const { TRACE_FNC("")
+		return (record().flags & SNAPSHOT_SUBCLASSED) != 0;
+	}
+
+	ImageObject ImageObject::getParent() const { TRACE_FNC("")
+		auto parent = record().parent;
+		return parent == SNAPSHOT_NONE ? ImageObject{ nullptr, 0 } : ImageObject{ image, parent };
+	}
+
+	ImageObjectRange ImageObject::getChildren() const { TRACE_FNC("")
+		const SnapshotNode & node = record();
+
+		if (node.first_child > image->header->node_count || node.child_count > image->header->node_count - node.first_child)
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Corrupted module image: " + image->snapshot_path };
+
+		return ImageObjectRange{ image, node.first_child, node.child_count };
+	}
+
+	ImageObjectRange ImageObject::getObjects(const int _type_id) const { TRACE_FNC(to_string(_type_id))
+		const SnapshotNode & node = record();
+		getChildren();
+
+		// children are ordered by type id, so objects of one type are contiguous
+		uint32_t first = node.first_child, last = node.first_child + node.child_count;
+
+		while (first < last) {
+			uint32_t mid = first + (last - first) / 2;
+
+			if (image->nodes[mid].type_id < _type_id)
+				first = mid + 1;
+			else
+				last = mid;
+		}
+
+		uint32_t end = first;
+
+		while (end < node.first_child + node.child_count && image->nodes[end].type_id == _type_id)
+			++end;
+
+		return ImageObjectRange{ image, first, end - first };
+	}
+
+	ImageObject ImageObject::getObject(const int _type_id, const string_view _name) const { TRACE_FNC(to_string(_type_id) + " | " + string{ _name })
+		for (const auto child : getObjects(_type_id))
+			if (imageNameEquals(child.getName(), _name))
+				return child;
+
+		return ImageObject{ nullptr, 0 };
+	}
+
+	bool ImageObject::hasObject(const int _type_id, const string_view _name) const { TRACE_FNC(to_string(_type_id) + " | " + string{ _name })
+		return getObject(_type_id, _name).isValid();
+	}
+
+	ImagePropertyRange ImageObject::getProperties() const { TRACE_FNC("")
+		const SnapshotNode & node = record();
+
+		if (node.first_prop > image->header->prop_count || node.prop_count > image->header->prop_count - node.first_prop)
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Corrupted module image: " + image->snapshot_path };
+
+		return ImagePropertyRange{ image, node.first_prop, node.prop_count };
+	}
+
+	ImageProperty ImageObject::getProperty(const int _prop_id) const { TRACE_FNC(to_string(_prop_id))
+		const SnapshotNode & node = record();
+		getProperties();
+
+		// properties are ordered by property id
+		uint32_t first = node.first_prop, last = node.first_prop + node.prop_count;
+
+		while (first < last) {
+			uint32_t mid = first + (last - first) / 2;
+
+			if (image->props[mid].prop_id < _prop_id)
+				first = mid + 1;
+			else
+				last = mid;
+		}
+
+		return first < node.first_prop + node.prop_count && image->props[first].prop_id == _prop_id ? ImageProperty{ image, first } : ImageProperty{ nullptr, 0 };
+	}
+
+	bool ImageObject::hasProperty(const int _prop_id) const { TRACE_FNC(to_string(_prop_id))
+		return getProperty(_prop_id).isValid();
+	}
+
+	ModuleImage::ModuleImage(const string & _snapshot_path)
+		: snapshot_path(_snapshot_path), data(nullptr), size(0), header(nullptr), nodes(nullptr), props(nullptr), sources(nullptr), libraries(nullptr), strings(nullptr) { TRACE_FNC(_snapshot_path)
+#ifdef _WIN32
+		HANDLE file = CreateFileA(_snapshot_path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+		if (file == INVALID_HANDLE_VALUE)
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Couldn't open module image: " + _snapshot_path };
+
+		LARGE_INTEGER file_size;
+
+		if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0) {
+			// view stays valid after closing mapping and file handles
+			HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+			if (mapping) {
+				data = static_cast<const char *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+				size = data ? static_cast<size_t>(file_size.QuadPart) : 0;
+				CloseHandle(mapping);
+			}
+		}
+
+		CloseHandle(file);
+#else
+		int file = open(_snapshot_path.c_str(), O_RDONLY);
+
+		if (file < 0)
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Couldn't open module image: " + _snapshot_path };
+
+		struct stat file_stat;
+
+		if (fstat(file, &file_stat) == 0 && file_stat.st_size > 0) {
+			void * view = mmap(nullptr, static_cast<size_t>(file_stat.st_size), PROT_READ, MAP_SHARED, file, 0);
+
+			if (view != MAP_FAILED) {
+				data = static_cast<const char *>(view);
+				size = static_cast<size_t>(file_stat.st_size);
+			}
+		}
+
+		close(file);
+#endif
+
+		if (!data)
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Couldn't map module image: " + _snapshot_path };
+
+		auto fits = [this](const uint64_t _offset, const uint64_t _count, const size_t _size) { return _offset <= size && _offset % 8 == 0 && _count <= (size - _offset) / _size; };
+		header = reinterpret_cast<const SnapshotHeader *>(data);
+
+		if (size < sizeof(SnapshotHeader) || memcmp(header->magic, "CFAPISNP", sizeof(header->magic)) != 0 || header->version != SNAPSHOT_VERSION || header->node_count == 0
+			|| !fits(header->nodes_offset, header->node_count, sizeof(SnapshotNode)) || !fits(header->props_offset, header->prop_count, sizeof(SnapshotProperty))
+			|| !fits(header->sources_offset, header->source_count, sizeof(uint32_t)) || !fits(header->libraries_offset, header->library_count, sizeof(uint32_t))
+			|| !fits(header->strings_offset, header->string_count, sizeof(SnapshotString)) || header->string_data_offset > size) {
+			unmap();
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Invalid module image: " + _snapshot_path };
+		}
+
+		nodes = reinterpret_cast<const SnapshotNode *>(data + header->nodes_offset);
+		props = reinterpret_cast<const SnapshotProperty *>(data + header->props_offset);
+		sources = reinterpret_cast<const uint32_t *>(data + header->sources_offset);
+		libraries = reinterpret_cast<const uint32_t *>(data + header->libraries_offset);
+		strings = reinterpret_cast<const SnapshotString *>(data + header->strings_offset);
+	}
+
+	ModuleImage::~ModuleImage() { TRACE_FNC(snapshot_path)
+		unmap();
+	}
+
+	void ModuleImage::unmap() {
+		if (!data)
+			return;
+
+#ifdef _WIN32
+		UnmapViewOfFile(data);
+#else
+		munmap(const_cast<char *>(data), size);
+#endif
+
+		data = nullptr;
+		size = 0;
+	}
+
+	const SnapshotNode & ModuleImage::node(const uint32_t _index) const {
+		if (_index >= header->node_count)
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Corrupted module image: " + snapshot_path };
+
+		return nodes[_index];
+	}
+
+	const SnapshotProperty & ModuleImage::property(const uint32_t _index) const {
+		if (_index >= header->prop_count)
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Corrupted module image: " + snapshot_path };
+
+		return props[_index];
+	}
+
+	string_view ModuleImage::text(const uint32_t _id) const {
+		if (_id >= header->string_count || strings[_id].offset > size - header->string_data_offset || strings[_id].length > size - header->string_data_offset - strings[_id].offset)
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Corrupted module image: " + snapshot_path };
+
+		return string_view{ data + header->string_data_offset + strings[_id].offset, strings[_id].length };
+	}
+
+	bool ModuleImage::isValid(const string & _filepath) const { TRACE_FNC(_filepath)
+		return ModuleSnapshot::isValid(*header, _filepath);
+	}
+
+	string_view ModuleImage::getFilepath() const { TRACE_FNC("")
+		return text(header->path);
+	}
+
+	string ModuleImage::getName() const { TRACE_FNC("")
+		return moduleNameFromPath(string{ getFilepath() });
+	}
+
+	ImageObject ModuleImage::getRoot() const { TRACE_FNC("")
+		return ImageObject{ this, 0 };
+	}
+
+	size_t ModuleImage::getObjectCount() const { TRACE_FNC("")
+		return header->node_count;
+	}
+
+	vector<string_view> ModuleImage::getSourceModules() const { TRACE_FNC("")
+		vector<string_view> names;
+
+		for (uint32_t i = 0; i < header->source_count; ++i)
+			names.emplace_back(text(sources[i]));
+
+		return names;
+	}
+
+	vector<string_view> ModuleImage::getLibraryModules() const { TRACE_FNC("")
+		vector<string_view> names;
+
+		for (uint32_t i = 0; i < header->library_count; ++i)
+			names.emplace_back(text(libraries[i]));
+
+		return names;
+	}
+
+	bool ModuleImage::hasObject(const int _type_id, const string_view _name) const { TRACE_FNC(to_string(_type_id) + " | " + string{ _name })
+		return getRoot().hasObject(_type_id, _name);
+	}
+
+	ImageObject ModuleImage::getObject(const int _type_id, const string & _fullname) const { TRACE_FNC(to_string(_type_id) + " | " + _fullname)
+		vector<ImageObject> to_process{ getRoot() };
+		string_view rest{ _fullname };
+
+		while (!to_process.empty()) {
+			auto pos = rest.find('.');
+			string_view split = rest.substr(0, pos);
+			bool last = pos == string_view::npos;
+			rest = last ? string_view{} : rest.substr(pos + 1);
+			vector<ImageObject> new_process;
+
+			for (const auto & curr : to_process) {
+				for (const auto child : curr.getChildren()) {
+					if (!imageNameEquals(child.getName(), split))
+						continue;
+
+					if (last && child.getId() == _type_id)
+						return child;
+
+					new_process.emplace_back(child);
+				}
+			}
+
+			if (last)
+				break;
+
+			to_process.swap(new_process);
+		}
+
+		return ImageObject{ nullptr, 0 };
+	}
+
+	ImageObjectRange ModuleImage::getObjects(const int _type_id) const { TRACE_FNC(to_string(_type_id))
+		return getRoot().getObjects(_type_id);
+	}
+}
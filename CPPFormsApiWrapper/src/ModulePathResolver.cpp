@@ -0,0 +1,251 @@
+#include "ModulePathResolver.h"
+
+#include "Exceptions.h"
+#include "FAPILogger.h"
+
+#include <fstream>
+#include <cstdlib>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
+
+namespace CPPFAPIWrapper {
+	using namespace std;
+
+#ifdef _WIN32
+	string readRegistryKey(HKEY _hkey, string _key_path, string _key_name);
+
+	const char PATH_SEPARATOR = '\\';
+	const char * const SEARCH_PATH_DELIMITERS = ";";
+#else
+	const char PATH_SEPARATOR = '/';
+	const char * const SEARCH_PATH_DELIMITERS = ";:";
+#endif
+
+	void appendSearchPath(vector<string> & _directories, const string & _paths) {
+		size_t begin{ 0 };
+
+		while (begin <= _paths.size()) {
+			size_t end = _paths.find_first_of(SEARCH_PATH_DELIMITERS, begin);
+
+			if (end == string::npos)
+				end = _paths.size();
+
+			size_t first = _paths.find_first_not_of(" \t\r\n", begin);
+			size_t last = _paths.find_last_not_of(" \t\r\n", end - 1);
+
+			if (end > begin && first < end && last != string::npos && last >= first) {
+				string directory = _paths.substr(first, last - first + 1);
+
+				if (directory.back() != '\\' && directory.back() != '/')
+					directory += PATH_SEPARATOR;
+
+				_directories.emplace_back(directory);
+			}
+
+			begin = end + 1;
+		}
+	}
+
+	vector<string> listDirectory(const string & _directory) {
+		vector<string> filenames;
+#ifdef _WIN32
+		WIN32_FIND_DATAA data;
+		HANDLE find = FindFirstFileA((_directory + "*").c_str(), &data);
+
+		if (find == INVALID_HANDLE_VALUE)
+			return filenames;
+
+		do {
+			if (!(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+				filenames.emplace_back(data.cFileName);
+		} while (FindNextFileA(find, &data));
+
+		FindClose(find);
+#else
+		DIR * dir = opendir(_directory.c_str());
+
+		if (!dir)
+			return filenames;
+
+		while (dirent * entry = readdir(dir))
+			if (entry->d_type != DT_DIR)
+				filenames.emplace_back(entry->d_name);
+
+		closedir(dir);
+#endif
+
+		return filenames;
+	}
+
+	PathSource::~PathSource() { TRACE_FNC("") }
+
+	EnvironmentPathSource::EnvironmentPathSource(const string & _variable)
+		: variable(_variable) { TRACE_FNC(_variable) }
+
+	vector<string> EnvironmentPathSource::getDirectories() const { TRACE_FNC(variable)
+		vector<string> directories;
+		const char * paths = getenv(variable.c_str());
+
+		if (paths)
+			appendSearchPath(directories, paths);
+
+		return directories;
+	}
+
+	ConfigFilePathSource::ConfigFilePathSource(const string & _filepath)
+		: filepath(_filepath) { TRACE_FNC(_filepath) }
+
+	vector<string> ConfigFilePathSource::getDirectories() const { TRACE_FNC(filepath)
+		ifstream file{ filepath };
+
+		if (!file.is_open())
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Couldn't open path configuration: " + filepath };
+
+		vector<string> directories;
+		string line;
+
+		while (getline(file, line)) {
+			size_t first = line.find_first_not_of(" \t");
+
+			if (first != string::npos && line[first] != '#')
+				appendSearchPath(directories, line);
+		}
+
+		return directories;
+	}
+
+	ListPathSource::ListPathSource(const vector<string> & _directories) { TRACE_FNC("")
+		for (const auto & directory : _directories)
+			if (!directory.empty())
+				directories.emplace_back(directory.back() == '\\' || directory.back() == '/' ? directory : directory + PATH_SEPARATOR);
+	}
+
+	vector<string> ListPathSource::getDirectories() const { TRACE_FNC("")
+		return directories;
+	}
+
+#ifdef _WIN32
+	RegistryPathSource::RegistryPathSource(const string & _key_path, const string & _key_name)
+		: key_path(_key_path), key_name(_key_name) { TRACE_FNC(_key_path + " | " + _key_name) }
+
+	vector<string> RegistryPathSource::getDirectories() const { TRACE_FNC(key_name)
+		vector<string> directories;
+		appendSearchPath(directories, readRegistryKey(HKEY_LOCAL_MACHINE, key_path, key_name));
+
+		return directories;
+	}
+#endif
+
+	ModulePathResolver::ModulePathResolver(unique_ptr<PathSource> _source)
+		: source(_source ? move(_source) : defaultPathSource()), built(false) { TRACE_FNC("") }
+
+	unique_ptr<PathSource> ModulePathResolver::defaultPathSource() { TRACE_FNC("")
+		const char * paths = getenv("FORMS60_PATH");
+
+		if (paths && *paths)
+			return make_unique<EnvironmentPathSource>("FORMS60_PATH");
+
+#ifdef _WIN32
+		return make_unique<RegistryPathSource>();
+#else
+		return make_unique<ListPathSource>(vector<string>{});
+#endif
+	}
+
+	void ModulePathResolver::setPathSource(unique_ptr<PathSource> _source) { TRACE_FNC("")
+		lock_guard<mutex> lock{ resolver_mutex };
+		source = _source ? move(_source) : defaultPathSource();
+		built = false;
+	}
+
+	vector<string> ModulePathResolver::getDirectories() { TRACE_FNC("")
+		lock_guard<mutex> lock{ resolver_mutex };
+
+		if (!built)
+			build();
+
+		return directories;
+	}
+
+	string ModulePathResolver::resolve(const string & _filename) { TRACE_FNC(_filename)
+		string filepath;
+
+		if (!tryResolve(_filename, filepath))
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, _filename };
+
+		return filepath;
+	}
+
+	bool ModulePathResolver::tryResolve(const string & _filename, string & _filepath) { TRACE_FNC(_filename)
+		lock_guard<mutex> lock{ resolver_mutex };
+
+		if (!built)
+			build();
+
+		auto it = index.find(toUpper(_filename));
+
+		// file might have been added since directories were listed
+		if (it == index.end() && directoriesChanged()) {
+			build();
+			it = index.find(toUpper(_filename));
+		}
+
+		if (it == index.end())
+			return false;
+
+		_filepath = it->second;
+		return true;
+	}
+
+	void ModulePathResolver::refresh() { TRACE_FNC("")
+		lock_guard<mutex> lock{ resolver_mutex };
+		build();
+	}
+
+	void ModulePathResolver::invalidate() { TRACE_FNC("")
+		lock_guard<mutex> lock{ resolver_mutex };
+		built = false;
+	}
+
+	void ModulePathResolver::build() { TRACE_FNC("")
+		directories = source->getDirectories();
+		stamps.clear();
+		index.clear();
+
+		for (const auto & directory : directories) {
+			stamps.emplace_back(fileFingerprint(directory, false));
+
+			for (const auto & filename : listDirectory(directory)) {
+#ifdef _WIN32
+				index.emplace(toUpper(filename), toUpper(directory + filename));
+#else
+				index.emplace(toUpper(filename), directory + filename);
+#endif
+			}
+		}
+
+		FAPILogger::debug("Module path index: " + to_string(directories.size()) + " directories, " + to_string(index.size()) + " files");
+		built = true;
+	}
+
+	bool ModulePathResolver::directoriesChanged() const { TRACE_FNC("")
+		for (size_t i = 0; i < directories.size(); ++i) {
+			FileFingerprint current = fileFingerprint(directories[i], false);
+
+			if (current.size != stamps[i].size || current.mtime != stamps[i].mtime)
+				return true;
+		}
+
+		return false;
+	}
+
+	ModulePathResolver & getModulePathResolver() { TRACE_FNC("")
+		static ModulePathResolver resolver;
+		return resolver;
+	}
+}
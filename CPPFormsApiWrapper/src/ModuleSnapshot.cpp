@@ -0,0 +1,262 @@
+#include "ModuleSnapshot.h"
+
+#include "FAPIModule.h"
+#include "FormsObject.h"
+#include "Property.h"
+
+#include "Exceptions.h"
+#include "FAPILogger.h"
+
+#include "D2FDEF.H"
+
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+
+namespace CPPFAPIWrapper {
+	using namespace std;
+
+	const char SNAPSHOT_MAGIC[8] = { 'C', 'F', 'A', 'P', 'I', 'S', 'N', 'P' };
+
+	class SnapshotStrings {
+	public:
+		uint32_t intern(const string & _str) {
+			auto id = ids.find(_str);
+
+			if (id != ids.end())
+				return id->second;
+
+			uint32_t new_id = static_cast<uint32_t>(entries.size());
+			entries.emplace_back(SnapshotString{ static_cast<uint32_t>(data.size()), static_cast<uint32_t>(_str.size()) });
+			data.insert(data.end(), _str.begin(), _str.end());
+			data.push_back('\0');
+			ids.emplace(_str, new_id);
+
+			return new_id;
+		}
+
+		vector<SnapshotString> entries;
+		vector<char> data;
+
+	private:
+		unordered_map<string, uint32_t> ids;
+	};
+
+	uint64_t alignSnapshotOffset(const uint64_t _offset) {
+		return (_offset + 7) & ~static_cast<uint64_t>(7);
+	}
+
+	template<class T>
+	void writeSnapshotSection(ofstream & _file, const vector<T> & _items, const uint64_t _offset) {
+		static const char padding[8] = {};
+		uint64_t pos = static_cast<uint64_t>(_file.tellp());
+		_file.write(padding, static_cast<streamsize>(_offset - pos));
+
+		if (!_items.empty())
+			_file.write(reinterpret_cast<const char *>(_items.data()), static_cast<streamsize>(_items.size() * sizeof(T)));
+	}
+
+	string ModuleSnapshot::snapshotPath(const string & _directory, const string & _filepath) { TRACE_FNC(_directory + " | " + _filepath)
+		string key = toUpper(_filepath);
+		char hash[17];
+		snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(hashBytes(key.c_str(), key.size())));
+		string separator = _directory.empty() || _directory.back() == '/' || _directory.back() == '\\' ? "" : "/";
+
+		return _directory + separator + moduleNameFromPath(_filepath) + "_" + hash + ".snp";
+	}
+
+	void ModuleSnapshot::save(const FAPIModule & _module, const string & _snapshot_path) { TRACE_FNC(_snapshot_path)
+		if (!_module.root)
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Module is not traversed: " + _module.filepath };
+
+		SnapshotStrings strings;
+		vector<SnapshotNode> nodes;
+		vector<SnapshotProperty> props;
+		vector<uint32_t> sources, libraries;
+		vector<FormsObject *> order{ _module.root.get() };
+		vector<uint32_t> parents{ SNAPSHOT_NONE };
+
+		for (size_t i = 0; i < order.size(); ++i) {
+			FormsObject * fo = order[i];
+			auto & properties = fo->getProperties();
+			auto & children = fo->getChildren();
+			SnapshotNode node{ fo->getId(), fo->getLevel(), parents[i], strings.intern(fo->getName()), 0, 0, static_cast<uint32_t>(props.size()), 0, fo->isSubclassed() ? SNAPSHOT_SUBCLASSED : 0, 0 };
+
+			vector<int> prop_ids;
+			transform(properties.begin(), properties.end(), back_inserter(prop_ids), [](const auto & _entry) { return _entry.first; });
+			sort(prop_ids.begin(), prop_ids.end());
+
+			for (int prop_id : prop_ids) {
+				const auto & property = properties[prop_id];
+				props.emplace_back(SnapshotProperty{ prop_id, property->getType(), strings.intern(property->getValue()), static_cast<int32_t>(property->getOriginalState()) });
+			}
+
+			vector<int> child_types;
+			transform(children.begin(), children.end(), back_inserter(child_types), [](const auto & _entry) { return _entry.first; });
+			sort(child_types.begin(), child_types.end());
+			node.first_child = static_cast<uint32_t>(order.size());
+
+			for (int child_type : child_types) {
+				for (const auto & child : children[child_type]) {
+					order.emplace_back(child.get());
+					parents.emplace_back(static_cast<uint32_t>(i));
+				}
+			}
+
+			node.child_count = static_cast<uint32_t>(order.size()) - node.first_child;
+			node.prop_count = static_cast<uint32_t>(props.size()) - node.first_prop;
+			nodes.emplace_back(node);
+		}
+
+		for (const auto & source_mod : _module.source_modules)
+			sources.emplace_back(strings.intern(source_mod));
+
+		for (const auto & lib : _module.library_order)
+			libraries.emplace_back(strings.intern(lib));
+
+		FileFingerprint fingerprint = fileFingerprint(_module.filepath);
+		SnapshotHeader header;
+		memset(&header, 0, sizeof(header));
+		memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+		header.version = SNAPSHOT_VERSION;
+		header.path = strings.intern(toUpper(_module.filepath));
+		header.file_size = fingerprint.size;
+		header.file_mtime = fingerprint.mtime;
+		header.file_hash = fingerprint.hash;
+		header.node_count = static_cast<uint32_t>(nodes.size());
+		header.prop_count = static_cast<uint32_t>(props.size());
+		header.source_count = static_cast<uint32_t>(sources.size());
+		header.library_count = static_cast<uint32_t>(libraries.size());
+		header.string_count = static_cast<uint32_t>(strings.entries.size());
+		header.load_status = _module.load_status;
+		header.nodes_offset = alignSnapshotOffset(sizeof(header));
+		header.props_offset = alignSnapshotOffset(header.nodes_offset + nodes.size() * sizeof(SnapshotNode));
+		header.sources_offset = alignSnapshotOffset(header.props_offset + props.size() * sizeof(SnapshotProperty));
+		header.libraries_offset = alignSnapshotOffset(header.sources_offset + sources.size() * sizeof(uint32_t));
+		header.strings_offset = alignSnapshotOffset(header.libraries_offset + libraries.size() * sizeof(uint32_t));
+		header.string_data_offset = alignSnapshotOffset(header.strings_offset + strings.entries.size() * sizeof(SnapshotString));
+
+		// workers of a farm or pool can snapshot the same module at once
+		string tmp_path = temporaryPath(_snapshot_path);
+
+		{
+			ofstream file{ tmp_path, ios::binary | ios::trunc };
+
+			if (!file.is_open())
+				throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Couldn't write snapshot: " + tmp_path };
+
+			file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+			writeSnapshotSection(file, nodes, header.nodes_offset);
+			writeSnapshotSection(file, props, header.props_offset);
+			writeSnapshotSection(file, sources, header.sources_offset);
+			writeSnapshotSection(file, libraries, header.libraries_offset);
+			writeSnapshotSection(file, strings.entries, header.strings_offset);
+			writeSnapshotSection(file, strings.data, header.string_data_offset);
+
+			if (!file) {
+				file.close();
+				remove(tmp_path.c_str());
+				throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Couldn't write snapshot: " + tmp_path };
+			}
+		}
+
+		if (!replaceFile(tmp_path, _snapshot_path)) {
+			remove(tmp_path.c_str());
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Couldn't write snapshot: " + _snapshot_path };
+		}
+	}
+
+	bool ModuleSnapshot::isValid(const SnapshotHeader & _header, const string & _filepath) { TRACE_FNC(_filepath)
+		return memcmp(_header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) == 0 && _header.version == SNAPSHOT_VERSION
+			&& !fileChanged(FileFingerprint{ _header.file_size, _header.file_mtime, _header.file_hash }, _filepath);
+	}
+
+	bool ModuleSnapshot::load(FAPIModule & _module, const string & _snapshot_path) { TRACE_FNC(_snapshot_path)
+		ifstream file{ _snapshot_path, ios::binary | ios::ate };
+
+		if (!file.is_open())
+			return false;
+
+		vector<char> buffer(static_cast<size_t>(file.tellg()));
+		file.seekg(0);
+		file.read(buffer.data(), static_cast<streamsize>(buffer.size()));
+		SnapshotHeader header;
+
+		if (!file || buffer.size() < sizeof(header))
+			return false;
+
+		memcpy(&header, buffer.data(), sizeof(header));
+
+		if (!isValid(header, _module.filepath)) {
+			FAPILogger::debug("Snapshot is out of date: " + _snapshot_path);
+			return false;
+		}
+
+		auto fits = [&buffer](const uint64_t _offset, const uint64_t _count, const size_t _size) { return _offset <= buffer.size() && _count <= (buffer.size() - _offset) / _size; };
+
+		if (!fits(header.nodes_offset, header.node_count, sizeof(SnapshotNode)) || !fits(header.props_offset, header.prop_count, sizeof(SnapshotProperty))
+			|| !fits(header.sources_offset, header.source_count, sizeof(uint32_t)) || !fits(header.libraries_offset, header.library_count, sizeof(uint32_t))
+			|| !fits(header.strings_offset, header.string_count, sizeof(SnapshotString)) || header.node_count == 0) {
+			FAPILogger::warn("Corrupted snapshot: " + _snapshot_path);
+			return false;
+		}
+
+		const SnapshotNode * nodes = reinterpret_cast<const SnapshotNode *>(buffer.data() + header.nodes_offset);
+		const SnapshotProperty * props = reinterpret_cast<const SnapshotProperty *>(buffer.data() + header.props_offset);
+		const uint32_t * sources = reinterpret_cast<const uint32_t *>(buffer.data() + header.sources_offset);
+		const uint32_t * libraries = reinterpret_cast<const uint32_t *>(buffer.data() + header.libraries_offset);
+		const SnapshotString * strings = reinterpret_cast<const SnapshotString *>(buffer.data() + header.strings_offset);
+
+		auto str = [&](const uint32_t _id) {
+			if (_id >= header.string_count || header.string_data_offset + strings[_id].offset + strings[_id].length > buffer.size())
+				throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Corrupted snapshot string table" };
+
+			return string{ buffer.data() + header.string_data_offset + strings[_id].offset, strings[_id].length };
+		};
+
+		vector<FormsObject *> objects(header.node_count, nullptr);
+		unique_ptr<FormsObject> root;
+
+		try {
+			for (uint32_t i = 0; i < header.node_count; ++i) {
+				const SnapshotNode & node = nodes[i];
+
+				if ((i == 0) != (node.parent == SNAPSHOT_NONE) || (i > 0 && node.parent >= i) || node.first_prop + static_cast<uint64_t>(node.prop_count) > header.prop_count)
+					throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Corrupted snapshot node" };
+
+				auto fo = make_unique<FormsObject>(&_module, node.type_id, node.level, (node.flags & SNAPSHOT_SUBCLASSED) != 0);
+
+				for (uint32_t j = node.first_prop; j < node.first_prop + node.prop_count; ++j)
+					fo->getProperties().emplace(props[j].prop_id, make_unique<Property>(fo.get(), props[j].prop_id, props[j].prop_type, str(props[j].value), static_cast<PropState>(props[j].state)));
+
+				objects[i] = fo.get();
+
+				if (i == 0)
+					root = move(fo);
+				else
+					objects[node.parent]->addChild(fo.release());
+			}
+
+			_module.source_modules.clear();
+			_module.library_modules.clear();
+			_module.library_order.clear();
+
+			for (uint32_t i = 0; i < header.source_count; ++i)
+				_module.source_modules.insert(str(sources[i]));
+
+			for (uint32_t i = 0; i < header.library_count; ++i)
+				_module.addLibraryModule(str(libraries[i]));
+		}
+		catch (FAPIException & ex) {
+			FAPILogger::warn(_snapshot_path + ": " + ex.what());
+			return false;
+		}
+
+		_module.root = move(root);
+		_module.dependencies_known = true;
+		_module.load_status = header.load_status;
+
+		return true;
+	}
+}
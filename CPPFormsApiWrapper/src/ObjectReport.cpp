@@ -0,0 +1,157 @@
+#include "ObjectReport.h"
+
+#include "FAPIModule.h"
+#include "FormsObject.h"
+#include "Property.h"
+#include "FAPIWrapper.h"
+
+#include "Exceptions.h"
+#include "FAPILogger.h"
+
+#include <fstream>
+#include <algorithm>
+
+namespace CPPFAPIWrapper {
+	using namespace std;
+
+	const size_t REPORT_INDENT = 3;
+	const size_t REPORT_LABEL_WIDTH = 40;
+
+	string reportObjectType(const int _type_id) {
+		return _type_id >= 0 && static_cast<size_t>(_type_id) < obj_types.size() ? obj_types[_type_id] : to_string(_type_id);
+	}
+
+	string reportPropertyName(const int _prop_id) {
+		return _prop_id >= 0 && static_cast<size_t>(_prop_id) < prop_names.size() ? prop_names[_prop_id] : to_string(_prop_id);
+	}
+
+	ObjectReportWriter::ObjectReportWriter(ostream & _stream, const size_t _buffer_size)
+		: stream(_stream), buffer_size(max<size_t>(_buffer_size, 1)) { TRACE_FNC(to_string(_buffer_size))
+		buffer.reserve(buffer_size + 1024);
+	}
+
+	ObjectReportWriter::~ObjectReportWriter() { TRACE_FNC("")
+		try {
+			flush();
+		}
+		catch (exception & ex) {
+			FAPILogger::error(ex.what());
+		}
+	}
+
+	void ObjectReportWriter::writeModule(const FAPIModule & _module) { TRACE_FNC(_module.getFilepath())
+		FormsObject * root = _module.getRoot();
+
+		if (!root)
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Module is not loaded: " + _module.getFilepath() };
+
+		append("Object report: ");
+		append(_module.getFilepath());
+		append("\n\n");
+		writeObject(root, 0);
+		append("\n");
+	}
+
+	void ObjectReportWriter::flush() { TRACE_FNC(to_string(buffer.size()))
+		if (buffer.empty())
+			return;
+
+		stream.write(buffer.data(), buffer.size());
+		buffer.clear();
+
+		if (!stream)
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Couldn't write object report" };
+	}
+
+	void ObjectReportWriter::writeObject(FormsObject * _object, const size_t _depth) {
+		auto & properties = _object->getProperties();
+		auto name = properties.find(D2FP_NAME);
+		writeLine(_depth, '*', reportObjectType(_object->getId()), name != properties.end() && name->second ? name->second->getValue() : "");
+
+		// unordered maps, sorted so reports of same module are identical
+		vector<const Property *> sorted_properties;
+		sorted_properties.reserve(properties.size());
+
+		for (const auto & property : properties)
+			if (property.second)
+				sorted_properties.emplace_back(property.second.get());
+
+		sort(sorted_properties.begin(), sorted_properties.end(), [](const Property * _lhs, const Property * _rhs) { return _lhs->getId() < _rhs->getId(); });
+
+		for (const auto property : sorted_properties)
+			writeProperty(*property, _depth + 1);
+
+		auto & children = _object->getChildren();
+		vector<int> types;
+		types.reserve(children.size());
+
+		for (const auto & entry : children)
+			types.emplace_back(entry.first);
+
+		sort(types.begin(), types.end());
+
+		for (const auto type : types)
+			for (const auto & child : children.at(type))
+				writeObject(child.get(), _depth + 1);
+	}
+
+	void ObjectReportWriter::writeProperty(const Property & _property, const size_t _depth) {
+		writeLine(_depth, '-', reportPropertyName(_property.getId()), _property.getValue());
+	}
+
+	void ObjectReportWriter::writeLine(const size_t _depth, const char _marker, string_view _label, string_view _value) {
+		size_t indent = _depth * REPORT_INDENT;
+		buffer.append(indent, ' ');
+		buffer += _marker;
+		buffer += ' ';
+		append(_label);
+
+		if (!_value.empty()) {
+			buffer.append(_label.size() < REPORT_LABEL_WIDTH ? REPORT_LABEL_WIDTH - _label.size() : 1, ' ');
+			size_t value_column = indent + 2 + max(_label.size() + 1, REPORT_LABEL_WIDTH);
+
+			// PL/SQL code and other multi-line values continue under the first line
+			while (true) {
+				size_t end = _value.find('\n');
+				string_view line = _value.substr(0, end);
+
+				if (!line.empty() && line.back() == '\r')
+					line.remove_suffix(1);
+
+				append(line);
+
+				if (end == string_view::npos)
+					break;
+
+				buffer += '\n';
+				buffer.append(value_column, ' ');
+				_value.remove_prefix(end + 1);
+			}
+		}
+
+		buffer += '\n';
+
+		if (buffer.size() >= buffer_size)
+			flush();
+	}
+
+	void ObjectReportWriter::append(string_view _text) {
+		buffer.append(_text.data(), _text.size());
+	}
+
+	string objectReportPath(const string & _module_path, const string & _filepath) { TRACE_FNC(_module_path + " | " + _filepath)
+		const string & path = _filepath != "" ? _filepath : _module_path;
+		return path.substr(0, path.rfind(".")) + ".txt";
+	}
+
+	void writeObjectReportFile(const FAPIModule & _module, const string & _filepath) { TRACE_FNC(_filepath)
+		ofstream file{ _filepath, ios::binary | ios::trunc };
+
+		if (!file.is_open())
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Couldn't create object report: " + _filepath };
+
+		ObjectReportWriter writer{ file };
+		writer.writeModule(_module);
+		writer.flush();
+	}
+}
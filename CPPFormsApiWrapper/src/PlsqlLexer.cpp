@@ -0,0 +1,260 @@
+#include "PlsqlLexer.h"
+
+#include "FAPILogger.h"
+#include "Exceptions.h"
+
+#include <array>
+#include <cstring>
+#include <cctype>
+#include <unordered_set>
+#include <mutex>
+
+namespace CPPFAPIWrapper {
+	using namespace std;
+
+	enum class CharClass : uint8_t { OTHER, SPACE, LETTER, DIGIT, IDENTIFIER };
+
+	static constexpr array<CharClass, 256> makeCharClasses() {
+		array<CharClass, 256> classes{};
+
+		for (int c = 'A'; c <= 'Z'; ++c)
+			classes[c] = classes[c - 'A' + 'a'] = CharClass::LETTER;
+
+		for (int c = '0'; c <= '9'; ++c)
+			classes[c] = CharClass::DIGIT;
+
+		classes['_'] = classes['$'] = classes['#'] = CharClass::IDENTIFIER;
+		classes[' '] = classes['\t'] = classes['\n'] = classes['\r'] = classes['\f'] = classes['\v'] = CharClass::SPACE;
+		return classes;
+	}
+
+	constexpr array<CharClass, 256> CHAR_CLASSES = makeCharClasses();
+
+	static CharClass charClass(const char _char) {
+		return CHAR_CLASSES[static_cast<unsigned char>(_char)];
+	}
+
+	static bool isIdentifierChar(const char _char) {
+		return charClass(_char) >= CharClass::LETTER;
+	}
+
+	static bool isDigitChar(const char _char) {
+		return charClass(_char) == CharClass::DIGIT;
+	}
+
+	static const unordered_set<string> & getPlsqlKeywords() {
+		static const unordered_set<string> keywords{
+			"ALL", "ALTER", "AND", "ANY", "AS", "ASC", "AT", "BEGIN", "BETWEEN", "BODY", "BULK", "BY", "CASE", "CLOSE",
+			"COLLECT", "COMMIT", "CONSTANT", "CREATE", "CURRENT", "CURSOR", "DECLARE", "DEFAULT", "DELETE", "DESC",
+			"DISTINCT", "DROP", "ELSE", "ELSIF", "END", "EXCEPTION", "EXISTS", "EXIT", "FALSE", "FETCH", "FOR",
+			"FORALL", "FROM", "FUNCTION", "GOTO", "GROUP", "HAVING", "IF", "IN", "INSERT", "INTERSECT", "INTO", "IS",
+			"LIKE", "LOCK", "LOOP", "MINUS", "MOD", "NOCOPY", "NOT", "NULL", "OF", "ON", "OPEN", "OR", "ORDER",
+			"OTHERS", "OUT", "PACKAGE", "PRAGMA", "PRIOR", "PROCEDURE", "RAISE", "RECORD", "REF", "RETURN",
+			"REVERSE", "ROLLBACK", "ROWTYPE", "SAVEPOINT", "SELECT", "SET", "SUBTYPE", "TABLE", "THEN", "TO", "TRUE",
+			"TYPE", "UNION", "UNIQUE", "UPDATE", "USING", "VALUES", "WHEN", "WHERE", "WHILE", "WITH"
+		};
+
+		return keywords;
+	}
+
+	// operators tokenized as one symbol, longest first is not needed as all have two characters
+	const char * const COMPOUND_SYMBOLS[] = { ":=", "=>", "..", "||", "**", "<>", "!=", "~=", "^=", "<=", ">=", "<<", ">>" };
+
+	static size_t symbolLength(const char * _begin, const char * _end) {
+		if (_begin + 1 < _end)
+			for (const char * symbol : COMPOUND_SYMBOLS)
+				if (_begin[0] == symbol[0] && _begin[1] == symbol[1])
+					return 2;
+
+		return 1;
+	}
+
+	IdentifierTable::IdentifierTable() { TRACE_FNC("")
+	}
+
+	uint32_t IdentifierTable::intern(const string & _name) {
+		{
+			shared_lock<shared_mutex> lock{ table_mutex };
+			auto found = ids.find(_name);
+
+			if (found != ids.end())
+				return found->second;
+		}
+
+		unique_lock<shared_mutex> lock{ table_mutex };
+		auto inserted = ids.emplace(_name, static_cast<uint32_t>(names.size()));
+
+		if (inserted.second)
+			names.push_back(_name);
+
+		return inserted.first->second;
+	}
+
+	uint32_t IdentifierTable::find(const string & _name) const { TRACE_FNC(_name)
+		shared_lock<shared_mutex> lock{ table_mutex };
+		auto found = ids.find(_name);
+
+		return found == ids.end() ? NO_IDENTIFIER : found->second;
+	}
+
+	const string & IdentifierTable::getName(const uint32_t _id) const {
+		shared_lock<shared_mutex> lock{ table_mutex };
+
+		if (_id >= names.size())
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Unknown identifier " + to_string(_id) };
+
+		return names[_id];
+	}
+
+	size_t IdentifierTable::size() const { TRACE_FNC("")
+		shared_lock<shared_mutex> lock{ table_mutex };
+		return names.size();
+	}
+
+	IdentifierTable & getIdentifierTable() {
+		static IdentifierTable table;
+		return table;
+	}
+
+	static const char * findLiteralEnd(const char * _begin, const char * _end, const char _quote) {
+		const void * found = memchr(_begin, _quote, _end - _begin);
+		return found ? static_cast<const char *>(found) : _end;
+	}
+
+	const char * skipCommentOrLiteral(const char * _begin, const char * _end) {
+		const char * p = _begin;
+
+		if (p + 1 < _end && p[0] == '-' && p[1] == '-')
+			return findLiteralEnd(p + 2, _end, '\n');
+
+		if (p + 1 < _end && p[0] == '/' && p[1] == '*') {
+			p += 2;
+
+			while ((p = findLiteralEnd(p, _end, '*')) < _end && (p + 1 == _end || p[1] != '/'))
+				++p;
+
+			return p < _end ? p + 2 : _end;
+		}
+
+		if (p < _end && *p == '\'') {
+			p = findLiteralEnd(p + 1, _end, '\'');
+
+			// '' is a quote inside literal
+			while (p + 1 < _end && p[1] == '\'')
+				p = findLiteralEnd(p + 2, _end, '\'');
+
+			return p < _end ? p + 1 : _end;
+		}
+
+		if (p < _end && *p == '"') {
+			p = findLiteralEnd(p + 1, _end, '"');
+			return p < _end ? p + 1 : _end;
+		}
+
+		return _begin;
+	}
+
+	vector<PlsqlToken> tokenizePlsql(string_view _code, IdentifierTable & _table) { TRACE_FNC(to_string(_code.size()))
+		vector<PlsqlToken> tokens;
+		const char * code = _code.data();
+		const char * p = code;
+		const char * end = p + _code.size();
+		const auto & keywords = getPlsqlKeywords();
+		string upper;
+
+		// most units are a few hundred characters per dozen tokens
+		tokens.reserve(_code.size() / 6 + 1);
+
+		auto add = [&](const char * _begin, const char * _token_end, const uint32_t _id, const PlsqlTokenKind _kind) {
+			tokens.emplace_back(PlsqlToken{ static_cast<uint32_t>(_begin - code), static_cast<uint32_t>(_token_end - _begin), _id, _kind });
+		};
+
+		auto intern = [&](const char * _begin, const char * _name_end) {
+			upper.assign(_begin, _name_end);
+
+			for (auto & c : upper)
+				c = static_cast<char>(toupper(static_cast<unsigned char>(c)));
+
+			return _table.intern(upper);
+		};
+
+		while (p < end) {
+			const char * start = p;
+			CharClass cls = charClass(*p);
+
+			if (cls == CharClass::SPACE) {
+				++p;
+			}
+			else if (cls == CharClass::LETTER) {
+				while (p < end && isIdentifierChar(*p))
+					++p;
+
+				uint32_t id = intern(start, p);
+				add(start, p, id, keywords.count(upper) ? PlsqlTokenKind::KEYWORD : PlsqlTokenKind::IDENTIFIER);
+			}
+			else if (cls == CharClass::DIGIT || (*p == '.' && p + 1 < end && isDigitChar(p[1]))) {
+				while (p < end && isDigitChar(*p))
+					++p;
+
+				// fraction, but not range operator as in 1..10
+				if (p < end && *p == '.' && !(p + 1 < end && p[1] == '.')) {
+					++p;
+
+					while (p < end && isDigitChar(*p))
+						++p;
+				}
+
+				if (p < end && (*p == 'E' || *p == 'e')) {
+					const char * exponent = p + 1;
+
+					if (exponent < end && (*exponent == '+' || *exponent == '-'))
+						++exponent;
+
+					if (exponent < end && isDigitChar(*exponent)) {
+						p = exponent;
+
+						while (p < end && isDigitChar(*p))
+							++p;
+					}
+				}
+
+				add(start, p, NO_IDENTIFIER, PlsqlTokenKind::NUMBER);
+			}
+			else if (const char * skipped = skipCommentOrLiteral(p, end); skipped != p) {
+				p = skipped;
+
+				if (*start == '\'')
+					add(start, p, NO_IDENTIFIER, PlsqlTokenKind::STRING);
+				else if (*start == '"') {
+					const char * name_end = p - start > 1 && p[-1] == '"' ? p - 1 : p;
+
+					// quoted identifiers are case-sensitive
+					upper.assign(start + 1, name_end);
+					add(start, p, _table.intern(upper), PlsqlTokenKind::IDENTIFIER);
+				}
+			}
+			else if (*p == ':' && p + 1 < end && charClass(p[1]) == CharClass::LETTER) {
+				++p;
+
+				// :BLOCK.ITEM, :GLOBAL.NAME, :PARAMETER.NAME or :SYSTEM.VARIABLE
+				for (;;) {
+					while (p < end && isIdentifierChar(*p))
+						++p;
+
+					if (p + 1 < end && *p == '.' && isIdentifierChar(p[1]))
+						++p;
+					else
+						break;
+				}
+
+				add(start, p, intern(start + 1, p), PlsqlTokenKind::BIND);
+			}
+			else {
+				p += symbolLength(p, end);
+				add(start, p, intern(start, p), PlsqlTokenKind::SYMBOL);
+			}
+		}
+
+		return tokens;
+	}
+}
@@ -4,6 +4,7 @@
 #include "D2FOB.H"
 #include "FormsObject.h"
 #include "FAPIContext.h"
+#include "FAPIModule.h"
 #include "FAPIWrapper.h"
 
 #include "Exceptions.h"
@@ -12,12 +13,21 @@
 namespace CPPFAPIWrapper {
 	using namespace std;
 
+	// cached tokens of trigger/program unit are outdated when its text changes
+	void invalidateCodeTokens(FormsObject * _parent, const int _prop_id) {
+		if (_prop_id == D2FP_TRG_TXT || _prop_id == D2FP_PGU_TXT)
+			_parent->invalidateTokens();
+	}
+
 	Property::Property(FormsObject * _parent, int _prop_id, int _prop_type)
-		: parent(_parent), prop_id(_prop_id), prop_type(_prop_type), dirty(false) { TRACE_FNC(to_string(_prop_id) + " | " + to_string(_prop_type))
+		: parent(_parent), prop_id(_prop_id), prop_type(_prop_type), dirty(false), mark_index(NOT_MARKED) { TRACE_FNC(to_string(_prop_id) + " | " + to_string(_prop_type))
 		checkValue();
 		checkStateOnInit();
 	}
 
+	Property::Property(FormsObject * _parent, int _prop_id, int _prop_type, const string & _value, PropState _state)
+		: parent(_parent), original_state(_state), state(_state), prop_id(_prop_id), prop_type(_prop_type), dirty(false), mark_index(NOT_MARKED), original_value(_value), value(_value) { TRACE_FNC(to_string(_prop_id) + " | " + to_string(_prop_type)) }
+
 	FormsObject * Property::getParent() const { TRACE_FNC("")
 		return parent;
 	}
@@ -25,6 +35,7 @@ namespace CPPFAPIWrapper {
 	void Property::checkValue() { TRACE_FNC("")
 		value = getObjectValue();
 		original_value = value;
+		invalidateCodeTokens(parent, prop_id);
 	}
 
 	void Property::checkStateOnInit() { TRACE_FNC("")
@@ -41,36 +52,63 @@ namespace CPPFAPIWrapper {
 		original_state = state;
 	}
 
-	void Property::checkState() { TRACE_FNC("")
-		auto ctx = parent->getContext()->getContext();
-		auto obj = parent->getFormsObj();
+	bool Property::needsCheck() const { TRACE_FNC("")
+		return parent->isSubclassed() && state == PropState::LOCAL && !isNonInheritableProperty(prop_id); // we want to check only inherited_overriden states
+	}
 
-		if (!parent->isSubclassed() || state != PropState::LOCAL || isNonInheritableProperty(prop_id)) // we want to check only inherited_overriden states
+	void Property::checkState() { TRACE_FNC("")
+		if (!needsCheck())
 			return;
 
-		bool overriden{ false };
-		string source_prop;
+		checkState(parent->findSources());
+	}
 
-		for (const auto & source : parent->findSources()) {
-			auto & source_props = source->getProperties();
+	PropState Property::checkState(const vector<FormsObject *> & _sources) { TRACE_FNC("")
+		if (!needsCheck())
+			return state;
 
-			if (source_props.find(prop_id) != source_props.end()) {
-				source_prop = source_props[prop_id]->getValue();
+		string source_value;
+		PropState result = inspectState(_sources, source_value);
 
-				if (source_prop != value)
-					overriden = true;
+		// property no source defines is inherited as well, as it always was
+		if (result == state)
+			result = PropState::INHERITED;
 
-				break;
+		restoreState(result);
+
+		return result;
+	}
+
+	PropState Property::inspectState(const vector<FormsObject *> & _sources, string & _source_value) const { TRACE_FNC("")
+		if (!needsCheck())
+			return state;
+
+		for (const auto & source : _sources) {
+			auto & source_props = source->getProperties();
+			auto source_prop = source_props.find(prop_id);
+
+			if (source_prop != source_props.end()) {
+				_source_value = source_prop->second->getValue();
+				return _source_value != value ? PropState::OVERRIDEN : PropState::INHERITED;
 			}
 		}
 
-		if (overriden)
+		// nothing to compare with, reported as it is
+		return state;
+	}
+
+	void Property::restoreState(const PropState _result) { TRACE_FNC("")
+		if (_result == PropState::OVERRIDEN)
 			state = PropState::OVERRIDEN;
-		else { // values are equal but inheritance is broken so we'd like to restore it
+		else if (_result == PropState::INHERITED) { // values are equal but inheritance is broken so we'd like to restore it
+			auto ctx = parent->getContext()->getContext();
+			auto obj = parent->getFormsObj();
 			int status = d2fobip_InheritProp(ctx, obj, prop_id);
 
 			if (status != D2FS_SUCCESS)
 				throw FAPIException{ Reason::INTERNAL_ERROR, __FILE__, __LINE__, to_string(prop_id), status };
+
+			parent->getModule()->markModified();
 		}
 
 		original_state = state;
@@ -131,8 +169,10 @@ namespace CPPFAPIWrapper {
 		if (status != D2FS_SUCCESS)
 			throw FAPIException{ Reason::INTERNAL_ERROR, __FILE__, __LINE__, to_string(prop_id), status };
 
+		parent->getModule()->markModified();
 		value = getObjectValue();
 		dirty = (value != original_value);
+		invalidateCodeTokens(parent, prop_id);
 
 		if (dirty) {
 			if (state == PropState::LOCAL)
@@ -149,6 +189,7 @@ namespace CPPFAPIWrapper {
 			value = original_value;
 			state = original_state;
 			dirty = false;
+			invalidateCodeTokens(parent, prop_id);
 			parent->unmarkProperty(this);
 			return;
 		}
@@ -158,6 +199,7 @@ namespace CPPFAPIWrapper {
 
 		value = _value;
 		dirty = true;
+		invalidateCodeTokens(parent, prop_id);
 		state = state != PropState::OVERRIDEN ? PropState::LOCAL : state;
 		parent->markProperty(this);
 	}
@@ -0,0 +1,71 @@
+#include "TaskExecutor.h"
+
+#include "Exceptions.h"
+#include "FAPILogger.h"
+
+#include <algorithm>
+
+namespace CPPFAPIWrapper {
+	using namespace std;
+
+	TaskExecutor::TaskExecutor(const size_t _threads)
+		: stopping(false) { TRACE_FNC(to_string(_threads))
+		for (size_t i = 0; i < max<size_t>(_threads, 1); ++i)
+			threads.emplace_back([this]() { run(); });
+	}
+
+	TaskExecutor::~TaskExecutor() { TRACE_FNC("")
+		{
+			lock_guard<mutex> lock{ tasks_mutex };
+			stopping = true;
+		}
+
+		queued.notify_all();
+
+		for (auto & thread : threads)
+			thread.join();
+	}
+
+	void TaskExecutor::post(function<void()> _task) { TRACE_FNC("")
+		{
+			lock_guard<mutex> lock{ tasks_mutex };
+
+			if (stopping)
+				throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Task executor is stopping" };
+
+			tasks.emplace_back(move(_task));
+		}
+
+		queued.notify_one();
+	}
+
+	bool TaskExecutor::isExecutorThread() const { TRACE_FNC("")
+		auto id = this_thread::get_id();
+		return any_of(threads.begin(), threads.end(), [id](const thread & _thread) { return _thread.get_id() == id; });
+	}
+
+	void TaskExecutor::run() {
+		while (true) {
+			function<void()> task;
+
+			{
+				unique_lock<mutex> lock{ tasks_mutex };
+				queued.wait(lock, [this]() { return stopping || !tasks.empty(); });
+
+				// queue is drained before stopping
+				if (tasks.empty())
+					return;
+
+				task = move(tasks.front());
+				tasks.pop_front();
+			}
+
+			try {
+				task();
+			}
+			catch (exception & ex) { FAPILogger::error(ex.what()); }
+			// anything else would terminate the thread, with tasks still queued
+			catch (...) { FAPILogger::error("Unknown exception in task"); }
+		}
+	}
+}
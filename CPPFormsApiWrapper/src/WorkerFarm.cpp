@@ -0,0 +1,579 @@
+#include "WorkerFarm.h"
+
+#include "FAPIContext.h"
+
+#include "Exceptions.h"
+#include "FAPILogger.h"
+
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#include <signal.h>
+#include <sys/wait.h>
+#endif
+
+namespace CPPFAPIWrapper {
+	using namespace std;
+
+	const size_t FARM_NO_TASK = static_cast<size_t>(-1);
+
+	class ProcessFarmWorker : public FarmWorker
+	{
+	public:
+#ifdef _WIN32
+		ProcessFarmWorker(FarmPipe _pipe, HANDLE _process)
+			: pipe(move(_pipe)), process(_process) {}
+#else
+		ProcessFarmWorker(FarmPipe _pipe, pid_t _process)
+			: pipe(move(_pipe)), process(_process) {}
+#endif
+
+		~ProcessFarmWorker() {
+			terminate();
+		}
+
+		FarmPipe & getPipe() override {
+			return pipe;
+		}
+
+		void kill() override {
+#ifdef _WIN32
+			if (!process)
+				return;
+
+			if (WaitForSingleObject(process, 0) != WAIT_OBJECT_0)
+				TerminateProcess(process, 1);
+
+			WaitForSingleObject(process, INFINITE);
+			CloseHandle(process);
+			process = nullptr;
+#else
+			if (process <= 0)
+				return;
+
+			if (waitpid(process, nullptr, WNOHANG) == 0) {
+				::kill(process, SIGKILL);
+				waitpid(process, nullptr, 0);
+			}
+
+			process = -1;
+#endif
+		}
+
+		void terminate() override {
+			kill();
+			pipe = FarmPipe{};
+		}
+
+	private:
+		FarmPipe pipe;
+#ifdef _WIN32
+		HANDLE process;
+#else
+		pid_t process;
+#endif
+	};
+
+	class ThreadFarmWorker : public FarmWorker
+	{
+	public:
+		ThreadFarmWorker(function<string(const string &)> _handler, function<bool(const string &)> _crashes) {
+			intptr_t to_worker_read, to_worker_write, from_worker_read, from_worker_write;
+			FarmPipe::createOSPipe(to_worker_read, to_worker_write);
+
+			try {
+				FarmPipe::createOSPipe(from_worker_read, from_worker_write);
+			}
+			catch (...) {
+				FarmPipe{ to_worker_read, to_worker_write };
+				throw;
+			}
+
+			pipe = FarmPipe{ from_worker_read, to_worker_write };
+			worker_pipe = FarmPipe{ to_worker_read, from_worker_write };
+			worker = thread([this, _handler, _crashes]() {
+				runFarmWorker(worker_pipe, [this, &_handler, &_crashes](const string & _filepath) {
+					// worker goes away without an answer, like crashed process
+					if (_crashes && _crashes(_filepath)) {
+						worker_pipe = FarmPipe{};
+						return string{};
+					}
+
+					return _handler(_filepath);
+				});
+				// farm reads end of stream, like after process exit
+				worker_pipe = FarmPipe{};
+			});
+		}
+
+		~ThreadFarmWorker() {
+			terminate();
+		}
+
+		FarmPipe & getPipe() override {
+			return pipe;
+		}
+
+		// thread can't be killed, it finishes its current task and stops at end of stream
+		void kill() override {
+			pipe.closeWrite();
+		}
+
+		void terminate() override {
+			kill();
+
+			if (worker.joinable())
+				worker.join();
+
+			pipe = FarmPipe{};
+		}
+
+	private:
+		FarmPipe pipe;
+		FarmPipe worker_pipe;
+		thread worker;
+	};
+
+	FarmWorker::~FarmWorker() { TRACE_FNC("") }
+
+	WorkerLauncher::~WorkerLauncher() { TRACE_FNC("") }
+
+	ProcessWorkerLauncher::ProcessWorkerLauncher(const vector<string> & _command)
+		: command(_command) { TRACE_FNC("")
+		if (command.empty())
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Worker command is empty" };
+	}
+
+	unique_ptr<FarmWorker> ProcessWorkerLauncher::launch() { TRACE_FNC(command[0])
+		intptr_t to_worker_read, to_worker_write, from_worker_read, from_worker_write;
+		FarmPipe::createOSPipe(to_worker_read, to_worker_write);
+
+		try {
+			FarmPipe::createOSPipe(from_worker_read, from_worker_write);
+		}
+		catch (...) {
+			FarmPipe{ to_worker_read, to_worker_write };
+			throw;
+		}
+
+		FarmPipe pipe{ from_worker_read, to_worker_write };
+		// child's ends are closed on return, so worker exit is seen as end of stream
+		FarmPipe child_ends{ to_worker_read, from_worker_write };
+
+#ifdef _WIN32
+		string command_line;
+
+		for (const auto & arg : command) {
+			string quoted = arg;
+
+			if (arg.empty() || arg.find_first_of(" \t\"") != string::npos) {
+				quoted = "\"";
+
+				for (const char c : arg)
+					quoted += c == '"' ? string{ "\\\"" } : string(1, c);
+
+				quoted += "\"";
+			}
+
+			command_line += (command_line.empty() ? "" : " ") + quoted;
+		}
+
+		HANDLE child_in = reinterpret_cast<HANDLE>(to_worker_read);
+		HANDLE child_out = reinterpret_cast<HANDLE>(from_worker_write);
+		SetHandleInformation(child_in, HANDLE_FLAG_INHERIT, HANDLE_FLAG_INHERIT);
+		SetHandleInformation(child_out, HANDLE_FLAG_INHERIT, HANDLE_FLAG_INHERIT);
+
+		STARTUPINFOA startup_info;
+		PROCESS_INFORMATION process_info;
+		ZeroMemory(&startup_info, sizeof(startup_info));
+		ZeroMemory(&process_info, sizeof(process_info));
+		startup_info.cb = sizeof(startup_info);
+		startup_info.dwFlags = STARTF_USESTDHANDLES;
+		startup_info.hStdInput = child_in;
+		startup_info.hStdOutput = child_out;
+		startup_info.hStdError = GetStdHandle(STD_ERROR_HANDLE);
+
+		if (!CreateProcessA(nullptr, &command_line[0], nullptr, nullptr, TRUE, 0, nullptr, nullptr, &startup_info, &process_info))
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Couldn't start worker: " + command_line + " " + to_string(GetLastError()) };
+
+		CloseHandle(process_info.hThread);
+		HANDLE process = process_info.hProcess;
+#else
+		vector<char *> argv;
+
+		for (auto & arg : command)
+			argv.emplace_back(const_cast<char *>(arg.c_str()));
+
+		argv.emplace_back(nullptr);
+		pid_t process = fork();
+
+		if (process < 0)
+			throw FAPIException{ Reason::OTHER, __FILE__, __LINE__, "Couldn't start worker: " + command[0] };
+
+		if (process == 0) {
+			dup2(static_cast<int>(to_worker_read), 0);
+			dup2(static_cast<int>(from_worker_write), 1);
+			execvp(argv[0], argv.data());
+			_exit(127);
+		}
+#endif
+
+		return make_unique<ProcessFarmWorker>(move(pipe), process);
+	}
+
+	ThreadWorkerLauncher::ThreadWorkerLauncher(function<string(const string &)> _handler, function<bool(const string &)> _crashes)
+		: handler(_handler), crashes(_crashes) { TRACE_FNC("") }
+
+	unique_ptr<FarmWorker> ThreadWorkerLauncher::launch() { TRACE_FNC("")
+		return make_unique<ThreadFarmWorker>(handler, crashes);
+	}
+
+	struct FarmEvent {
+		size_t slot;
+		size_t generation;
+		bool closed;
+		FarmMessage message;
+	};
+
+	class FarmEventQueue
+	{
+	public:
+		void push(FarmEvent _event) {
+			{
+				lock_guard<mutex> lock{ events_mutex };
+				events.emplace_back(move(_event));
+			}
+
+			pushed.notify_one();
+		}
+
+		FarmEvent pop() {
+			unique_lock<mutex> lock{ events_mutex };
+			pushed.wait(lock, [this]() { return !events.empty(); });
+			FarmEvent event = move(events.front());
+			events.pop_front();
+
+			return event;
+		}
+
+		bool pop(FarmEvent & _event, const chrono::steady_clock::time_point _deadline) {
+			unique_lock<mutex> lock{ events_mutex };
+
+			if (!pushed.wait_until(lock, _deadline, [this]() { return !events.empty(); }))
+				return false;
+
+			_event = move(events.front());
+			events.pop_front();
+
+			return true;
+		}
+
+	private:
+		deque<FarmEvent> events;
+		mutex events_mutex;
+		condition_variable pushed;
+	};
+
+	struct FarmSlot {
+		unique_ptr<FarmWorker> worker;
+		thread reader;
+		deque<size_t> queue;
+		size_t generation{ 0 };
+		size_t task{ FARM_NO_TASK };
+		bool alive{ false };
+	};
+
+	WorkerFarm::WorkerFarm(WorkerLauncher & _launcher, const size_t _workers, const size_t _max_attempts, const chrono::milliseconds _shutdown_timeout)
+		: launcher(_launcher), workers(max<size_t>(_workers, 1)), max_attempts(max<size_t>(_max_attempts, 1)), shutdown_timeout(_shutdown_timeout) { TRACE_FNC(to_string(_workers)) }
+
+	vector<FarmResult> WorkerFarm::run(const vector<string> & _filepaths, function<void(const FarmResult &)> _on_result) { TRACE_FNC(to_string(_filepaths.size()))
+		vector<FarmResult> results;
+
+		for (const auto & filepath : _filepaths)
+			results.emplace_back(FarmResult{ filepath, false, "", 0 });
+
+		if (results.empty())
+			return results;
+
+		size_t count = min(workers, results.size());
+		size_t remaining = results.size();
+		size_t restarts{ 0 };
+		vector<FarmSlot> slots(count);
+		FarmEventQueue events;
+
+		for (size_t i = 0; i < results.size(); ++i)
+			slots[i * count / results.size()].queue.emplace_back(i);
+
+		auto complete = [&](const size_t _task, const bool _success, const string & _payload) {
+			results[_task].success = _success;
+			results[_task].payload = _payload;
+			--remaining;
+
+			if (_on_result)
+				_on_result(results[_task]);
+		};
+
+		auto start = [&](const size_t _slot) {
+			auto & slot = slots[_slot];
+
+			try {
+				slot.worker = launcher.launch();
+			}
+			catch (exception & ex) {
+				FAPILogger::error(ex.what());
+				return false;
+			}
+
+			slot.alive = true;
+			size_t generation = ++slot.generation;
+			FarmPipe * pipe = &slot.worker->getPipe();
+
+			slot.reader = thread([&events, pipe, _slot, generation]() {
+				FarmMessage message;
+
+				try {
+					while (pipe->read(message))
+						events.push(FarmEvent{ _slot, generation, false, message });
+				}
+				catch (exception & ex) { FAPILogger::error(ex.what()); }
+
+				events.push(FarmEvent{ _slot, generation, true, FarmMessage{} });
+			});
+
+			return true;
+		};
+
+		auto stop = [&](FarmSlot & _slot) {
+			if (!_slot.worker)
+				return;
+
+			_slot.worker->kill();
+
+			// pipe is closed only after its reader is finished
+			if (_slot.reader.joinable())
+				_slot.reader.join();
+
+			_slot.worker->terminate();
+			_slot.worker = nullptr;
+			_slot.alive = false;
+		};
+
+		// own queue first, then steal from the end of the longest queue
+		auto take = [&](const size_t _slot, size_t & _task) {
+			auto victim = max_element(slots.begin(), slots.end(), [](const FarmSlot & _a, const FarmSlot & _b) { return _a.queue.size() < _b.queue.size(); });
+
+			if (!slots[_slot].queue.empty()) {
+				_task = slots[_slot].queue.front();
+				slots[_slot].queue.pop_front();
+			}
+			else if (!victim->queue.empty()) {
+				_task = victim->queue.back();
+				victim->queue.pop_back();
+			}
+			else
+				return false;
+
+			return true;
+		};
+
+		auto dispatch = [&](const size_t _slot) {
+			auto & slot = slots[_slot];
+			size_t task;
+
+			if (!slot.alive || slot.task != FARM_NO_TASK || !take(_slot, task))
+				return;
+
+			slot.task = task;
+			++results[task].attempts;
+			// failed write means worker is gone, its reader reports that
+			slot.worker->getPipe().write(FarmMessage{ FarmMessageType::TASK, static_cast<uint32_t>(task), results[task].path });
+		};
+
+		auto redistribute = [&](const size_t _slot) {
+			auto & queue = slots[_slot].queue;
+
+			while (!queue.empty()) {
+				auto target = min_element(slots.begin(), slots.end(), [](const FarmSlot & _a, const FarmSlot & _b) { return _a.alive != _b.alive ? _a.alive : _a.queue.size() < _b.queue.size(); });
+
+				if (!target->alive) {
+					complete(queue.front(), false, "No workers available");
+					queue.pop_front();
+					continue;
+				}
+
+				target->queue.emplace_back(queue.front());
+				queue.pop_front();
+			}
+		};
+
+		auto crash = [&](const size_t _slot) {
+			auto & slot = slots[_slot];
+			size_t task = slot.task;
+			slot.task = FARM_NO_TASK;
+			stop(slot);
+
+			if (task != FARM_NO_TASK) {
+				FAPILogger::warn("Worker crashed while processing " + results[task].path);
+
+				if (results[task].attempts >= max_attempts)
+					complete(task, false, "Worker crashed");
+				else {
+					// retried by another worker, unless there is no other
+					size_t target = _slot;
+
+					for (size_t i = 0; i < slots.size(); ++i)
+						if (i != _slot && slots[i].alive && (target == _slot || slots[i].queue.size() < slots[target].queue.size()))
+							target = i;
+
+					slots[target].queue.emplace_front(task);
+				}
+			}
+
+			bool pending = any_of(slots.begin(), slots.end(), [](const FarmSlot & _s) { return !_s.queue.empty(); });
+
+			if (pending && restarts < count * max_attempts) {
+				++restarts;
+				start(_slot);
+			}
+
+			if (!slot.alive)
+				redistribute(_slot);
+		};
+
+		try {
+			for (size_t i = 0; i < count; ++i)
+				start(i);
+
+			for (size_t i = 0; i < count; ++i)
+				if (!slots[i].alive)
+					redistribute(i);
+
+			for (size_t i = 0; i < count; ++i)
+				dispatch(i);
+
+			while (remaining > 0) {
+				FarmEvent event = events.pop();
+				auto & slot = slots[event.slot];
+
+				if (event.generation != slot.generation || !slot.alive)
+					continue;
+
+				if (event.closed)
+					crash(event.slot);
+				else if ((event.message.type == FarmMessageType::RESULT || event.message.type == FarmMessageType::FAILURE) && event.message.task_id == slot.task) {
+					slot.task = FARM_NO_TASK;
+					complete(event.message.task_id, event.message.type == FarmMessageType::RESULT, event.message.payload);
+				}
+
+				for (size_t i = 0; i < count; ++i)
+					dispatch(i);
+			}
+		}
+		catch (...) {
+			for (auto & slot : slots)
+				stop(slot);
+
+			throw;
+		}
+
+		// workers exit on their own, those still running after timeout are killed
+		size_t running{ 0 };
+
+		for (auto & slot : slots) {
+			if (!slot.worker)
+				continue;
+
+			slot.worker->getPipe().write(FarmMessage{ FarmMessageType::SHUTDOWN, 0, "" });
+			slot.worker->getPipe().closeWrite();
+			++running;
+		}
+
+		auto deadline = chrono::steady_clock::now() + shutdown_timeout;
+		FarmEvent event;
+
+		while (running > 0 && events.pop(event, deadline)) {
+			auto & slot = slots[event.slot];
+
+			if (event.closed && event.generation == slot.generation && slot.alive) {
+				slot.alive = false;
+				--running;
+			}
+		}
+
+		if (running > 0)
+			FAPILogger::warn("Killing " + to_string(running) + " workers which didn't stop in time");
+
+		for (auto & slot : slots)
+			stop(slot);
+
+		return results;
+	}
+
+	int runFarmWorker(FarmPipe & _pipe, function<string(const string &)> _handler) { TRACE_FNC("")
+		FarmMessage message;
+
+		try {
+			while (_pipe.read(message)) {
+				if (message.type == FarmMessageType::SHUTDOWN)
+					break;
+
+				if (message.type != FarmMessageType::TASK)
+					continue;
+
+				FarmMessage reply{ FarmMessageType::RESULT, message.task_id, "" };
+
+				try {
+					reply.payload = _handler(message.payload);
+				}
+				catch (exception & ex) {
+					reply.type = FarmMessageType::FAILURE;
+					reply.payload = ex.what();
+				}
+
+				if (!_pipe.write(reply))
+					return 1;
+			}
+		}
+		catch (exception & ex) {
+			FAPILogger::error(ex.what());
+			return 1;
+		}
+
+		return 0;
+	}
+
+	int runFarmWorkerProcess(function<string(FAPIContext &, const string &)> _handler, const string & _connstring) { TRACE_FNC(_connstring)
+		FarmPipe pipe = FarmPipe::standardIO();
+		unique_ptr<FAPIContext> ctx;
+
+		try {
+			ctx = make_unique<FAPIContext>();
+
+			if (!_connstring.empty())
+				ctx->connectContextToDB(_connstring);
+		}
+		catch (exception & ex) {
+			FAPILogger::error(ex.what());
+			return 1;
+		}
+
+		return runFarmWorker(pipe, [&](const string & _filepath) {
+			try {
+				string result = _handler(*ctx, _filepath);
+				ctx->reset();
+
+				return result;
+			}
+			catch (...) {
+				ctx->reset();
+				throw;
+			}
+		});
+	}
+}
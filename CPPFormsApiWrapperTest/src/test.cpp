@@ -1,6 +1,36 @@
 #include "gtest/gtest.h"
 #include "FAPIWrapper.h"
 #include "FAPIContext.h"
+#include "FAPIForm.h"
+#include "FormsObject.h"
+#include "ModuleSnapshot.h"
+#include "InheritanceCache.h"
+#include "D2FPR.H"
+#include "ModuleGraph.h"
+#include "ContextPool.h"
+#include "BuiltinsCatalogue.h"
+#include "BuiltinsMatcher.h"
+#include "WorkerFarm.h"
+#include "ModulePathResolver.h"
+#include "Changeset.h"
+#include "FmxBuild.h"
+#include "GlobalScanner.h"
+#include "CodeIndex.h"
+#include "CallGraph.h"
+#include "CloneDetector.h"
+#include "TaskExecutor.h"
+#include "ObjectReport.h"
+#include "Exceptions.h"
+
+#include <fstream>
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <algorithm>
 
 using namespace CPPFAPIWrapper;
 
@@ -8,12 +38,937 @@ class FAPIWrapperTest : public ::testing::Test {
 
 };
 
+// scratch directory of tests, outside of Forms installation
+std::string testDirectory() {
+	auto directory = std::filesystem::temp_directory_path() / "CPPFAPIWrapperTest";
+	std::filesystem::create_directories(directory);
+
+	return directory.string();
+}
+
+struct SnapshotUnit {
+	int type_id;
+	std::string name;
+	std::string code;
+};
+
+// snapshot of a module with named root object and code units, so module can be restored without OracleForms
+void writeSnapshot(const std::string & _snapshot_path, const std::string & _filepath, const int _type_id, const int _load_status, const std::vector<SnapshotUnit> & _units = {}) {
+	FileFingerprint fingerprint = fileFingerprint(_filepath);
+	std::vector<SnapshotNode> nodes{ SnapshotNode{ _type_id, 0, SNAPSHOT_NONE, 0, 1, static_cast<uint32_t>(_units.size()), 0, 1, 0, 0 } };
+	std::vector<SnapshotProperty> props{ SnapshotProperty{ D2FP_NAME, D2FP_TYP_TEXT, 0, 0 } };
+	std::vector<std::string> values{ moduleNameFromPath(_filepath) };
+
+	for (const auto & unit : _units) {
+		uint32_t value = static_cast<uint32_t>(values.size());
+		nodes.emplace_back(SnapshotNode{ unit.type_id, 1, 0, value, 0, 0, static_cast<uint32_t>(props.size()), 2, 0, 0 });
+		props.emplace_back(SnapshotProperty{ D2FP_NAME, D2FP_TYP_TEXT, value, 0 });
+		props.emplace_back(SnapshotProperty{ unit.type_id == D2FFO_TRIGGER ? D2FP_TRG_TXT : D2FP_PGU_TXT, D2FP_TYP_TEXT, value + 1, 0 });
+		values.emplace_back(unit.name);
+		values.emplace_back(unit.code);
+	}
 
+	std::vector<SnapshotString> strings;
+	std::string string_data;
+
+	for (const auto & value : values) {
+		strings.emplace_back(SnapshotString{ static_cast<uint32_t>(string_data.size()), static_cast<uint32_t>(value.size()) });
+		string_data += value + '\0';
+	}
+
+	SnapshotHeader header{};
+	memcpy(header.magic, "CFAPISNP", sizeof(header.magic));
+	header.version = SNAPSHOT_VERSION;
+	header.file_size = fingerprint.size;
+	header.file_mtime = fingerprint.mtime;
+	header.file_hash = fingerprint.hash;
+	header.node_count = static_cast<uint32_t>(nodes.size());
+	header.prop_count = static_cast<uint32_t>(props.size());
+	header.string_count = static_cast<uint32_t>(strings.size());
+	header.load_status = _load_status;
+	header.nodes_offset = sizeof(header);
+	header.props_offset = header.nodes_offset + nodes.size() * sizeof(SnapshotNode);
+	header.sources_offset = header.libraries_offset = header.strings_offset = header.props_offset + props.size() * sizeof(SnapshotProperty);
+	header.string_data_offset = header.strings_offset + strings.size() * sizeof(SnapshotString);
+
+	std::ofstream file{ _snapshot_path, std::ios::binary | std::ios::trunc };
+	file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char *>(nodes.data()), nodes.size() * sizeof(SnapshotNode));
+	file.write(reinterpret_cast<const char *>(props.data()), props.size() * sizeof(SnapshotProperty));
+	file.write(reinterpret_cast<const char *>(strings.data()), strings.size() * sizeof(SnapshotString));
+	file.write(string_data.data(), string_data.size());
+}
+
+// module was restored from snapshot written by writeSnapshot, not loaded by OracleForms
+bool isRestored(const FAPIModule * _module) {
+	return _module && _module->isTraversed() && !_module->isNative();
+}
 
 TEST_F(FAPIWrapperTest, LoadingBuiltins) {
 	ASSERT_TRUE(builtins.empty());
 	
-	createContext();
+	auto ctx = createContext();
+
+	ASSERT_TRUE(builtins.empty());
+
+	ctx->getBuiltins();
 
 	ASSERT_FALSE(builtins.empty());
 }
+
+TEST_F(FAPIWrapperTest, ModuleGraphOrder) {
+	ModuleGraph graph;
+	graph.addModule("form", "", ModuleKind::FORM);
+	graph.addModule("source", "", ModuleKind::FORM);
+	graph.addModule("lib", "", ModuleKind::LIBRARY);
+	graph.addDependency("form", "source");
+	graph.addDependency("form", "lib");
+	graph.addDependency("source", "lib");
+
+	ASSERT_FALSE(graph.hasCycle());
+	ASSERT_EQ(graph.topologicalOrder(), (std::vector<std::string>{ "LIB", "SOURCE", "FORM" }));
+}
+
+TEST_F(FAPIWrapperTest, ModuleGraphCycle) {
+	ModuleGraph graph;
+	graph.addModule("A", "", ModuleKind::FORM);
+	graph.addModule("B", "", ModuleKind::FORM);
+	graph.addDependency("A", "B");
+	graph.addDependency("B", "A");
+
+	ASSERT_TRUE(graph.hasCycle());
+	ASSERT_THROW(graph.topologicalOrder(), FAPIException);
+}
+
+TEST_F(FAPIWrapperTest, LoadingWithoutTraversal) {
+	std::string filepath = testDirectory() + "/Untraversed_Test.fmb";
+	std::ofstream{ filepath } << "form";
+
+	FAPIContext ctx;
+	ctx.loadModuleWithSources(filepath, false, false, false);
+
+	ASSERT_TRUE(ctx.hasModule(filepath));
+	ASSERT_FALSE(ctx.getModule(filepath)->isTraversed());
+
+	ctx.removeModule(filepath);
+	std::remove(filepath.c_str());
+}
+
+TEST_F(FAPIWrapperTest, ContextPoolReuse) {
+	ContextPool pool(1);
+	FAPIContext * ctx{ nullptr };
+
+	{
+		auto lease = pool.acquire();
+		ctx = lease.get();
+
+		ASSERT_EQ(pool.available(), 0u);
+		ASSERT_FALSE(pool.tryAcquire().isValid());
+	}
+
+	ASSERT_EQ(pool.available(), 1u);
+	ASSERT_EQ(pool.acquire().get(), ctx);
+}
+
+TEST_F(FAPIWrapperTest, TaskExecutorExceptions) {
+	TaskExecutor executor;
+	auto failed = executor.submit([]() -> int { throw 7; });
+	executor.post([]() { throw 8; });
+	auto result = executor.submit([]() { return 9; });
+
+	ASSERT_THROW(failed.get(), int);
+	ASSERT_EQ(result.get(), 9);
+}
+
+TEST_F(FAPIWrapperTest, BuiltinsCatalogueLookup) {
+	BuiltinsCatalogue catalogue;
+	catalogue.build(60052902, { { "STANDARD", { "SET_ITEM_PROPERTY", "GO_BLOCK" } }, { "WEB", { "SHOW_DOCUMENT" } } });
+
+	ASSERT_TRUE(catalogue.contains("set_item_property"));
+	ASSERT_TRUE(catalogue.contains("Web.Show_Document"));
+	ASSERT_FALSE(catalogue.contains("GO_BLOC"));
+	ASSERT_FALSE(catalogue.contains("WEB"));
+}
+
+TEST_F(FAPIWrapperTest, BuiltinsCatalogueFile) {
+	std::string filepath = BuiltinsCatalogue::cataloguePath(testDirectory(), 60052902);
+	BuiltinsCatalogue saved;
+	saved.build(60052902, { { "STANDARD", { "SET_ITEM_PROPERTY", "GO_BLOCK" } }, { "WEB", { "SHOW_DOCUMENT" } } });
+	saved.save(filepath);
+
+	BuiltinsCatalogue loaded;
+	ASSERT_TRUE(loaded.load(filepath, 60052902));
+	ASSERT_TRUE(loaded.contains("web.show_document"));
+	ASSERT_FALSE(loaded.load(filepath, 60052903));
+
+	// catalogue cut after first package
+	std::string content;
+	{
+		std::ifstream file{ filepath };
+		std::string line;
+
+		for (int i = 0; i < 2 && std::getline(file, line); ++i)
+			content += line + "\n";
+	}
+	{
+		std::ofstream file{ filepath, std::ios::trunc };
+		file << content;
+	}
+
+	ASSERT_FALSE(loaded.load(filepath, 60052902));
+	std::filesystem::remove(filepath);
+}
+
+TEST_F(FAPIWrapperTest, BuiltinsMatcherCounts) {
+	BuiltinsCatalogue catalogue;
+	catalogue.build(60052902, { { "STANDARD", { "MESSAGE", "GO_BLOCK" } }, { "WEB", { "SHOW_DOCUMENT" } } });
+	BuiltinsMatcher matcher{ catalogue };
+
+	auto counts = matcher.countBuiltins("go_block('B'); Message('go_block'); -- message\n web.show_document(u); my_go_block; rec.message := 1; MESSAGE;");
+
+	ASSERT_EQ(counts.size(), 3u);
+	ASSERT_EQ(counts["GO_BLOCK"], 1u);
+	ASSERT_EQ(counts["MESSAGE"], 2u);
+	ASSERT_EQ(counts["WEB.SHOW_DOCUMENT"], 1u);
+}
+
+TEST_F(FAPIWrapperTest, AnalyseModulesIndices) {
+	std::string directory = testDirectory();
+	std::string first_path = directory + "/Analyse_First.fmb";
+	std::string second_path = directory + "/Analyse_Second.fmb";
+
+	for (const auto & filepath : { first_path, second_path }) {
+		std::ofstream{ filepath } << filepath;
+		writeSnapshot(ModuleSnapshot::snapshotPath(directory, filepath), filepath, D2FFO_FORM_MODULE, D2FS_SUCCESS, {});
+	}
+
+	FAPIContext ctx;
+	ctx.setSnapshotDirectory(directory);
+	ctx.loadModule(second_path);
+
+	// already loaded module is listed with other case of its path, duplicate gets index of its first occurrence
+	std::vector<std::pair<std::string, size_t>> analysed;
+	std::mutex analysed_mutex;
+
+	ASSERT_EQ(ctx.analyseModules({ first_path, toUpper(second_path), first_path }, [&](const FAPIForm & _module, const size_t _index) {
+		std::lock_guard<std::mutex> lock{ analysed_mutex };
+		analysed.emplace_back(_module.getFilepath(), _index);
+	}, 2), 2u);
+
+	std::sort(analysed.begin(), analysed.end(), [](const auto & _lhs, const auto & _rhs) { return _lhs.second < _rhs.second; });
+
+	ASSERT_EQ(analysed.size(), 2u);
+	ASSERT_EQ(analysed[0], std::make_pair(first_path, size_t{ 0 }));
+	ASSERT_EQ(analysed[1], std::make_pair(second_path, size_t{ 1 }));
+	ASSERT_TRUE(ctx.hasModule(second_path));
+	ASSERT_FALSE(ctx.hasModule(first_path));
+
+	ctx.reset();
+
+	for (const auto & filepath : { first_path, second_path }) {
+		std::remove(ModuleSnapshot::snapshotPath(directory, filepath).c_str());
+		std::remove(filepath.c_str());
+	}
+}
+
+TEST_F(FAPIWrapperTest, FarmProtocolRoundTrip) {
+	FarmDecoder decoder;
+	std::string stream = encodeFarmMessage({ FarmMessageType::TASK, 7, "module.fmb" }) + encodeFarmMessage({ FarmMessageType::SHUTDOWN, 0, "" });
+	FarmMessage message;
+
+	for (const char c : stream)
+		decoder.feed(&c, 1);
+
+	ASSERT_TRUE(decoder.next(message));
+	ASSERT_EQ(message.type, FarmMessageType::TASK);
+	ASSERT_EQ(message.task_id, 7u);
+	ASSERT_EQ(message.payload, "module.fmb");
+	ASSERT_TRUE(decoder.next(message));
+	ASSERT_EQ(message.type, FarmMessageType::SHUTDOWN);
+	ASSERT_FALSE(decoder.next(message));
+}
+
+TEST_F(FAPIWrapperTest, WorkerFarmThreads) {
+	ThreadWorkerLauncher launcher([](const std::string & _path) {
+		if (_path == "broken")
+			throw std::runtime_error("broken module");
+
+		return "done " + _path;
+	});
+	WorkerFarm farm(launcher, 3);
+	auto results = farm.run({ "a", "b", "broken", "c", "d" });
+
+	ASSERT_EQ(results.size(), 5u);
+	ASSERT_TRUE(results[0].success);
+	ASSERT_EQ(results[0].payload, "done a");
+	ASSERT_FALSE(results[2].success);
+	ASSERT_EQ(results[2].payload, "broken module");
+	ASSERT_EQ(results[4].payload, "done d");
+}
+
+TEST_F(FAPIWrapperTest, WorkerFarmCrashes) {
+	std::mutex crashes_mutex;
+	std::map<std::string, int> crashes;
+	ThreadWorkerLauncher launcher([](const std::string & _path) { return "done " + _path; }, [&](const std::string & _path) {
+		std::lock_guard<std::mutex> lock{ crashes_mutex };
+
+		// flaky module crashes its first worker only, poisoned one crashes every worker
+		return _path == "poisoned" || (_path == "flaky" && crashes[_path]++ == 0);
+	});
+	WorkerFarm farm(launcher, 2, 3);
+	auto results = farm.run({ "a", "flaky", "poisoned", "b" });
+
+	ASSERT_EQ(results.size(), 4u);
+	ASSERT_TRUE(results[1].success);
+	ASSERT_EQ(results[1].payload, "done flaky");
+	ASSERT_EQ(results[1].attempts, 2u);
+	ASSERT_FALSE(results[2].success);
+	ASSERT_EQ(results[2].payload, "Worker crashed");
+	ASSERT_EQ(results[2].attempts, 3u);
+	ASSERT_TRUE(results[0].success);
+	ASSERT_TRUE(results[3].success);
+}
+
+// answers tasks, but ignores shutdown and runs until killed
+class HangingFarmWorker : public FarmWorker {
+public:
+	HangingFarmWorker() {
+		intptr_t to_worker_read, to_worker_write, from_worker_read, from_worker_write;
+		FarmPipe::createOSPipe(to_worker_read, to_worker_write);
+		FarmPipe::createOSPipe(from_worker_read, from_worker_write);
+		pipe = FarmPipe{ from_worker_read, to_worker_write };
+		worker_pipe = FarmPipe{ to_worker_read, from_worker_write };
+		worker = std::thread([this]() {
+			FarmMessage message;
+
+			while (worker_pipe.read(message))
+				if (message.type == FarmMessageType::TASK)
+					worker_pipe.write({ FarmMessageType::RESULT, message.task_id, "done" });
+
+			std::unique_lock<std::mutex> lock{ killed_mutex };
+			killed_signal.wait(lock, [this]() { return killed; });
+			worker_pipe = FarmPipe{};
+		});
+	}
+
+	~HangingFarmWorker() { terminate(); }
+
+	FarmPipe & getPipe() override { return pipe; }
+
+	void kill() override {
+		{
+			std::lock_guard<std::mutex> lock{ killed_mutex };
+			killed = true;
+		}
+
+		killed_signal.notify_all();
+	}
+
+	void terminate() override {
+		kill();
+
+		if (worker.joinable())
+			worker.join();
+
+		pipe = FarmPipe{};
+	}
+
+private:
+	FarmPipe pipe;
+	FarmPipe worker_pipe;
+	std::thread worker;
+	std::mutex killed_mutex;
+	std::condition_variable killed_signal;
+	bool killed{ false };
+};
+
+class HangingWorkerLauncher : public WorkerLauncher {
+public:
+	std::unique_ptr<FarmWorker> launch() override { return std::make_unique<HangingFarmWorker>(); }
+};
+
+TEST_F(FAPIWrapperTest, WorkerFarmShutdownTimeout) {
+	HangingWorkerLauncher launcher;
+	WorkerFarm farm(launcher, 2, 3, std::chrono::milliseconds(50));
+	auto started = std::chrono::steady_clock::now();
+	auto results = farm.run({ "a", "b", "c" });
+
+	ASSERT_TRUE(std::all_of(results.begin(), results.end(), [](const FarmResult & _result) { return _result.success; }));
+	ASSERT_LT(std::chrono::steady_clock::now() - started, std::chrono::seconds(5));
+}
+
+TEST_F(FAPIWrapperTest, ModulePathResolverLookup) {
+	std::string directory = testDirectory();
+	std::ofstream{ directory + "/Resolver_Test.fmb" };
+	ModulePathResolver resolver{ std::make_unique<ListPathSource>(std::vector<std::string>{ directory }) };
+	std::string filepath;
+
+	ASSERT_TRUE(resolver.tryResolve("RESOLVER_TEST.FMB", filepath));
+	ASSERT_TRUE(fileExists(filepath));
+	ASSERT_FALSE(resolver.tryResolve("RESOLVER_TEST.PLL", filepath));
+	ASSERT_THROW(resolver.resolve("RESOLVER_MISSING.FMB"), FAPIException);
+
+	std::remove((directory + "/Resolver_Test.fmb").c_str());
+}
+
+TEST_F(FAPIWrapperTest, ChangesetSerialisation) {
+	std::string text = "CPPFAPICHANGESET\t1\nC\t11\tBLOCK.ITEM\t343\tbegin\\n  null;\\nend;\tx\\ty\n";
+	Changeset changeset;
+	changeset.deserialise(text);
+
+	ASSERT_EQ(changeset.size(), 1u);
+	ASSERT_EQ(changeset.getChanges()[0].fullname, "BLOCK.ITEM");
+	ASSERT_EQ(changeset.getChanges()[0].old_value, "begin\n  null;\nend;");
+	ASSERT_EQ(changeset.getChanges()[0].new_value, "x\ty");
+	ASSERT_EQ(changeset.serialise(), text);
+	ASSERT_THROW(changeset.deserialise("CPPFAPICHANGESET\t1\nC\tbad\n"), FAPIException);
+}
+
+TEST_F(FAPIWrapperTest, ChangesetRollbackUnchecked) {
+	std::string directory = testDirectory();
+	std::string filepath = directory + "/Changeset_Test.fmb";
+	std::string snapshot_path = ModuleSnapshot::snapshotPath(directory, filepath);
+	std::ofstream{ filepath } << "form";
+	writeSnapshot(snapshot_path, filepath, D2FFO_FORM_MODULE, D2FS_SUCCESS);
+
+	FAPIContext ctx;
+	ctx.setSnapshotDirectory(directory);
+	ctx.loadModule(filepath);
+	auto module = ctx.getModule(filepath);
+
+	ASSERT_TRUE(isRestored(module));
+
+	auto & name = module->getRoot()->getProperties().at(D2FP_NAME);
+	Changeset changeset;
+	changeset.set(module->getRoot(), D2FP_NAME, "CHANGED");
+	changeset.set(module->getRoot(), D2FP_NAME, "CHANGED_TWICE");
+	// value changed after recording, so recorded old value is stale
+	name->setValue("EDITED");
+	changeset.commit(module, false);
+
+	ASSERT_EQ(name->getValue(), "CHANGED_TWICE");
+
+	changeset.rollback();
+
+	ASSERT_EQ(name->getValue(), "EDITED");
+	ASSERT_FALSE(changeset.isCommitted());
+
+	ctx.removeModule(filepath);
+	std::remove(snapshot_path.c_str());
+	std::remove(filepath.c_str());
+}
+
+TEST_F(FAPIWrapperTest, SaveAfterCompile) {
+	std::string directory = testDirectory();
+	std::string filepath = directory + "/Compile_Test.fmb";
+	std::string snapshot_path = ModuleSnapshot::snapshotPath(directory, filepath);
+	std::ofstream{ filepath } << "form";
+	writeSnapshot(snapshot_path, filepath, D2FFO_FORM_MODULE, D2FS_SUCCESS);
+
+	FAPIContext ctx;
+	ctx.setSnapshotDirectory(directory);
+	ctx.loadModule(filepath);
+	auto module = ctx.getModule(filepath);
+
+	ASSERT_TRUE(isRestored(module));
+	ASSERT_FALSE(module->isModified());
+
+	// compilation applies marked properties, they still have to be saved
+	module->getRoot()->getProperties().at(D2FP_NAME)->setValue("COMPILED");
+	module->compileModule();
+
+	ASSERT_TRUE(module->isModified());
+	ASSERT_TRUE(module->saveModule());
+	ASSERT_FALSE(module->isModified());
+	ASSERT_FALSE(module->saveModule());
+
+	ctx.removeModule(filepath);
+	std::remove(snapshot_path.c_str());
+	std::remove(filepath.c_str());
+}
+
+TEST_F(FAPIWrapperTest, ObjectReportContent) {
+	std::string directory = testDirectory();
+	std::string filepath = directory + "/REPORT_TEST.fmb";
+	std::string snapshot_path = ModuleSnapshot::snapshotPath(directory, filepath);
+	std::string report_path = objectReportPath(filepath);
+	std::ofstream{ filepath } << "form";
+	writeSnapshot(snapshot_path, filepath, D2FFO_FORM_MODULE, D2FS_SUCCESS, {
+		{ D2FFO_PROG_UNIT, "LOG_IT", "procedure log_it is\r\nbegin\n  null;\nend;" },
+		{ D2FFO_TRIGGER, "WHEN-NEW-FORM-INSTANCE", "log_it;" } });
+
+	FAPIContext ctx;
+	ctx.setSnapshotDirectory(directory);
+	ctx.loadModule(filepath);
+
+	ASSERT_TRUE(isRestored(ctx.getModule(filepath)));
+	ASSERT_EQ(report_path, directory + "/REPORT_TEST.txt");
+
+	writeObjectReportFile(*ctx.getModule(filepath), report_path);
+	std::ifstream file{ report_path, std::ios::binary };
+	std::string report{ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} };
+	file.close();
+
+	// labels are padded to 40 columns, code lines continue under the first one
+	std::string continuation(48, ' ');
+	std::string expected = "Object report: " + filepath + "\n\n"
+		"* FORM_MODULE" + std::string(29, ' ') + "REPORT_TEST\n"
+		"   - Name" + std::string(36, ' ') + "REPORT_TEST\n"
+		"   * PROG_UNIT" + std::string(31, ' ') + "LOG_IT\n"
+		"      - Name" + std::string(36, ' ') + "LOG_IT\n"
+		"      - Program Unit Text" + std::string(23, ' ') + "procedure log_it is\n" + continuation + "begin\n" + continuation + "  null;\n" + continuation + "end;\n"
+		"   * TRIGGER" + std::string(33, ' ') + "WHEN-NEW-FORM-INSTANCE\n"
+		"      - Name" + std::string(36, ' ') + "WHEN-NEW-FORM-INSTANCE\n"
+		"      - Trigger Text" + std::string(28, ' ') + "log_it;\n"
+		"\n";
+
+	ASSERT_EQ(report, expected);
+
+	ctx.removeModule(filepath);
+	std::remove(report_path.c_str());
+	std::remove(snapshot_path.c_str());
+	std::remove(filepath.c_str());
+}
+
+TEST_F(FAPIWrapperTest, BuildJournalResume) {
+	std::string filepath = testDirectory() + "/Build_Test.journal";
+	std::remove(filepath.c_str());
+
+	{
+		BuildJournal journal{ filepath };
+		journal.recordModule("A.fmb", JournalModule{ FileFingerprint{ 10, 20, 30 }, { "F:B", "L:LIB" } });
+		journal.recordOutput("A.fmb", JournalOutput{ 40, FileFingerprint{ 50, 60, 0 } });
+		journal.recordOutput("B.fmb", JournalOutput{ 70, FileFingerprint{ 80, 90, 0 } });
+		journal.forgetOutput("B.fmb");
+	}
+
+	// records written before interruption are loaded without compaction
+	BuildJournal journal{ filepath };
+	JournalModule module;
+	JournalOutput output;
+
+	ASSERT_TRUE(journal.findModule("A.fmb", module));
+	ASSERT_EQ(module.fingerprint.hash, 30u);
+	ASSERT_EQ(module.dependencies, (std::vector<std::string>{ "F:B", "L:LIB" }));
+	ASSERT_TRUE(journal.findOutput("A.fmb", output));
+	ASSERT_EQ(output.key, 40u);
+	ASSERT_FALSE(journal.findOutput("B.fmb", output));
+	ASSERT_EQ(FmxBuilder::fmxPath("C:\\FORMS\\A.FMB"), "C:\\FORMS\\A.FMX");
+
+	journal.compact();
+	std::remove(filepath.c_str());
+}
+
+TEST_F(FAPIWrapperTest, FmxBuilderWaves) {
+	std::string directory = testDirectory() + "/FmxBuild";
+	std::string other_directory = directory + "/other";
+	std::filesystem::remove_all(directory);
+	std::filesystem::create_directories(other_directory);
+	std::string journal_path = directory + "/build.journal";
+	std::string form = directory + "/FORM.fmb", source = directory + "/SOURCE.fmb", single = directory + "/SINGLE.fmb";
+	std::string other_single = other_directory + "/SINGLE.fmb", lib = directory + "/LIB.pll", nested_lib = directory + "/NESTED.pll";
+
+	for (const auto & path : { form, source, single, other_single, lib, nested_lib })
+		std::ofstream{ path } << path;
+
+	getModulePathResolver().setPathSource(std::make_unique<ListPathSource>(std::vector<std::string>{ directory }));
+	FAPIContext ctx;
+	std::mutex generated_mutex;
+	std::vector<std::string> generated;
+	std::string broken;
+	ThreadWorkerLauncher launcher([&](const std::string & _path) {
+		if (_path == broken)
+			throw std::runtime_error("broken");
+
+		std::ofstream{ FmxBuilder::fmxPath(_path) } << "fmx";
+		std::lock_guard<std::mutex> lock{ generated_mutex };
+		generated.emplace_back(_path);
+
+		return std::string{};
+	});
+
+	{
+		FmxBuilder builder{ ctx, launcher, 2, journal_path };
+		// dependencies are known from journal, so modules aren't loaded
+		auto record = [&](const std::string & _path, const std::vector<std::string> & _dependencies) {
+			builder.getJournal().recordModule(_path, JournalModule{ fileFingerprint(_path), _dependencies });
+		};
+		record(form, { "F:SOURCE", "L:LIB" });
+		record(source, {});
+		record(single, {});
+		record(other_single, {});
+		record(lib, { "L:NESTED" });
+		record(nested_lib, {});
+
+		// forms of the same name in different directories are separate modules
+		auto results = builder.build({ form, source, single, other_single });
+
+		ASSERT_TRUE(std::all_of(results.begin(), results.end(), [](const FmxBuildResult & _result) { return _result.status == FmxBuildStatus::GENERATED; }));
+		ASSERT_EQ(generated.size(), 4u);
+		ASSERT_LT(std::find(generated.begin(), generated.end(), source), std::find(generated.begin(), generated.end(), form));
+
+		results = builder.build({ form, source, single, other_single });
+
+		ASSERT_TRUE(std::all_of(results.begin(), results.end(), [](const FmxBuildResult & _result) { return _result.status == FmxBuildStatus::UP_TO_DATE; }));
+		ASSERT_EQ(generated.size(), 4u);
+
+		// library attached to a library is an input of the form too
+		std::ofstream{ nested_lib, std::ios::app } << " changed";
+		record(nested_lib, {});
+		generated.clear();
+		results = builder.build({ form, source, single, other_single });
+
+		ASSERT_EQ(generated, std::vector<std::string>{ form });
+		ASSERT_EQ(results[0].status, FmxBuildStatus::GENERATED);
+		ASSERT_EQ(results[1].status, FmxBuildStatus::UP_TO_DATE);
+
+		// failed source module skips forms inheriting from it
+		broken = source;
+		generated.clear();
+		results = builder.build({ form, source, single, other_single }, nullptr, true);
+
+		ASSERT_EQ(results[1].status, FmxBuildStatus::FAILED);
+		ASSERT_EQ(results[1].message, "broken");
+		ASSERT_EQ(results[0].status, FmxBuildStatus::SKIPPED);
+		ASSERT_EQ(results[0].message, source);
+		ASSERT_EQ(results[2].status, FmxBuildStatus::GENERATED);
+		ASSERT_EQ(results[3].status, FmxBuildStatus::GENERATED);
+	}
+
+	getModulePathResolver().setPathSource(nullptr);
+	std::filesystem::remove_all(directory);
+}
+
+TEST_F(FAPIWrapperTest, GlobalScannerReferences) {
+	auto references = scanGlobals("begin\n  :global.a := 1; -- :GLOBAL.COMMENTED\n  /* :global.commented */ x := ':GLOBAL.TEXT ' || name_in('Global.B');\n  :GLOBAL.A := :Global.C;\nend;");
+
+	ASSERT_EQ(references.size(), 4u);
+	ASSERT_EQ(references[0].name, "A");
+	ASSERT_EQ(references[0].line, 2u);
+	ASSERT_EQ(references[0].column, 3u);
+	ASSERT_EQ(references[1].name, "B");
+	ASSERT_TRUE(references[1].quoted);
+	ASSERT_EQ(references[2].name, "A");
+	ASSERT_EQ(references[3].name, "C");
+	ASSERT_EQ(references[3].line, 4u);
+	ASSERT_EQ(references[3].column, 16u);
+}
+
+TEST_F(FAPIWrapperTest, CodeIndexSearch) {
+	std::string filepath = testDirectory() + "/Index_Test.idx";
+	std::ofstream{ filepath, std::ios::binary } << "CPPFAPICODEINDEX\t1\n"
+		<< "M\tA.fmb\t10\t20\t30\n"
+		<< "U\t" << D2FFO_TRIGGER << "\tBLOCK.WHEN-NEW-RECORD-INSTANCE\tbegin\\n  go_block('B');\\r\\n  x := 1;\\nend;\n"
+		<< "M\tB.pll\t40\t50\t60\n"
+		<< "U\t" << D2FFO_LIB_PROG_UNIT << "\tPKG\tpackage body pkg is\\n  procedure go_block;\\nend;\\n\n";
+
+	CodeIndex index;
+	index.load(filepath);
+
+	ASSERT_EQ(index.getModuleCount(), 2u);
+	ASSERT_EQ(index.getUnitCount(), 2u);
+
+	auto hits = index.find("GO_BLOCK");
+
+	ASSERT_EQ(hits.size(), 2u);
+	ASSERT_EQ(hits[0].module, "A.fmb");
+	ASSERT_EQ(hits[0].line, 2u);
+	ASSERT_EQ(hits[0].text, "  go_block('B');");
+	ASSERT_EQ(hits[1].object, "PKG");
+
+	// anchors match at line boundaries, not only at boundaries of unit
+	hits = index.findRegex("^end;$");
+
+	ASSERT_EQ(hits.size(), 2u);
+	ASSERT_EQ(hits[0].line, 4u);
+	ASSERT_EQ(hits[1].line, 3u);
+	ASSERT_EQ(index.findRegex("go_block\\('B'\\);$").size(), 1u);
+	ASSERT_TRUE(index.findRegex("^$").empty());
+	// characters of escaped code don't narrow candidates
+	ASSERT_EQ(index.findRegex("go_\\x62lock").size(), 2u);
+	ASSERT_EQ(index.findRegex("go_\\u0062lock").size(), 2u);
+
+	index.save(filepath);
+	CodeIndex loaded;
+	loaded.load(filepath);
+
+	ASSERT_EQ(loaded.getUnitCount(), 2u);
+	ASSERT_EQ(loaded.find("x := 1").size(), 1u);
+
+	std::ofstream{ filepath, std::ios::app } << "U\tbad\n";
+
+	ASSERT_THROW(loaded.load(filepath), FAPIException);
+	ASSERT_EQ(loaded.getUnitCount(), 2u);
+
+	std::remove(filepath.c_str());
+}
+
+TEST_F(FAPIWrapperTest, PlsqlTokenizer) {
+	std::string code = "IF :blk.item >= 1.5 then -- comment\n  x := 'it''s' || \"Name\"; /* :skipped */ FOR i IN 1..10 LOOP null; END LOOP;";
+	auto tokens = tokenizePlsql(code);
+	auto & table = getIdentifierTable();
+
+	ASSERT_EQ(tokens.size(), 23u);
+	ASSERT_EQ(tokens[0].kind, PlsqlTokenKind::KEYWORD);
+	ASSERT_EQ(tokens[1].kind, PlsqlTokenKind::BIND);
+	ASSERT_EQ(table.getName(tokens[1].id), "BLK.ITEM");
+	ASSERT_EQ(table.getName(tokens[2].id), ">=");
+	ASSERT_EQ(code.substr(tokens[3].offset, tokens[3].length), "1.5");
+	ASSERT_EQ(tokens[5].kind, PlsqlTokenKind::IDENTIFIER);
+	ASSERT_EQ(code.substr(tokens[7].offset, tokens[7].length), "'it''s'");
+	ASSERT_EQ(tokens[9].kind, PlsqlTokenKind::IDENTIFIER);
+	ASSERT_EQ(table.getName(tokens[9].id), "Name");
+	ASSERT_EQ(tokens[15].kind, PlsqlTokenKind::SYMBOL);
+	ASSERT_EQ(table.getName(tokens[15].id), "..");
+	ASSERT_EQ(tokens[5].id, table.find("X"));
+}
+
+TEST_F(FAPIWrapperTest, ModuleSnapshotRoundTrip) {
+	std::string directory = testDirectory();
+	std::string filepath = directory + "/Snapshot_Test.fmb";
+	std::string snapshot_path = ModuleSnapshot::snapshotPath(directory, filepath);
+	std::ofstream{ filepath } << "form";
+	writeSnapshot(snapshot_path, filepath, D2FFO_FORM_MODULE, D2FS_MISSINGLIBMOD);
+
+	FAPIContext ctx;
+	ctx.setSnapshotDirectory(directory);
+
+	// restored module is accepted by ignore parameters as if it was loaded by OracleForms
+	ASSERT_THROW(ctx.loadModule(filepath), FAPIException);
+	ctx.loadModule(filepath, true);
+	auto module = ctx.getModule(filepath);
+
+	ASSERT_TRUE(module->isTraversed());
+	ASSERT_FALSE(module->isNative());
+	ASSERT_EQ(module->getRoot()->getName(), moduleNameFromPath(filepath));
+	ASSERT_EQ(module->getLoadStatus(), D2FS_MISSINGLIBMOD);
+
+	ModuleSnapshot::save(*module, snapshot_path);
+	FAPIForm restored{ &ctx, nullptr, filepath };
+
+	ASSERT_TRUE(ModuleSnapshot::load(restored, snapshot_path));
+	ASSERT_EQ(restored.getLoadStatus(), D2FS_MISSINGLIBMOD);
+
+	std::ofstream{ filepath, std::ios::app } << " changed";
+	FAPIForm changed{ &ctx, nullptr, filepath };
+
+	ASSERT_FALSE(ModuleSnapshot::load(changed, snapshot_path));
+
+	ctx.removeModule(filepath);
+	std::remove(snapshot_path.c_str());
+	std::remove(filepath.c_str());
+}
+
+TEST_F(FAPIWrapperTest, ModuleSnapshotBindMismatch) {
+	std::string directory = testDirectory();
+	std::string filepath = directory + "/Mismatch_Test.fmb";
+	std::string snapshot_path = ModuleSnapshot::snapshotPath(directory, filepath);
+	std::ofstream{ filepath } << "form";
+	writeSnapshot(snapshot_path, filepath, D2FFO_FORM_MODULE, D2FS_SUCCESS, { { D2FFO_PROG_UNIT, "MISSING", "procedure missing is begin null; end;" } });
+
+	FAPIContext ctx;
+	ctx.setSnapshotDirectory(directory);
+	ctx.loadModule(filepath);
+	auto module = ctx.getModule(filepath);
+
+	ASSERT_TRUE(isRestored(module));
+
+	// restored program unit has no OracleForms counterpart, so it can't be bound
+	ASSERT_THROW(module->attachNative(), FAPIException);
+	ASSERT_TRUE(isRestored(module));
+
+	ctx.removeModule(filepath);
+	std::remove(snapshot_path.c_str());
+	std::remove(filepath.c_str());
+}
+
+TEST_F(FAPIWrapperTest, InheritanceCacheAfterSave) {
+	std::string directory = testDirectory();
+	std::string filepath = directory + "/Inheritance_Test.fmb";
+	std::string cache_path = directory + "/Inheritance_Test.cache";
+	std::string snapshot_path = ModuleSnapshot::snapshotPath(directory, filepath);
+	std::ofstream{ filepath } << "form";
+	writeSnapshot(snapshot_path, filepath, D2FFO_FORM_MODULE, D2FS_SUCCESS);
+
+	FAPIContext ctx;
+	ctx.setSnapshotDirectory(directory);
+	ctx.loadModule(filepath);
+	auto module = ctx.getModule(filepath);
+
+	ASSERT_TRUE(isRestored(module));
+
+	InheritanceCache cache;
+	module->checkOverriden(cache);
+	cache.getModule(filepath).objects["33:BLOCK.TRIGGER"] = ObjectCheck{ {}, { { D2FP_TRG_TXT, PropState::INHERITED }, { D2FP_NAME, PropState::OVERRIDEN } } };
+
+	ASSERT_TRUE(cache.isValid(filepath));
+
+	// saving module with restored inheritance changes its file
+	std::ofstream{ filepath, std::ios::app } << " saved";
+	ASSERT_FALSE(cache.isValid(filepath));
+
+	cache.refreshModule(filepath);
+	cache.save(cache_path);
+	InheritanceCache loaded;
+	loaded.load(cache_path);
+
+	ASSERT_TRUE(loaded.isValid(filepath));
+	ASSERT_EQ(loaded.getModule(filepath).objects["33:BLOCK.TRIGGER"].results, (std::vector<std::pair<int, PropState>>{ { D2FP_NAME, PropState::OVERRIDEN } }));
+
+	ctx.removeModule(filepath);
+	std::remove(cache_path.c_str());
+	std::remove(snapshot_path.c_str());
+	std::remove(filepath.c_str());
+}
+
+TEST_F(FAPIWrapperTest, LibrarySharing) {
+	std::string directory = testDirectory();
+	std::string filepath = directory + "/Shared_Test.pll";
+	std::string snapshot_path = ModuleSnapshot::snapshotPath(directory, filepath);
+	std::ofstream{ filepath } << "library";
+	writeSnapshot(snapshot_path, filepath, D2FFO_LIBRARY_MODULE, D2FS_SUCCESS);
+
+	FAPIContext ctx;
+	ctx.setSnapshotDirectory(directory);
+	auto library = ctx.acquireLibrary(filepath);
+
+	ASSERT_TRUE(isRestored(library));
+	ASSERT_EQ(ctx.acquireLibrary(filepath), library);
+	ASSERT_EQ(ctx.getLibraryReferences(filepath), 2u);
+
+	// removal of shared library waits for its last release
+	ctx.removeLibrary(filepath);
+	ctx.releaseLibrary(filepath);
+	ASSERT_TRUE(ctx.hasLibrary(filepath));
+	ctx.releaseLibrary(filepath);
+	ASSERT_FALSE(ctx.hasLibrary(filepath));
+
+	// library loaded before it was acquired stays loaded
+	ctx.loadLibrary(filepath);
+	ctx.acquireLibrary(filepath);
+	ctx.releaseLibrary(filepath);
+	ASSERT_TRUE(ctx.hasLibrary(filepath));
+	ASSERT_EQ(ctx.getLibraryReferences(filepath), 0u);
+
+	ctx.acquireLibrary(filepath);
+	ctx.reset();
+	ASSERT_FALSE(ctx.hasLibrary(filepath));
+	ASSERT_EQ(ctx.getLibraryReferences(filepath), 0u);
+
+	std::remove(snapshot_path.c_str());
+	std::remove(filepath.c_str());
+}
+
+TEST_F(FAPIWrapperTest, CloneDetectorFragments) {
+	std::string directory = testDirectory();
+	std::string filepath = directory + "/Clone_Test.fmb";
+	std::ofstream{ filepath } << "form";
+
+	// X is common to all units, X followed by Y only to A and B, every token on its own line
+	std::string x = "x1\nx2\nx3\nx4\nx5";
+	std::string y = "y1\ny2\ny3\ny4\ny5\ny6";
+	writeSnapshot(ModuleSnapshot::snapshotPath(directory, filepath), filepath, D2FFO_FORM_MODULE, D2FS_SUCCESS, {
+		{ D2FFO_PROG_UNIT, "A", "a0\n" + x + "\n" + y },
+		{ D2FFO_PROG_UNIT, "B", "b0\n" + x + "\n" + y + "\nb1" },
+		{ D2FFO_PROG_UNIT, "C", "c0\n" + x + "\nc1" } });
+
+	FAPIContext ctx;
+	ctx.setSnapshotDirectory(directory);
+	ctx.loadModule(filepath);
+
+	ASSERT_TRUE(isRestored(ctx.getModule(filepath)));
+
+	CloneDetector detector{ 3 };
+	detector.addModule(*ctx.getModule(filepath));
+	auto clusters = detector.findClones();
+
+	ASSERT_EQ(detector.getUnitCount(), 3u);
+	ASSERT_EQ(clusters.size(), 2u);
+	ASSERT_FALSE(clusters[0].whole_unit);
+	ASSERT_EQ(clusters[0].tokens, 11u);
+	ASSERT_EQ(clusters[0].locations.size(), 2u);
+	ASSERT_EQ(clusters[0].locations[0].object, "A");
+	ASSERT_EQ(clusters[0].locations[0].first_line, 2u);
+	ASSERT_EQ(clusters[0].locations[0].last_line, 12u);
+	ASSERT_EQ(clusters[0].locations[1].object, "B");
+	ASSERT_EQ(clusters[1].tokens, 5u);
+	ASSERT_EQ(clusters[1].locations.size(), 3u);
+	ASSERT_EQ(clusters[1].locations[2].object, "C");
+	ASSERT_EQ(clusters[1].locations[2].last_line, 6u);
+
+	ctx.reset();
+	std::remove(ModuleSnapshot::snapshotPath(directory, filepath).c_str());
+	std::remove(filepath.c_str());
+}
+
+TEST_F(FAPIWrapperTest, CallGraphCallers) {
+	std::string directory = testDirectory();
+	std::string form_path = directory + "/Graph_Form.fmb";
+	std::string other_path = directory + "/Graph_Other.fmb";
+	std::string library_path = directory + "/Graph_Lib.pll";
+	std::ofstream{ form_path } << "form";
+	std::ofstream{ other_path } << "other form";
+	std::ofstream{ library_path } << "library";
+	writeSnapshot(ModuleSnapshot::snapshotPath(directory, form_path), form_path, D2FFO_FORM_MODULE, D2FS_SUCCESS, {
+		{ D2FFO_TRIGGER, "WHEN-BUTTON-PRESSED", "begin\n  pkg.run;\n  helper;\nend;" },
+		{ D2FFO_PROG_UNIT, "HELPER", "procedure helper is\nbegin\n  null;\nend helper;" } });
+	writeSnapshot(ModuleSnapshot::snapshotPath(directory, other_path), other_path, D2FFO_FORM_MODULE, D2FS_SUCCESS, {
+		{ D2FFO_TRIGGER, "WHEN-NEW-FORM-INSTANCE", "begin\n  Pkg.Spare;\nend;" } });
+	writeSnapshot(ModuleSnapshot::snapshotPath(directory, library_path), library_path, D2FFO_LIBRARY_MODULE, D2FS_SUCCESS, {
+		{ D2FFO_LIB_PROG_UNIT, "PKG", "package body pkg is\n  procedure run is begin log_it; end;\n  procedure other is\n    procedure nested is begin null; end;\n  begin\n    if true then run; end if;\n    nested;\n  end other;\n  procedure spare is begin null; end spare;\nend pkg;" },
+		{ D2FFO_LIB_PROG_UNIT, "LOG_IT", "procedure log_it is\nbegin\n  null;\nend log_it;" } });
+
+	FAPIContext ctx;
+	ctx.setSnapshotDirectory(directory);
+	ctx.loadModule(form_path);
+	ctx.loadModule(other_path);
+	ctx.loadLibrary(library_path);
+
+	ASSERT_TRUE(isRestored(ctx.getModule(form_path)));
+	ASSERT_TRUE(isRestored(ctx.getModule(other_path)));
+	ASSERT_TRUE(isRestored(ctx.getLibrary(library_path)));
+
+	CallGraph graph;
+
+	ASSERT_EQ(graph.update(ctx), 3u);
+	ASSERT_EQ(graph.getUnitCount(), 5u);
+	ASSERT_EQ(graph.getCallees(form_path, "WHEN-BUTTON-PRESSED"), (std::vector<std::string>{ "HELPER", "PKG.RUN" }));
+	ASSERT_EQ(graph.getCallees(library_path, "PKG"), (std::vector<std::string>{ "LOG_IT", "PKG.RUN" }));
+	ASSERT_EQ(graph.getCallers("pkg.run").size(), 2u);
+	ASSERT_EQ(graph.getCallers("pkg").size(), 2u);
+	ASSERT_EQ(graph.getDefinitions("helper")[0].module, form_path);
+	ASSERT_TRUE(graph.getCallers("NOT_CALLED_ANYWHERE").empty());
+
+	// search continues from subprogram calling LOG_IT and subprograms calling it, not from other subprograms
+	auto callers = graph.getCallers("LOG_IT", true);
+
+	ASSERT_EQ(callers.size(), 2u);
+	ASSERT_EQ(callers[0].object, "WHEN-BUTTON-PRESSED");
+	ASSERT_EQ(callers[1].object, "PKG");
+	ASSERT_TRUE(graph.getCallers("PKG.OTHER", true).empty());
+	ASSERT_EQ(graph.getCallers("PKG.SPARE", true)[0].object, "WHEN-NEW-FORM-INSTANCE");
+
+	// removal of most units compacts graph, ids of kept units are remapped
+	graph.removeModule(other_path);
+	graph.removeModule(form_path);
+
+	ASSERT_EQ(graph.getUnitCount(), 2u);
+	ASSERT_EQ(graph.getCallers("LOG_IT", true).size(), 1u);
+	ASSERT_EQ(graph.getDefinitions("PKG")[0].object, "PKG");
+	ASSERT_TRUE(graph.getDefinitions("HELPER").empty());
+
+	graph.updateModule(*ctx.getModule(form_path));
+	callers = graph.getCallers("PKG.RUN");
+
+	ASSERT_EQ(graph.getModuleCount(), 2u);
+	ASSERT_EQ(callers.size(), 2u);
+	ASSERT_EQ(callers[0].module, form_path);
+	ASSERT_EQ(graph.getCallers("HELPER")[0].object, "WHEN-BUTTON-PRESSED");
+
+	ctx.reset();
+
+	for (const auto & filepath : { form_path, other_path, library_path }) {
+		std::remove(ModuleSnapshot::snapshotPath(directory, filepath).c_str());
+		std::remove(filepath.c_str());
+	}
+}